@@ -0,0 +1,338 @@
+/*
+ * AllocationTracker.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#include "AllocationTracker.h"
+#include "LuaAllocator.h"
+#include "lua.h"
+#include <cstdlib>
+#include <new>
+#ifdef __APPLE__
+	#include <malloc/malloc.h>
+#else
+	#include <malloc.h>
+#endif
+#ifdef _MSC_VER
+#include <ciso646>   // Visual Studio is not C++ standards complaint...
+#endif
+
+#ifdef _MSC_VER
+	#define FF_THREAD_LOCAL __declspec(thread)
+#else
+	#define FF_THREAD_LOCAL __thread
+#endif
+
+AllocationTracker::Totals AllocationTracker::frame_start;
+AllocationTracker::Totals AllocationTracker::phase_start;
+AllocationTracker::Totals AllocationTracker::sdl_frame_start;
+AllocationTracker::Totals AllocationTracker::frame;
+AllocationTracker::Totals AllocationTracker::sdl_frame;
+AllocationTracker::Totals AllocationTracker::phases[AllocationTracker::phase_count];
+size_t AllocationTracker::texture_bytes = 0;
+
+namespace {
+
+	// This is all plain data, because it's used from operator new - possibly
+	// before any constructors have run. Slots are never given back; a thread
+	// that finishes leaves its counts behind, which keeps the totals right.
+	struct alignas(64) Slot		// a cache line each, so threads don't share one
+	{
+		Uint64 allocations;
+		Uint64 frees;
+		Uint64 bytes_allocated;
+		Uint64 bytes_freed;
+		Uint64 sdl_allocations;
+		Uint64 sdl_frees;
+		Uint64 sdl_bytes_allocated;
+		Uint64 sdl_bytes_freed;
+	};
+	const int max_slots = 256;		// more threads than that share the last one
+	Slot slots[max_slots];
+	Slot* const shared_slot = &slots[max_slots - 1];
+	SDL_SpinLock shared_slot_lock = 0;	// only for shared_slot; the others have one writer
+	SDL_atomic_t slots_used;		// zero initialised
+	FF_THREAD_LOCAL Slot* my_slot = 0;
+
+	inline Slot* slot()
+	{
+		if(my_slot == 0)
+		{
+			int index = SDL_AtomicAdd(&slots_used, 1);
+			my_slot = &slots[index < max_slots ? index : max_slots - 1];
+		}
+		return my_slot;
+	}
+
+	inline size_t block_size(void* p)
+	{
+#if defined(__APPLE__)
+		return malloc_size(p);
+#elif defined(_WIN32)
+		return _msize(p);
+#else
+		return malloc_usable_size(p);
+#endif
+	}
+
+	inline void count(Uint64 Slot::* counter, Uint64 Slot::* bytes, void* p)
+	{
+		Slot* s = slot();
+		size_t size = block_size(p);
+		if(s == shared_slot)
+		{
+			SDL_AtomicLock(&shared_slot_lock);
+			s->*counter += 1;
+			s->*bytes += size;
+			SDL_AtomicUnlock(&shared_slot_lock);
+		}
+		else
+		{
+			s->*counter += 1;
+			s->*bytes += size;
+		}
+	}
+
+	int slot_count()
+	{
+		int used = SDL_AtomicGet(&slots_used);
+		return used < max_slots ? used : max_slots;
+	}
+
+	void push_totals(lua_State* L, const AllocationTracker::Totals& t, const char* name)
+	{
+		lua_createtable(L, 0, 4);
+		lua_pushnumber(L, static_cast<lua_Number>(t.allocations)); lua_setfield(L, -2, "allocations");
+		lua_pushnumber(L, static_cast<lua_Number>(t.frees)); lua_setfield(L, -2, "frees");
+		lua_pushnumber(L, static_cast<lua_Number>(t.bytes_allocated)); lua_setfield(L, -2, "bytes");
+		lua_pushnumber(L, static_cast<lua_Number>(t.bytes_freed)); lua_setfield(L, -2, "bytes_freed");
+		lua_setfield(L, -2, name);
+	}
+
+	AllocationTracker::Totals difference(const AllocationTracker::Totals& now, const AllocationTracker::Totals& then)
+	{
+		AllocationTracker::Totals d;
+		d.allocations = now.allocations - then.allocations;
+		d.frees = now.frees - then.frees;
+		d.bytes_allocated = now.bytes_allocated - then.bytes_allocated;
+		d.bytes_freed = now.bytes_freed - then.bytes_freed;
+		return d;
+	}
+
+#if FF_ALLOCATION_TRACKING && SDL_VERSION_ATLEAST(2,0,7)
+	void* SDLCALL counting_malloc(size_t size)
+	{
+		void* p = std::malloc(size);
+		if(p) AllocationTracker::count_sdl_allocation(p);
+		return p;
+	}
+	void* SDLCALL counting_calloc(size_t n, size_t size)
+	{
+		void* p = std::calloc(n, size);
+		if(p) AllocationTracker::count_sdl_allocation(p);
+		return p;
+	}
+	void* SDLCALL counting_realloc(void* old, size_t size)
+	{
+		if(old) AllocationTracker::count_sdl_free(old);
+		void* p = std::realloc(old, size);
+		if(p) AllocationTracker::count_sdl_allocation(p);
+		else if(old and size) AllocationTracker::count_sdl_allocation(old);	// failed, old still there
+		return p;
+	}
+	void SDLCALL counting_free(void* p)
+	{
+		if(p) AllocationTracker::count_sdl_free(p);
+		std::free(p);
+	}
+#endif
+}
+
+bool AllocationTracker::active()
+{
+	return FF_ALLOCATION_TRACKING;
+}
+
+void AllocationTracker::install_sdl()
+{
+#if FF_ALLOCATION_TRACKING && SDL_VERSION_ATLEAST(2,0,7)
+	SDL_SetMemoryFunctions(counting_malloc, counting_calloc, counting_realloc, counting_free);
+#endif
+}
+
+void AllocationTracker::count_allocation(void* p)
+{
+	count(&Slot::allocations, &Slot::bytes_allocated, p);
+}
+
+void AllocationTracker::count_free(void* p)
+{
+	count(&Slot::frees, &Slot::bytes_freed, p);
+}
+
+void AllocationTracker::count_sdl_allocation(void* p)
+{
+	count(&Slot::sdl_allocations, &Slot::sdl_bytes_allocated, p);
+}
+
+void AllocationTracker::count_sdl_free(void* p)
+{
+	count(&Slot::sdl_frees, &Slot::sdl_bytes_freed, p);
+}
+
+AllocationTracker::Totals AllocationTracker::totals()
+{
+	Totals t;
+	int n = slot_count();
+	for(int i = 0; i < n; i++)
+	{
+		t.allocations += slots[i].allocations;
+		t.frees += slots[i].frees;
+		t.bytes_allocated += slots[i].bytes_allocated;
+		t.bytes_freed += slots[i].bytes_freed;
+	}
+	return t;
+}
+
+AllocationTracker::Totals AllocationTracker::sdl_totals()
+{
+	Totals t;
+	int n = slot_count();
+	for(int i = 0; i < n; i++)
+	{
+		t.allocations += slots[i].sdl_allocations;
+		t.frees += slots[i].sdl_frees;
+		t.bytes_allocated += slots[i].sdl_bytes_allocated;
+		t.bytes_freed += slots[i].sdl_bytes_freed;
+	}
+	return t;
+}
+
+void AllocationTracker::phase_done(Phase p)
+{
+	Totals now = totals();
+	phases[p] = difference(now, phase_start);
+	phase_start = now;
+}
+
+void AllocationTracker::frame_done()
+{
+	phase_done(limiter);
+	frame = difference(phase_start, frame_start);
+	frame_start = phase_start;
+
+	Totals sdl_now = sdl_totals();
+	sdl_frame = difference(sdl_now, sdl_frame_start);
+	sdl_frame_start = sdl_now;
+}
+
+int AllocationTracker::stats(lua_State* L)
+{
+	Totals t = totals();
+	lua_createtable(L, 0, 16);
+	lua_pushboolean(L, active()); lua_setfield(L, -2, "active");
+	lua_pushnumber(L, static_cast<lua_Number>(t.allocations)); lua_setfield(L, -2, "allocations");
+	lua_pushnumber(L, static_cast<lua_Number>(t.frees)); lua_setfield(L, -2, "frees");
+	lua_pushnumber(L, static_cast<lua_Number>(t.bytes_allocated)); lua_setfield(L, -2, "bytes");
+	lua_pushnumber(L, static_cast<lua_Number>(t.bytes_allocated - t.bytes_freed)); lua_setfield(L, -2, "live_bytes");
+	push_totals(L, sdl_totals(), "sdl");
+
+	push_totals(L, frame, "frame");
+	push_totals(L, sdl_frame, "sdl_frame");
+	static const char* phase_names[phase_count] = { "events", "update", "draw", "present", "limiter" };
+	for(int i = 0; i < phase_count; i++)
+	{
+		push_totals(L, phases[i], phase_names[i]);
+	}
+
+	lua_pushnumber(L, static_cast<lua_Number>(texture_bytes)); lua_setfield(L, -2, "texture_bytes");
+
+	lua_newtable(L);
+	LuaAllocator::lock_list();
+	const std::vector<LuaAllocator*>& allocators = LuaAllocator::get_list();
+	for(size_t i = 0; i < allocators.size(); i++)
+	{
+		lua_pushnumber(L, static_cast<lua_Number>(allocators[i]->get_bytes()));
+		lua_setfield(L, -2, allocators[i]->get_name().c_str());
+	}
+	LuaAllocator::unlock_list();
+	lua_setfield(L, -2, "lua");
+	return 1;
+}
+
+
+//
+// The global allocation hooks
+//
+#if FF_ALLOCATION_TRACKING
+
+static void* counted_new(std::size_t size)
+{
+	if(size == 0) size = 1;
+	for(;;)
+	{
+		void* p = std::malloc(size);
+		if(p)
+		{
+			AllocationTracker::count_allocation(p);
+			return p;
+		}
+		std::new_handler handler = std::set_new_handler(0);		// some older libraries don't have get_new_handler
+		std::set_new_handler(handler);
+		if(handler == 0) throw std::bad_alloc();
+		handler();
+	}
+}
+
+static void counted_delete(void* p)
+{
+	if(p == 0) return;
+	AllocationTracker::count_free(p);
+	std::free(p);
+}
+
+void* operator new(std::size_t size) { return counted_new(size); }
+void* operator new[](std::size_t size) { return counted_new(size); }
+void operator delete(void* p) throw() { counted_delete(p); }
+void operator delete[](void* p) throw() { counted_delete(p); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) throw()
+{
+	try { return counted_new(size); }
+	catch(...) { return 0; }
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) throw()
+{
+	try { return counted_new(size); }
+	catch(...) { return 0; }
+}
+void operator delete(void* p, const std::nothrow_t&) throw() { counted_delete(p); }
+void operator delete[](void* p, const std::nothrow_t&) throw() { counted_delete(p); }
+
+#endif
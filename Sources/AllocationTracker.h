@@ -0,0 +1,108 @@
+/*
+ * AllocationTracker.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#ifndef ALLOCATION_TRACKER_H
+#define ALLOCATION_TRACKER_H
+
+#include "SDL.h"
+#include <cstddef>
+struct lua_State;
+
+// Counts heap allocations, to find churn.
+//
+// Build with FF_ALLOCATION_TRACKING=1 (it's off by default, as it costs
+// a little on every allocation) and the global operator new and delete are
+// replaced, and SDL is given counting memory functions (so surfaces etc.
+// show up too). Each thread counts into its own slot without
+// atomics, and totals() adds the slots up - so a total might be a count or
+// two behind another thread.
+//
+// Debug marks the main loop phases, which gives allocations per frame and
+// per phase (including anything other threads did at the same time).
+// Lua states have their own counts in LuaAllocator; texture memory comes from
+// MyGraphics::texture_bytes().
+//
+// From Lua:
+//		AllocationTracker.stats() -> { allocations, frees, bytes, live_bytes,
+//			sdl = {...}, frame = {...}, events = {...}, update = {...}, draw = {...},
+//			present = {...}, limiter = {...}, texture_bytes, lua = { [state name] = bytes } }
+#ifndef FF_ALLOCATION_TRACKING
+#define FF_ALLOCATION_TRACKING 0
+#endif
+
+class AllocationTracker
+{
+public:
+	struct Totals
+	{
+		Totals() : allocations(0), frees(0), bytes_allocated(0), bytes_freed(0) {}
+		Uint64 allocations;
+		Uint64 frees;
+		Uint64 bytes_allocated;
+		Uint64 bytes_freed;
+	};
+	enum Phase { events, update, draw, present, limiter, phase_count };
+
+	static bool active();			// was it compiled in?
+	static void install_sdl();		// before anything else in SDL, i.e. first thing in main()
+
+	static Totals totals();			// C++ new/delete
+	static Totals sdl_totals();		// SDL_malloc/SDL_free
+
+	// main loop bookkeeping (from Debug)
+	static void phase_done(Phase p);
+	static void frame_done();		// also ends the limiter phase
+	static const Totals& last_frame() { return frame; }
+	static const Totals& last_phase(Phase p) { return phases[p]; }
+	static const Totals& last_sdl_frame() { return sdl_frame; }
+
+	static void set_texture_bytes(size_t bytes) { texture_bytes = bytes; }
+	static size_t get_texture_bytes() { return texture_bytes; }
+
+	static int stats(lua_State* L);
+
+	// used by the allocation hooks
+	static void count_allocation(void* p);
+	static void count_free(void* p);
+	static void count_sdl_allocation(void* p);
+	static void count_sdl_free(void* p);
+
+private:
+	static Totals frame_start;
+	static Totals phase_start;
+	static Totals sdl_frame_start;
+	static Totals frame;
+	static Totals sdl_frame;
+	static Totals phases[phase_count];
+	static size_t texture_bytes;
+};
+
+#endif
@@ -36,6 +36,7 @@
 #include "SDL_rwops.h"
 
 #include "AppResourcePath.h"
+#include "AssetArchive.h"
 #include "Utilities.h"
 #include "GameConfig.h"
 
@@ -48,12 +49,28 @@
 // forward declarations
 void CopyFile(std::string file);
 void CopyDirectory(std::string directory);
+void ExtractDirectory(std::string directory);
 
 static AAssetManager* asset_man;
 
 void CheckAndroidInstallation()
 {
 
+	// A packed archive in the APK is read in one go and used from memory,
+	// rather than copying thousands of loose files out to internal storage.
+	// Only the C++ loaders know about archives though - scripts open maps
+	// and text with io.open, so those still have to be real files.
+	if(AssetArchive::mount_rw(SDL_RWFromFile(DATA_DIR "assets.ffpk", "rb"), DATA_DIR "assets.ffpk"))
+	{
+		Utilities::debugMessage("Using packed assets, extracting the files Lua reads directly...");
+		std::string out_path = std::string(SDL_AndroidGetInternalStoragePath())+"/arp";
+		mkdir(out_path.c_str(), 0755);
+		ExtractDirectory("maps");
+		ExtractDirectory("text");
+		Utilities::debugMessage("... end extract");
+		return;
+	}
+
 	Utilities::debugMessage("Start file copy...");
 
 	// AppResourcePath should point to the destination of the copy (where files will be loaded from in future)
@@ -163,6 +180,39 @@ void CopyDirectory(std::string dir_name)
 	}
 }
 
+// everything under directory in the mounted archive, out to internal storage
+void ExtractDirectory(std::string dir_name)
+{
+	std::vector<std::string> names;
+	AssetArchive::list(names);
+	std::string prefix = dir_name + "/";
+	for(size_t i = 0; i < names.size(); i++)
+	{
+		const std::string& name = names[i];
+		if(name.compare(0, prefix.size(), prefix) != 0) continue;
+
+		// archives only list files, so make the directories on the way
+		for(size_t slash = name.find('/'); slash != std::string::npos; slash = name.find('/', slash + 1))
+		{
+			mkdir(AppResourcePath(name.substr(0, slash)).c_str(), 0755);
+		}
+
+		AssetData asset;
+		if(not AssetArchive::read(name, asset))
+		{
+			Utilities::fatalError("Failed to read " + name + " from the packed assets");
+		}
+		AppResourcePath arp(name);
+		FILE* f = fopen(arp.c_str(), "wb");
+		if(f == NULL)
+		{
+			Utilities::fatalError("Failed to copy to" + arp.str());
+		}
+		fwrite(asset.data, 1, asset.size, f);
+		fclose(f);
+	}
+}
+
 void CopyFile(std::string file_name)
 {
 	std::string asset_path = DATA_DIR + file_name;
@@ -36,6 +36,11 @@
 #include <ciso646>   // Visual Studio is not C++ standards complaint...
 #endif
 #include "GameToScreenMapping.h"
+#include "ElementPool.h"
+#include "LuaAllocator.h"
+#include "AllocationTracker.h"
+#include <algorithm>
+#include <cstring>
 
 MiniTimeBuffer::MiniTimeBuffer(size_t size)
 : max_size(size)
@@ -137,6 +142,24 @@ static void tsave(double a, double b, double c)
 #define tsave(a, b, c)
 #endif
 
+// " pool:in use/capacity" for the pools called name1 or name2, all block sizes added up
+static void append_pool_occupancy(std::stringstream& s, const char* name1, const char* name2)
+{
+    size_t in_use = 0;
+    size_t capacity = 0;
+    const std::vector<FixedBlockPool*>& pools = FixedBlockPool::get_pools();
+    for(size_t i = 0; i < pools.size(); i++)
+    {
+        const char* name = pools[i]->get_name();
+        if(std::strcmp(name, name1) == 0 or (name2 and std::strcmp(name, name2) == 0))
+        {
+            in_use += pools[i]->get_in_use();
+            capacity += pools[i]->get_capacity();
+        }
+    }
+    if(capacity) s << " pool:" << in_use << "/" << capacity;
+}
+
 // +---------------------------------------------------------------------------
 // | TITLE: print
 // | AUTHOR(s): Rob Probin
@@ -152,6 +175,7 @@ void Debug::print(MyGraphics& gr)
 
     SDL_GetPerformanceFrequency_stored = SDL_GetPerformanceFrequency();
 	queue_times(frame_times, loop_start_time_last, loop_start_time);
+    AllocationTracker::set_texture_bytes(gr.texture_bytes());
 	//queue_times(processing_times, loop_start_time_last, prerender);
     //queue_times(processing_times, loop_start_time_last, loop_end_predelay);
     //queue_times(long_times, loop_start_time_last, loop_start_time);
@@ -169,6 +193,10 @@ void Debug::print(MyGraphics& gr)
         min60=0; max60=0;
         //last_60_loop_time = calc_times(long_times, &min60, &max60);
         last_60_loop_time = calc_times(frame_times, &min60, &max60);
+        if(gc_times.size())
+        {
+            average_gc_time = calc_times(gc_times, 0, &max_gc_time, 60);
+        }
         draw_count = 0;
     }
     
@@ -210,29 +238,138 @@ void Debug::print(MyGraphics& gr)
     s.str("");
     
     //
-    // DLEs
+    // frame time percentiles, hitches and the last couple of seconds as a graph
+    //
+    s.precision(1);
+    s << std::fixed;
+    s << "p50:" << hitch_detector.get_p50() << " p95:" << hitch_detector.get_p95();
+    s << " p99:" << hitch_detector.get_p99() << "ms hitch:" << hitch_detector.get_hitch_count();
+    print_string(gr, s.str());
+    gr.go_to(gr.get_line()+1, 0);
+    s.str("");
+    draw_frame_graph(gr);
+
+    //
+    // Lua GC phase (when the engine is pacing it)
+    //
+    if(gc_active)
+    {
+        s.precision(2);
+        s << std::fixed;
+        s << "GC:" << average_gc_time << "ms (max " << max_gc_time << ") " << gc_steps << " steps";
+        print_string(gr, s.str());
+        gr.go_to(gr.get_line()+1, 0);
+        s.str("");
+        gc_active = false;      // set again next frame if it's still running
+    }
+
+    //
+    // heap churn last frame: allocations (by phase), KB allocated, then what's live
+    //
+    if(AllocationTracker::active())
+    {
+        const AllocationTracker::Totals& frame = AllocationTracker::last_frame();
+        AllocationTracker::Totals all = AllocationTracker::totals();
+        s.precision(1);
+        s << std::fixed;
+        s << "new:" << frame.allocations << "/f (ev" << AllocationTracker::last_phase(AllocationTracker::events).allocations;
+        s << " up" << AllocationTracker::last_phase(AllocationTracker::update).allocations;
+        s << " dr" << AllocationTracker::last_phase(AllocationTracker::draw).allocations;
+        s << " pr" << AllocationTracker::last_phase(AllocationTracker::present).allocations;
+        s << " li" << AllocationTracker::last_phase(AllocationTracker::limiter).allocations << ") ";
+        s << frame.bytes_allocated/1024.0 << "K/f live:" << (all.bytes_allocated - all.bytes_freed)/1024 << "K";
+        s << " SDL:" << AllocationTracker::last_sdl_frame().allocations << "/f";
+        print_string(gr, s.str());
+        gr.go_to(gr.get_line()+1, 0);
+        s.str("");
+    }
+    s << "tex:" << AllocationTracker::get_texture_bytes()/1024 << "K";
+    print_string(gr, s.str());
+    gr.go_to(gr.get_line()+1, 0);
+    s.str("");
+
+    //
+    // DLEs, and the pool blocks their list nodes and glyphs are in (in use/capacity)
     //
     s.precision(1);
     s << std::fixed;
     s << "DLE:" << dle_count;
+    append_pool_occupancy(s, "DLE", 0);
     print_string(gr, s.str());
     gr.go_to(gr.get_line()+1, 0);
     s.str("");
 
     //
-    // MazeData
+    // MazeData, and the map element and list node pools
     //
     s.precision(1);
     s << std::fixed;
     s << "MD:" << md_count;
+    append_pool_occupancy(s, "MD", "map");
     print_string(gr, s.str());
     gr.go_to(gr.get_line()+1, 0);
     s.str("");
     
+    //
+    // Lua state memory (name:KB used/limit, blocks)
+    //
+    LuaAllocator::lock_list();
+    const std::vector<LuaAllocator*>& allocators = LuaAllocator::get_list();
+    for(size_t i = 0; i < allocators.size(); i++)
+    {
+        LuaAllocator* a = allocators[i];
+        s << a->get_name() << ":" << a->get_bytes()/1024 << "K";
+        if(a->get_limit()) { s << "/" << a->get_limit()/1024 << "K"; }
+        s << "," << a->get_blocks() << " ";
+    }
+    LuaAllocator::unlock_list();
+    if(not s.str().empty())
+    {
+        print_string(gr, s.str());
+        gr.go_to(gr.get_line()+1, 0);
+        s.str("");
+    }
+
     // junk from Lua :-)
     print_cstring(&gr, lua_info_string_copy.c_str());
 }
 
+// +---------------------------------------------------------------------------
+// | TITLE: draw_frame_graph
+// | AUTHOR(s): agent
+// | DATE STARTED: 19 Oct 2026
+// +
+// | DESCRIPTION: One bar per frame, newest on the right. The top of the graph
+// | is the hitch budget, and frames over it are red.
+// +---------------------------------------------------------------------------
+void Debug::draw_frame_graph(MyGraphics& gr)
+{
+    const int frames = 120;
+    const int bar_width = 2;
+    const int graph_lines = 2;
+    float totals[frames];
+    int count = hitch_detector.recent_totals(totals, frames);
+
+    int height = graph_lines * viewport.cell_size;
+    int x = viewport.rect.x;
+    int y = viewport.rect.y + static_cast<int>(gr.get_line()) * viewport.cell_size;
+    SDL_Colour background = {0, 0, 255, 128};
+    SDL_Colour under = {0, 255, 0, 255};
+    SDL_Colour over = {255, 0, 0, 255};
+    SDL_Rect area = { x, y, frames * bar_width, height };
+    gr.FillRectColour(background, area);
+
+    double budget = hitch_detector.get_budget();
+    for(int i = 0; i < count; i++)
+    {
+        double ms = totals[i];
+        int h = static_cast<int>(std::min(ms / budget, 1.0) * height);
+        SDL_Rect bar = { x + (frames - count + i) * bar_width, y + height - h, bar_width, h };
+        gr.FillRectColour(ms > budget ? over : under, bar);
+    }
+    gr.go_to(gr.get_line() + graph_lines, 0);
+}
+
 // +---------------------------------------------------------------------------
 // | TITLE:
 // | AUTHOR(s): Rob Probin
@@ -281,10 +418,81 @@ double Debug::calc_times(time_queue_t& q, double* min, double* max, size_t max_s
 // +---------------------------------------------------------------------------
 void Debug::timing_loop_start()
 {
+	Uint64 now = SDL_GetPerformanceCounter();
+	AllocationTracker::frame_done();
+	if(game_loops >= 0)
+	{
+		finish_frame(now);
+	}
 	loop_start_time_last = loop_start_time;
-	loop_start_time = SDL_GetPerformanceCounter();
+	loop_start_time = now;
 	game_loops++;
 }
+
+// +---------------------------------------------------------------------------
+// | TITLE: timing_events_done / timing_update_done
+// | AUTHOR(s): agent
+// | DATE STARTED: 19 Oct 2026
+// +
+// | DESCRIPTION: Phase boundaries in the main loop, for the hitch detector
+// +---------------------------------------------------------------------------
+void Debug::timing_events_done()
+{
+	events_done = SDL_GetPerformanceCounter();
+	AllocationTracker::phase_done(AllocationTracker::events);
+}
+
+void Debug::timing_update_done()
+{
+	update_done = SDL_GetPerformanceCounter();
+	AllocationTracker::phase_done(AllocationTracker::update);
+}
+
+// +---------------------------------------------------------------------------
+// | TITLE: finish_frame
+// | AUTHOR(s): agent
+// | DATE STARTED: 19 Oct 2026
+// +
+// | DESCRIPTION: Hand the frame that's just finished to the hitch detector.
+// | Without a GUI there's no draw or present, so they are left as zero.
+// +---------------------------------------------------------------------------
+void Debug::finish_frame(Uint64 next_frame_start)
+{
+	double to_ms = 1000.0 / SDL_GetPerformanceFrequency();
+	HitchDetector::Frame f;
+	f.start = loop_start_time;
+	f.total_ms = static_cast<float>((next_frame_start - loop_start_time) * to_ms);
+	f.events_ms = static_cast<float>((events_done - loop_start_time) * to_ms);
+	f.update_ms = static_cast<float>((update_done - events_done) * to_ms);
+	bool rendered = prerender > update_done;
+	f.draw_ms = rendered ? static_cast<float>((prerender - update_done) * to_ms) : 0;
+	f.present_ms = rendered ? static_cast<float>((loop_end_predelay - prerender) * to_ms) : 0;
+	f.limiter_ms = static_cast<float>((next_frame_start - loop_end_predelay) * to_ms);
+	f.gc_ms = static_cast<float>(frame_gc_ms);
+	f.gc_steps = frame_gc_steps;
+	f.events = event_count;
+	f.allocations = static_cast<int>(AllocationTracker::last_frame().allocations + AllocationTracker::last_sdl_frame().allocations);
+
+	size_t allocations = 0;
+	size_t bytes = 0;
+	LuaAllocator::lock_list();
+	const std::vector<LuaAllocator*>& allocators = LuaAllocator::get_list();
+	for(size_t i = 0; i < allocators.size(); i++)
+	{
+		allocations += allocators[i]->get_allocation_count();
+		bytes += allocators[i]->get_bytes();
+	}
+	LuaAllocator::unlock_list();
+	// states come and go, so this can go backwards
+	f.lua_allocations = allocations > last_allocation_total ? static_cast<int>(allocations - last_allocation_total) : 0;
+	f.lua_kb = static_cast<int>(bytes / 1024);
+	last_allocation_total = allocations;
+
+	hitch_detector.add_frame(f);
+	frame_gc_ms = 0;
+	frame_gc_steps = 0;
+	event_count = 0;
+}
 // +---------------------------------------------------------------------------
 // | TITLE:
 // | AUTHOR(s): Rob Probin
@@ -295,6 +503,7 @@ void Debug::timing_loop_start()
 void Debug::timing_loop_end_predelay()
 {
 	loop_end_predelay = SDL_GetPerformanceCounter();
+	AllocationTracker::phase_done(AllocationTracker::present);
     tsave((loop_start_time - loop_start_time_last) / f,
           (prerender - loop_start_time) / f,
           (loop_end_predelay - loop_start_time) / f
@@ -310,8 +519,27 @@ void Debug::timing_loop_end_predelay()
 void Debug::timing_prerender()
 {
 	prerender = SDL_GetPerformanceCounter();
+	AllocationTracker::phase_done(AllocationTracker::draw);
 }
 
+// +---------------------------------------------------------------------------
+// | TITLE: timing_gc
+// | AUTHOR(s): agent
+// | DATE STARTED: 19 Oct 2026
+// +
+// | DESCRIPTION: Time spent in the Lua collector this frame, as its own phase
+// +---------------------------------------------------------------------------
+void Debug::timing_gc(Uint64 start, Uint64 end, int steps)
+{
+	double time = static_cast<double>(end - start);
+	time /= SDL_GetPerformanceFrequency();
+	time *= 1000.0;
+	gc_times.add_to_end(time);
+	gc_steps = steps;
+	gc_active = true;
+	frame_gc_ms += time;
+	frame_gc_steps += steps;
+}
 
 // +---------------------------------------------------------------------------
 // | TITLE:
@@ -328,8 +556,20 @@ Debug::Debug()
 , loop_end_predelay(0)
 , prerender(0)
 , frame_times(60*60)
+, gc_times(60)
+, gc_steps(0)
+, gc_active(false)
+, events_done(0)
+, update_done(0)
+, frame_gc_ms(0)
+, frame_gc_steps(0)
+, event_count(0)
+, last_allocation_total(0)
+, dle_count(0)
 , md_count(0)
 , lua_info_string_copy("")
+, average_gc_time(0)
+, max_gc_time(0)
 , draw_count(0)
 {
 }
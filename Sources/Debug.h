@@ -38,6 +38,7 @@ class MyGraphics;
 #include <string>
 #include <vector>
 #include "GameToScreenMapping.h"
+#include "HitchDetector.h"
 
 #define MiniTimeBuffer_uses_deque 1
 class MiniTimeBuffer
@@ -73,14 +74,21 @@ public:
 	void timing_loop_start();
 	void timing_loop_end_predelay();
 	void timing_prerender();
+	void timing_gc(Uint64 start, Uint64 end, int steps);	// engine paced Lua GC, see FrameRateLimiter
+	void timing_events_done();
+	void timing_update_done();
+	void count_event() { event_count++; }
+	HitchDetector* hitches() { return &hitch_detector; }
 
 	// DrawListElement related calls
 	void inc_dle_count() { dle_count++; }
 	void dec_dle_count() { dle_count--; }
+	unsigned int get_dle_count() { return dle_count; }
 
 	// MazeData related calls
 	void inc_md_count() { md_count++; }
 	void dec_md_count() { md_count--; }
+	unsigned int get_md_count() { return md_count; }
 
 	void set_lua_info_string(const char* display_string);
 	// -----------
@@ -98,9 +106,23 @@ private:
 	//typedef std::deque<double> time_queue_t;
     typedef MiniTimeBuffer time_queue_t;
 	time_queue_t frame_times;
+	time_queue_t gc_times;
+	int gc_steps;
+	bool gc_active;
+
+	// phases of the current frame, for the hitch detector
+	Uint64 events_done;
+	Uint64 update_done;
+	double frame_gc_ms;
+	int frame_gc_steps;
+	int event_count;
+	size_t last_allocation_total;
+	HitchDetector hitch_detector;
 	//time_queue_t processing_times;
     //time_queue_t long_times;
     void queue_times(time_queue_t& q, Uint64 start, Uint64 end);
+    void finish_frame(Uint64 next_frame_start);
+    void draw_frame_graph(MyGraphics& gr);
     double calc_times(time_queue_t& q, double* min=0, double* max=0, size_t max_size=0);
 
 	// DrawListElement / MazeData stuff
@@ -118,6 +140,8 @@ private:
     double min60;
     double max60;
     double last_60_loop_time;
+    double average_gc_time;
+    double max_gc_time;
     Uint64 SDL_GetPerformanceFrequency_stored;
     int draw_count;
 
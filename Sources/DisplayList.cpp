@@ -0,0 +1,302 @@
+/*
+ * DisplayList.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#include "DisplayList.h"
+#include "DrawList.h"
+#include "GlyphArray.h"
+#include "Utilities.h"
+
+
+DisplayList::DisplayList(DrawList* dl)
+: valid(false)
+, viewport_changed(false)
+, draw_list(dl)
+, listed(false)
+, layer(0)
+{
+	if(draw_list and draw_list->dl_magic != DL_MAGIC)
+	{
+		Utilities::fatalError("DisplayList got something without correct magic. Aborting!");
+	}
+}
+
+DisplayList::~DisplayList()
+{
+	hide();
+}
+
+void DisplayList::show()
+{
+	if(draw_list and not listed)
+	{
+		draw_list->insert_display_list(this);
+		listed = true;
+	}
+}
+
+void DisplayList::hide()
+{
+	if(listed and draw_list)
+	{
+		draw_list->remove_display_list(this);
+	}
+	listed = false;
+}
+
+void DisplayList::list_died()
+{
+	draw_list = 0;
+	listed = false;
+}
+
+
+//
+// Recording
+//
+
+void DisplayList::clear()
+{
+	ops.clear();
+	runs.clear();
+	glyphs.clear();
+	colours.clear();
+	attributes.clear();
+	styles.clear();
+	viewports.clear();
+	viewport_changed = false;
+	valid = true;
+}
+
+DisplayList::Op& DisplayList::add(OpCode code, int index, double a, double b, double c, double d)
+{
+	Op op;
+	op.code = code;
+	op.index = index;
+	op.a = a;
+	op.b = b;
+	op.c = c;
+	op.d = d;
+	op.colour.r = op.colour.g = op.colour.b = op.colour.a = 0;
+	ops.push_back(op);
+	return ops.back();
+}
+
+DisplayList::Op& DisplayList::add_colour(OpCode code, const SDL_Colour& colour, double a, double b, double c, double d)
+{
+	Op& op = add(code, 0, a, b, c, d);
+	op.colour = colour;
+	return op;
+}
+
+void DisplayList::go_to(pos_t line, pos_t column) { add(op_go_to, 0, line, column); }
+void DisplayList::print_glyph(int character) { add(op_print, character); }
+void DisplayList::print_at(pos_t line, pos_t column, int character) { add(op_print_at, character, line, column); }
+void DisplayList::set_fg_colour(simple_colour_t colour) { add_colour(op_fg_colour, get_rgb_from_simple_colour(colour)); }
+void DisplayList::set_fg_fullcolour(const SDL_Colour& colour) { add_colour(op_fg_colour, colour); }
+void DisplayList::set_bg_colour(simple_colour_t colour) { add_colour(op_bg_colour, get_rgb_from_simple_colour(colour)); }
+void DisplayList::set_bg_fullcolour(const SDL_Colour& colour) { add_colour(op_bg_colour, colour); }
+void DisplayList::set_bg_transparent() { add(op_bg_transparent); }
+void DisplayList::set_bg_opaque() { add(op_bg_opaque); }
+void DisplayList::set_dim_alpha() { add(op_dim_alpha); }
+void DisplayList::set_full_alpha() { add(op_full_alpha); }
+void DisplayList::set_alpha(int alpha) { add(op_alpha, alpha < 0 ? 0 : (alpha > 255 ? 255 : alpha)); }
+void DisplayList::wrap(bool on) { add(op_wrap, on ? 1 : 0); }
+
+void DisplayList::set_wrap_limits(double line_start, double line_end, double column_start, double column_end)
+{
+	add(op_wrap_limits, 0, line_start, line_end, column_start, column_end);
+}
+
+void DisplayList::DrawRect(const SDL_Colour& colour, double x1, double y1, double x2, double y2) { add_colour(op_draw_rect, colour, x1, y1, x2, y2); }
+void DisplayList::DrawLine(const SDL_Colour& colour, double x1, double y1, double x2, double y2) { add_colour(op_draw_line, colour, x1, y1, x2, y2); }
+void DisplayList::DrawPoint(const SDL_Colour& colour, double x, double y) { add_colour(op_draw_point, colour, x, y); }
+void DisplayList::FillRect(const SDL_Colour& colour, double x1, double y1, double x2, double y2) { add_colour(op_fill_rect, colour, x1, y1, x2, y2); }
+
+void DisplayList::print_styled(pos_t line, pos_t column, int character, const DrawStyle& style)
+{
+	add(op_print_styled, static_cast<int>(styles.size()), line, column, character);
+	styles.push_back(style);
+}
+
+void DisplayList::set_viewport(const Viewport& vp)
+{
+	add(op_viewport, static_cast<int>(viewports.size()));
+	viewports.push_back(vp);
+	viewport_changed = true;
+}
+
+void DisplayList::print_string(const std::string& text)
+{
+	Run r = { static_cast<int>(glyphs.size()), 0, -1, 0, -1, 0, -1, 0 };
+	GlyphArray::decode_utf8(text.c_str(), text.size(), glyphs);
+	r.count = static_cast<int>(glyphs.size()) - r.glyphs;
+	if(r.count == 0) return;
+	add(op_print_run, static_cast<int>(runs.size()));
+	runs.push_back(r);
+}
+
+// copies the run, the caller's arrays can go away
+void DisplayList::print_run(const GlyphRun& run)
+{
+	if(run.count <= 0) return;
+	Run r = { static_cast<int>(glyphs.size()), run.count, -1, 0, -1, 0, -1, 0 };
+	glyphs.insert(glyphs.end(), run.characters, run.characters + run.count);
+	if(run.fg and run.fg_count > 0)
+	{
+		r.fg = static_cast<int>(colours.size());
+		r.fg_count = run.fg_count;
+		colours.insert(colours.end(), run.fg, run.fg + run.fg_count);
+	}
+	if(run.bg and run.bg_count > 0)
+	{
+		r.bg = static_cast<int>(colours.size());
+		r.bg_count = run.bg_count;
+		colours.insert(colours.end(), run.bg, run.bg + run.bg_count);
+	}
+	if(run.attributes and run.attribute_count > 0)
+	{
+		r.attributes = static_cast<int>(attributes.size());
+		r.attribute_count = run.attribute_count;
+		attributes.insert(attributes.end(), run.attributes, run.attributes + run.attribute_count);
+	}
+	add(op_print_run, static_cast<int>(runs.size()));
+	runs.push_back(r);
+}
+
+// argument 1 is the DisplayList, since it's called as a method
+int DisplayList::lua_print_run(lua_State* L)
+{
+	GlyphRun run;
+	glyph_run_from_lua(L, 2, run);
+	print_run(run);
+	return 0;
+}
+
+
+//
+// Playback
+//
+
+void DisplayList::replay(MyGraphics* gr)
+{
+	if(not gr)
+	{
+		Utilities::fatalError("MyGraphics nullptr in DisplayList::replay");
+	}
+	draw(*gr, 0, 0);
+}
+
+void DisplayList::draw(MyGraphics& gr, pos_t line_offset, pos_t column_offset)
+{
+	bool alpha_changed = false;
+	size_t count = ops.size();
+	for(size_t i = 0; i < count; i++)
+	{
+		const Op& op = ops[i];
+		switch(op.code)
+		{
+			case op_go_to:
+				gr.go_to(op.a - line_offset, op.b - column_offset);
+				break;
+			case op_print:
+				gr.print(op.index);
+				break;
+			case op_print_at:
+				gr.print(op.a - line_offset, op.b - column_offset, op.index);
+				break;
+			case op_print_run:
+			{
+				const Run& r = runs[op.index];
+				GlyphRun run;
+				run.characters = &glyphs[r.glyphs];
+				run.count = r.count;
+				if(r.fg >= 0) { run.fg = &colours[r.fg]; run.fg_count = r.fg_count; }
+				if(r.bg >= 0) { run.bg = &colours[r.bg]; run.bg_count = r.bg_count; }
+				if(r.attributes >= 0) { run.attributes = &attributes[r.attributes]; run.attribute_count = r.attribute_count; }
+				gr.print_run(run);
+				break;
+			}
+			case op_print_styled:
+				gr.print_styled(op.a - line_offset, op.b - column_offset, static_cast<int>(op.c), styles[op.index]);
+				break;
+			case op_fg_colour:
+				gr.set_fg_fullcolour(op.colour);
+				break;
+			case op_bg_colour:
+				gr.set_bg_fullcolour(op.colour);
+				break;
+			case op_bg_transparent:
+				gr.set_bg_transparent();
+				break;
+			case op_bg_opaque:
+				gr.set_bg_opaque();
+				break;
+			case op_dim_alpha:
+				gr.set_dim_alpha();
+				alpha_changed = true;
+				break;
+			case op_full_alpha:
+				gr.set_full_alpha();
+				break;
+			case op_alpha:
+				gr.set_alpha(static_cast<Uint8>(op.index));
+				alpha_changed = true;
+				break;
+			case op_wrap:
+				gr.wrap(op.index != 0);
+				break;
+			case op_wrap_limits:
+				gr.set_wrap_limits(op.a - line_offset, op.b - line_offset, op.c - column_offset, op.d - column_offset);
+				break;
+			case op_draw_rect:
+				gr.DrawRect(op.colour, op.a, op.b, op.c, op.d);
+				break;
+			case op_draw_line:
+				gr.DrawLine(op.colour, op.a, op.b, op.c, op.d);
+				break;
+			case op_draw_point:
+				gr.DrawPoint(op.colour, op.a, op.b);
+				break;
+			case op_fill_rect:
+				gr.FillRect(op.colour, op.a, op.b, op.c, op.d);
+				break;
+			case op_viewport:
+				gr.set_viewport(viewports[op.index]);
+				break;
+		}
+	}
+
+	if(alpha_changed)
+	{
+		gr.set_full_alpha();
+		gr.set_alpha(255);
+	}
+}
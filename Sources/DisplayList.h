@@ -0,0 +1,168 @@
+/*
+ * DisplayList.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#ifndef DISPLAY_LIST_H
+#define DISPLAY_LIST_H
+
+#include "SDL.h"
+#include <vector>
+#include <string>
+#include "MyGraphics.h"
+#include "DrawStyle.h"
+#ifdef _MSC_VER
+#include <ciso646>   // Visual Studio is not C++ standards complaint...
+#endif
+class DrawList;
+
+// A recording of MyGraphics calls that the engine replays in C++, for things
+// that don't change every frame - menus, HUD frames, panels, help text.
+//
+// Lua records it once with the same calls it would make on a MyGraphics, then
+// either calls replay(gr) in its draw function, or shows it in a DrawList,
+// where it's drawn with the elements by layer (like a ParticleEmitter).
+//
+//		menu = DisplayList(draw_list_or_nil)
+//		if not menu:is_valid() then
+//			menu:clear()
+//			menu:set_fg_colour(7) menu:go_to(2, 4) menu:print_string("Start")
+//			menu:FillRect(colour, 10, 10, 200, 20) ...
+//		end
+//		menu:replay(gr)
+//
+// invalidate() marks it out of date (when the text changes, say) - it still
+// draws the old recording until Lua clears it and records again. A new list
+// starts off invalid.
+//
+// In a DrawList, cell positions move with the list's offsets like elements
+// do; pixel positions (the rectangles, lines and points) don't. Alpha and dim
+// are put back after a replay, other state (colours, cursor, wrap, viewport)
+// is left as the recording set it, as it would be from Lua.
+class DisplayList
+{
+public:
+	explicit DisplayList(DrawList* draw_list);
+	~DisplayList();
+
+	// recording
+	void clear();
+	void invalidate() { valid = false; }
+	bool is_valid() { return valid; }
+	int get_op_count() { return static_cast<int>(ops.size()); }
+
+	void go_to(pos_t line, pos_t column);
+	void print_glyph(int character);
+	void print_at(pos_t line, pos_t column, int character);
+	void print_string(const std::string& text);
+	void print_styled(pos_t line, pos_t column, int character, const DrawStyle& style);
+	void print_run(const GlyphRun& run);
+	void set_fg_colour(simple_colour_t colour);
+	void set_fg_fullcolour(const SDL_Colour& colour);
+	void set_bg_colour(simple_colour_t colour);
+	void set_bg_fullcolour(const SDL_Colour& colour);
+	void set_bg_transparent();
+	void set_bg_opaque();
+	void set_dim_alpha();
+	void set_full_alpha();
+	void set_alpha(int alpha);
+	void wrap(bool on);
+	void set_wrap_limits(double line_start, double line_end, double column_start, double column_end);
+	void DrawRect(const SDL_Colour& colour, double x1, double y1, double x2, double y2);
+	void DrawLine(const SDL_Colour& colour, double x1, double y1, double x2, double y2);
+	void DrawPoint(const SDL_Colour& colour, double x, double y);
+	void FillRect(const SDL_Colour& colour, double x1, double y1, double x2, double y2);
+	void set_viewport(const Viewport& vp);
+
+	// dl:print_run(glyphs, [fg], [bg], [attributes]) - see MyGraphics::lua_print_run
+	int lua_print_run(lua_State* L);
+
+	// playback
+	void replay(MyGraphics* gr);
+	void draw(MyGraphics& gr, pos_t line_offset, pos_t column_offset);
+	bool changes_viewport() { return viewport_changed; }
+
+	// in a DrawList
+	void show();
+	void hide();
+	bool is_visible() { return listed; }
+	void set_layer(int l) { layer = l; }
+	int get_layer() { return layer; }
+	void list_died();
+
+private:
+	// lets not have these copy constructed or assigned
+	DisplayList(const DisplayList&);
+	DisplayList& operator=(const DisplayList&);
+
+	enum OpCode
+	{
+		op_go_to, op_print, op_print_at, op_print_run, op_print_styled,
+		op_fg_colour, op_bg_colour, op_bg_transparent, op_bg_opaque,
+		op_dim_alpha, op_full_alpha, op_alpha, op_wrap, op_wrap_limits,
+		op_draw_rect, op_draw_line, op_draw_point, op_fill_rect, op_viewport,
+	};
+
+	// one recorded call. index is the character, or which run/style/viewport
+	struct Op
+	{
+		OpCode code;
+		int index;
+		double a, b, c, d;
+		SDL_Colour colour;
+	};
+
+	// offsets into the shared arrays below, -1 for none
+	struct Run
+	{
+		int glyphs, count;
+		int fg, fg_count;
+		int bg, bg_count;
+		int attributes, attribute_count;
+	};
+
+	Op& add(OpCode code, int index = 0, double a = 0, double b = 0, double c = 0, double d = 0);
+	Op& add_colour(OpCode code, const SDL_Colour& colour, double a = 0, double b = 0, double c = 0, double d = 0);
+
+	std::vector<Op> ops;
+	std::vector<Run> runs;
+	std::vector<Uint32> glyphs;
+	std::vector<SDL_Colour> colours;
+	std::vector<Uint8> attributes;
+	std::vector<DrawStyle> styles;
+	std::vector<Viewport> viewports;
+	bool valid;
+	bool viewport_changed;
+
+	DrawList* draw_list;
+	bool listed;
+	int layer;
+};
+
+#endif
@@ -36,6 +36,10 @@
 #include <iostream>
 
 #include "GameApplication.h"
+#include "ParticleEmitter.h"
+#include "DisplayList.h"
+#include "Tween.h"
+#include <algorithm>
 
 const unsigned long DL_MAGIC = 0x13218887;
 
@@ -56,6 +60,7 @@ DrawListElement::DrawListElement(DrawList* dl,
 , bg_transparent(bgt)
 , angle(0.0)
 , dim(false)
+, alpha(255)
 , size_ratio(1.0)
 , height(1)
 , width(1)
@@ -65,6 +70,7 @@ DrawListElement::DrawListElement(DrawList* dl,
 , drag_callback(gulp_cpp->get_ui_lua_state())
 , click_self(gulp_cpp->get_ui_lua_state())
 , click_arg(gulp_cpp->get_ui_lua_state())
+, tween_count(0)
 {
 	debug.inc_dle_count();
 	//Utilities::debugMessage("Constructing a DLE");
@@ -91,6 +97,7 @@ DrawListElement::DrawListElement(DrawList* dl,
 , bg_transparent(true)
 , angle(0.0)
 , dim(false)
+, alpha(255)
 , size_ratio(1.0)
 , height(1)
 , width(1)
@@ -100,6 +107,7 @@ DrawListElement::DrawListElement(DrawList* dl,
 , drag_callback(gulp_cpp->get_ui_lua_state())
 , click_self(gulp_cpp->get_ui_lua_state())
 , click_arg(gulp_cpp->get_ui_lua_state())
+, tween_count(0)
 {
 	debug.inc_dle_count();
 	//Utilities::debugMessage("Constructing a DLE (no colour info)");
@@ -116,6 +124,7 @@ DrawListElement::DrawListElement(DrawList* dl,
 DrawListElement::~DrawListElement()
 {
 	hide();
+	if(tween_count) gulp_cpp->get_tweens().element_died(this);
 	//Utilities::debugMessage("Deleting a DLE");
 	debug.dec_dle_count();
 }
@@ -293,6 +302,7 @@ void DrawListElement::draw(MyGraphics& gr, pos_t line_offset, pos_t column_offse
 		if(gl.visible)
 		{
 			if(dim) gr.set_dim_alpha();
+			if(alpha != 255) gr.set_alpha(alpha);
 
 			gr.print(line-line_offset+gl.line_offset, column-column_offset+gl.column_offset, fg_colour, bg_colour, gl.glyph, angle, size_ratio, width, height);
 
@@ -305,11 +315,70 @@ void DrawListElement::draw(MyGraphics& gr, pos_t line_offset, pos_t column_offse
 
 
 			if(dim) gr.set_full_alpha();
+			if(alpha != 255) gr.set_alpha(255);
 		}
 		it++;
 	}
 }
 
+int DrawListElement::tween(std::string property, double to, double seconds, std::string easing)
+{
+	return tween_after(0, property, to, seconds, easing);
+}
+
+int DrawListElement::tween_after(int after_id, std::string property, double to, double seconds, std::string easing)
+{
+	TweenManager::property_t p = TweenManager::property_from_string(property);
+	if(p == TweenManager::prop_invalid)
+	{
+		Utilities::debugMessage("Unknown tween property %s", property.c_str());
+		return 0;
+	}
+	TweenManager::easing_t e = TweenManager::easing_from_string(easing);
+	if(e == TweenManager::easing_invalid)
+	{
+		Utilities::debugMessage("Unknown tween easing %s", easing.c_str());
+		return 0;
+	}
+	return gulp_cpp->get_tweens().add_tween(this, p, to, seconds, e, after_id);
+}
+
+bool DrawListElement::set_tween_callback(int id, luabridge::LuaRef callback, luabridge::LuaRef arg)
+{
+	return gulp_cpp->get_tweens().set_callback(id, callback, arg);
+}
+
+void DrawListElement::stop_tweens()
+{
+	if(tween_count) gulp_cpp->get_tweens().stop_tweens(this);
+}
+
+void DrawListElement::animate_glyphs(double interval, bool loop, lua_State* L)
+{
+	// tests for parameter error, if so, raise error.
+	luaL_checktype(L, -1, LUA_TTABLE);
+
+	std::vector<int> glyph_list;
+	int number_of_glyphs = static_cast<int>(luaL_len(L, -1));
+	for(int i = 1; i <= number_of_glyphs; i++)
+	{
+		lua_pushinteger(L, i);
+		lua_gettable(L, -2);		// replaces key with value
+		if(lua_isnumber(L, -1))
+		{
+			glyph_list.push_back(static_cast<int>(lua_tointeger(L, -1)));
+		}
+		lua_pop(L, 1);
+	}
+
+	gulp_cpp->get_tweens().animate_glyphs(this, glyph_list, interval, loop);
+}
+
+void DrawListElement::stop_glyph_animation()
+{
+	if(tween_count) gulp_cpp->get_tweens().stop_glyph_animation(this);
+}
+
 pos_t DrawListElement::get_line_in_pixels()
 {
 	if(draw_list)
@@ -364,6 +433,14 @@ DrawList::~DrawList()
 		(*dl)->list_died();
 		dl++;
 	}
+	for(size_t i = 0; i < emitters.size(); i++)
+	{
+		emitters[i]->list_died();
+	}
+	for(size_t i = 0; i < display_lists.size(); i++)
+	{
+		display_lists[i]->list_died();
+	}
     dl_magic = 0;
 }
 
@@ -435,10 +512,41 @@ void DrawList::render_complex(MyGraphics* gr, pos_t offset_line, pos_t offset_co
 
 	gr->set_viewport(viewport);
 
+	// particle emitters are drawn in with the elements by layer, at the
+	// start of the first element with a higher layer
+	if(emitters.size() > 1)
+	{
+		std::stable_sort(emitters.begin(), emitters.end(), [] (ParticleEmitter* a, ParticleEmitter* b) {
+			return a->get_layer() < b->get_layer();
+		});
+	}
+	size_t next_emitter = 0;
+
+	// same for display lists
+	if(display_lists.size() > 1)
+	{
+		std::stable_sort(display_lists.begin(), display_lists.end(), [] (DisplayList* a, DisplayList* b) {
+			return a->get_layer() < b->get_layer();
+		});
+	}
+	size_t next_display_list = 0;
+
 	dl_iterator dl = draw_list.begin();
 
 	while(dl != draw_list.end())
 	{
+		while(next_emitter < emitters.size() and emitters[next_emitter]->get_layer() < (*dl)->layer)
+		{
+			emitters[next_emitter]->update_from_clock();
+			emitters[next_emitter]->draw(*gr, offset_line, offset_column);
+			next_emitter++;
+		}
+		while(next_display_list < display_lists.size() and display_lists[next_display_list]->get_layer() < (*dl)->layer)
+		{
+			draw_display_list(gr, display_lists[next_display_list], offset_line, offset_column);
+			next_display_list++;
+		}
+
 		if((*dl)->bg_transparent)
 			gr->set_bg_transparent();
 		else
@@ -501,10 +609,60 @@ void DrawList::render_complex(MyGraphics* gr, pos_t offset_line, pos_t offset_co
 		dl++;
 	}
 
+	while(next_emitter < emitters.size())
+	{
+		emitters[next_emitter]->update_from_clock();
+		emitters[next_emitter]->draw(*gr, offset_line, offset_column);
+		next_emitter++;
+	}
+	while(next_display_list < display_lists.size())
+	{
+		draw_display_list(gr, display_lists[next_display_list], offset_line, offset_column);
+		next_display_list++;
+	}
+
 	gr->set_bg_opaque();
 
 }
 
+void DrawList::insert_emitter(ParticleEmitter* pe)
+{
+	emitters.push_back(pe);
+}
+
+void DrawList::remove_emitter(ParticleEmitter* pe)
+{
+	std::vector<ParticleEmitter*>::iterator it = std::find(emitters.begin(), emitters.end(), pe);
+	if(it != emitters.end())
+	{
+		emitters.erase(it);
+	}
+}
+
+// the elements after it still want the list's viewport
+void DrawList::draw_display_list(MyGraphics* gr, DisplayList* display_list, pos_t offset_line, pos_t offset_column)
+{
+	display_list->draw(*gr, offset_line, offset_column);
+	if(display_list->changes_viewport())
+	{
+		gr->set_viewport(viewport);
+	}
+}
+
+void DrawList::insert_display_list(DisplayList* display_list)
+{
+	display_lists.push_back(display_list);
+}
+
+void DrawList::remove_display_list(DisplayList* display_list)
+{
+	std::vector<DisplayList*>::iterator it = std::find(display_lists.begin(), display_lists.end(), display_list);
+	if(it != display_lists.end())
+	{
+		display_lists.erase(it);
+	}
+}
+
 void DrawList::insert_element(DrawListElement* dle, bool clickable_element)
 {
 	// add dle to the list depending on the render order - i.e. the layer
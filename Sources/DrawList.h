@@ -37,8 +37,13 @@
 #include "MyGraphics.h"
 #include "MazeConstants.h"
 #include "Clickable.h"
+#include "ElementPool.h"
 class DrawList;
 class PresentationMaze;
+class ParticleEmitter;
+class DisplayList;
+
+extern const unsigned long DL_MAGIC;
 
 #ifdef RENDER_DEBUG
 extern bool dl_render_debug;
@@ -69,8 +74,9 @@ public:
 		compound_glyph(int g, int s, bool v, float l, float c) : glyph(g), sublayer(s), line_offset(l), column_offset(c), visible(v) {};
 	};
 
-    std::list<compound_glyph> glyphs;							// what we are printing (ordered by layer
-    std::vector<std::list<compound_glyph>::iterator> gl_its;	// allow direct access to list elements
+    typedef std::list<compound_glyph, PoolAllocator<compound_glyph, dle_pool_tag> > glyph_list_t;
+    glyph_list_t glyphs;							// what we are printing (ordered by layer
+    std::vector<glyph_list_t::iterator> gl_its;	// allow direct access to list elements
 	pos_t line;	// where we are printing it
 	pos_t column;
 	int layer;		// above or below overlapping glyphs?
@@ -81,6 +87,7 @@ public:
 
 	double angle;
 	bool dim;
+	Uint8 alpha;
 
 	double size_ratio;
 	int height;
@@ -93,6 +100,8 @@ public:
 	luabridge::LuaRef click_self;
 	luabridge::LuaRef click_arg;
 
+	int tween_count;		// number of tweens/animations TweenManager has for us
+
 private:
     DrawListElement(
 			DrawList* draw_list,
@@ -166,9 +175,21 @@ public:
 
 	void set_angle(double a) { angle = a; }
 	double get_angle() { return angle; }
+	void set_alpha(int a) { alpha = static_cast<Uint8>(a < 0 ? 0 : (a > 255 ? 255 : a)); }
+	int get_alpha() { return alpha; }
+
+	// engine side animation, see TweenManager
+	int tween(std::string property, double to, double seconds, std::string easing);
+	int tween_after(int after_id, std::string property, double to, double seconds, std::string easing);
+	bool set_tween_callback(int id, luabridge::LuaRef callback, luabridge::LuaRef arg);
+	void stop_tweens();
+	bool is_tweening() { return tween_count != 0; }
+	void animate_glyphs(double interval, bool loop, lua_State* L);
+	void stop_glyph_animation();
 };
 
-typedef std::list<DrawListElement*>::iterator dl_iterator;
+typedef std::list<DrawListElement*, PoolAllocator<DrawListElement*, dle_pool_tag> > dl_list_t;
+typedef dl_list_t::iterator dl_iterator;
 
 
 class DrawListOwner
@@ -206,6 +227,10 @@ public:
 	void render_complex(MyGraphics* gr, pos_t offset_line, pos_t offset_column, PresentationMaze* maze, int (*view_layer)[MazeConstants::maze_height_max][MazeConstants::maze_width_max]);
 	void insert_element(DrawListElement*, bool clickable);
 	void remove_element(DrawListElement*);
+	void insert_emitter(ParticleEmitter*);
+	void remove_emitter(ParticleEmitter*);
+	void insert_display_list(DisplayList*);
+	void remove_display_list(DisplayList*);
 
 	void set_size(int s) { if(s<1) s=1; viewport.cell_size = s; }
 	int get_size() { return viewport.cell_size; }
@@ -229,10 +254,13 @@ public:
 	const int CELL_BASED = Viewport::cell_based;
 
 private:
-	std::list<DrawListElement*> draw_list;
+	dl_list_t draw_list;
+	std::vector<ParticleEmitter*> emitters;
+	std::vector<DisplayList*> display_lists;
 
 
 	dl_iterator find_layer(int layer);
+	void draw_display_list(MyGraphics* gr, DisplayList* display_list, pos_t offset_line, pos_t offset_column);
 
 
 	int element_count;		// for debug
@@ -0,0 +1,104 @@
+/*
+ * DrawStyle.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#include "DrawStyle.h"
+#include "LuaUserdata.h"
+#ifdef _MSC_VER
+#include <ciso646>   // Visual Studio is not C++ standards complaint...
+#endif
+
+using luabridge::LuaRef;
+
+
+DrawStyle::DrawStyle(LuaRef attrs)
+: scale_x(1.0)
+, scale_y(1.0)
+, angle(0)
+, rot_center_x(0.5)
+, rot_center_y(0.5)
+, flip(0)
+, alpha(255)
+, has_colour(false)
+{
+	colour.r = colour.g = colour.b = colour.a = 255;
+	if(not attrs.isTable()) return;
+
+	// same names as printExT
+	LuaRef scale = attrs["scale"];
+	if(scale.isNumber()) { scale_x = scale_y = scale; }
+
+	LuaRef _scale_x = attrs["scale_x"];
+	if(_scale_x.isNumber()) { scale_x = _scale_x; }
+
+	LuaRef _scale_y = attrs["scale_y"];
+	if(_scale_y.isNumber()) { scale_y = _scale_y; }
+
+	LuaRef _angle = attrs["angle"];
+	if(_angle.isNumber()) { angle = _angle; }
+
+	LuaRef _rot_center_x = attrs["rot_center_x"];
+	if(_rot_center_x.isNumber()) { rot_center_x = _rot_center_x; }
+
+	LuaRef _rot_center_y = attrs["rot_center_y"];
+	if(_rot_center_y.isNumber()) { rot_center_y = _rot_center_y; }
+
+	LuaRef _flip = attrs["flip"];
+	if(_flip.isNumber()) { flip = _flip; }
+
+	LuaRef _alpha = attrs["alpha"];
+	if(_alpha.isNumber()) { alpha = _alpha; }
+
+	LuaRef _colour = attrs["colour"];
+	if(_colour.isNumber())
+	{
+		int n = _colour;
+		if(n >= 0 and n < number_of_colours) { set_colour(simple_colour_t(n)); }
+	}
+	else if(_colour.isUserdata())
+	{
+		lua_State* L = _colour.state();
+		_colour.push(L);
+		SDL_Colour* c = luabridge_userdata_if<SDL_Colour>(L, -1);
+		lua_pop(L, 1);
+		if(c) { set_fullcolour(*c); }
+	}
+}
+
+void DrawStyle::set_colour(simple_colour_t c)
+{
+	set_fullcolour(get_rgb_from_simple_colour(c));
+}
+
+void DrawStyle::set_fullcolour(const SDL_Colour& c)
+{
+	colour = c;
+	has_colour = true;
+}
@@ -0,0 +1,73 @@
+/*
+ * DrawStyle.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#ifndef DRAW_STYLE_H
+#define DRAW_STYLE_H
+
+#include "SDL.h"
+#include "ColourManagement.h"
+#include "lua.h"
+#include "lauxlib.h"
+#include "LuaBridge.h"
+
+// How to draw a glyph with MyGraphics::print_styled() - scale, rotation,
+// flip, colour and alpha - worked out once, rather than looked up in a
+// table on every printExT() call.
+//
+// From Lua:
+//		style = DrawStyle{ scale_x=2, angle=45, flip=1, colour=4, alpha=128 }
+//		gr:print_styled(line, column, character, style)
+//		gr:printExT(line, column, fg_colour, character, style)	-- style's colour ignored
+// Table fields (all optional): scale (both), scale_x, scale_y, angle,
+// rot_center_x, rot_center_y (0.0 to 1.0 of the cell), flip (SDL_RendererFlip),
+// colour (a simple colour or SDL_Color, otherwise the current foreground
+// colour) and alpha (0 to 255). The fields can be changed afterwards as well.
+class DrawStyle
+{
+public:
+	explicit DrawStyle(luabridge::LuaRef attrs);
+
+	void set_colour(simple_colour_t c);
+	void set_fullcolour(const SDL_Colour& c);
+	void clear_colour() { has_colour = false; }
+
+	double scale_x;
+	double scale_y;
+	double angle;
+	double rot_center_x;
+	double rot_center_y;
+	int flip;
+	int alpha;
+	bool has_colour;
+	SDL_Colour colour;
+};
+
+#endif
@@ -0,0 +1,162 @@
+/*
+ * ElementPool.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#include "ElementPool.h"
+#include "Utilities.h"
+#include <algorithm>
+
+static std::vector<FixedBlockPool*>& pool_registry()
+{
+	static std::vector<FixedBlockPool*> pools;
+	return pools;
+}
+
+const std::vector<FixedBlockPool*>& FixedBlockPool::get_pools()
+{
+	return pool_registry();
+}
+
+FixedBlockPool::FixedBlockPool(const char* name_in, size_t block_size_in, size_t blocks_per_slab_in, bool show_in_debug)
+: name(name_in)
+, block_size(block_size_in)
+, blocks_per_slab(blocks_per_slab_in)
+, free_list(0)
+, in_use(0)
+, high_water(0)
+, registered(show_in_debug)
+{
+	// each free block has to be able to hold the free list link, and keep
+	// the blocks after it aligned
+	const size_t align = sizeof(void*) > sizeof(double) ? sizeof(void*) : sizeof(double);
+	if(block_size < sizeof(free_block))
+	{
+		block_size = sizeof(free_block);
+	}
+	block_size = (block_size + align - 1) & ~(align - 1);
+	if(blocks_per_slab == 0)
+	{
+		blocks_per_slab = 1;
+	}
+	if(registered)
+	{
+		pool_registry().push_back(this);
+	}
+}
+
+FixedBlockPool::~FixedBlockPool()
+{
+	if(registered)
+	{
+		std::vector<FixedBlockPool*>& pools = pool_registry();
+		pools.erase(std::remove(pools.begin(), pools.end(), this), pools.end());
+	}
+
+	// if things are still using blocks we leak the slabs rather than pull
+	// memory out from underneath them
+	trim();
+}
+
+void FixedBlockPool::add_slab()
+{
+	char* slab = static_cast<char*>(::operator new(block_size * blocks_per_slab));
+	slabs.push_back(slab);
+
+	// thread the new blocks onto the front of the free list
+	for(size_t i = blocks_per_slab; i > 0; i--)
+	{
+		free_block* b = reinterpret_cast<free_block*>(slab + (i-1) * block_size);
+		b->next = free_list;
+		free_list = b;
+	}
+}
+
+void* FixedBlockPool::allocate()
+{
+	if(free_list == 0)
+	{
+		add_slab();
+	}
+	free_block* b = free_list;
+	free_list = b->next;
+
+	in_use++;
+	if(in_use > high_water)
+	{
+		high_water = in_use;
+	}
+	return b;
+}
+
+void FixedBlockPool::deallocate(void* p)
+{
+	if(p == 0) return;
+	if(in_use == 0)
+	{
+		Utilities::fatalError("FixedBlockPool %s - deallocate with no blocks in use", name);
+	}
+	free_block* b = static_cast<free_block*>(p);
+	b->next = free_list;
+	free_list = b;
+	in_use--;
+}
+
+void FixedBlockPool::build_free_list()
+{
+	free_list = 0;
+	for(size_t s = 0; s < slabs.size(); s++)
+	{
+		char* slab = slabs[s];
+		for(size_t i = blocks_per_slab; i > 0; i--)
+		{
+			free_block* b = reinterpret_cast<free_block*>(slab + (i-1) * block_size);
+			b->next = free_list;
+			free_list = b;
+		}
+	}
+}
+
+void FixedBlockPool::release_all()
+{
+	build_free_list();
+	in_use = 0;
+}
+
+void FixedBlockPool::trim()
+{
+	if(in_use != 0) return;
+
+	for(size_t s = 0; s < slabs.size(); s++)
+	{
+		::operator delete(slabs[s]);
+	}
+	slabs.clear();
+	free_list = 0;
+}
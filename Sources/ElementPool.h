@@ -0,0 +1,157 @@
+/*
+ * ElementPool.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#ifndef ELEMENTPOOL_H_
+#define ELEMENTPOOL_H_
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Fixed block pool allocator. Used for things that are created and destroyed
+// a lot while the game is running (draw list elements, list nodes, map cells)
+// so that we don't churn malloc/free and fragment the heap.
+//
+// Memory is taken in slabs of blocks_per_slab blocks, and never given back to
+// the system until trim() is called or the pool is destroyed.
+//
+// NOTE: Not thread safe. All the current users are on the UI thread.
+class FixedBlockPool
+{
+public:
+	// show_in_debug=false keeps it off the debug display, and out of the (UI
+	// thread only) list of pools, so it can be created on any thread
+	FixedBlockPool(const char* name, size_t block_size, size_t blocks_per_slab, bool show_in_debug=true);
+	~FixedBlockPool();
+
+	void* allocate();
+	void deallocate(void* p);
+
+	// Return every block to the free list in one go. The caller must already
+	// have destroyed any objects living in the blocks.
+	void release_all();
+	// give slabs back to the system (only possible if nothing is in use)
+	void trim();
+
+	const char* get_name() { return name; }
+	size_t get_block_size() { return block_size; }
+	size_t get_in_use() { return in_use; }
+	size_t get_capacity() { return slabs.size() * blocks_per_slab; }
+	size_t get_high_water() { return high_water; }
+
+	// all the pools currently alive, for the debug display
+	static const std::vector<FixedBlockPool*>& get_pools();
+
+private:
+	// lets not have these copy constructed or assigned
+	FixedBlockPool(const FixedBlockPool&);
+	FixedBlockPool& operator=(const FixedBlockPool&);
+
+	struct free_block { free_block* next; };
+	void add_slab();
+	void build_free_list();
+
+	const char* name;
+	size_t block_size;
+	size_t blocks_per_slab;
+	std::vector<char*> slabs;
+	free_block* free_list;
+	size_t in_use;
+	size_t high_water;
+	bool registered;
+};
+
+
+// One pool per (tag, size) pair. The tag gives the pool a name for the debug
+// display and keeps different users of the same node size apart, so the
+// occupancy counters are per-type.
+template<class Tag, size_t S> FixedBlockPool& tagged_pool()
+{
+	static FixedBlockPool* pool = new FixedBlockPool(Tag::name(), S, Tag::blocks_per_slab);
+	// deliberately never deleted: static containers can still hand nodes back
+	// while the program is exiting.
+	return *pool;
+}
+
+
+// STL allocator on top of tagged_pool<>, for std::list node allocation.
+// Single objects come from the pool, arrays (which lists don't ask for)
+// fall back to the normal heap.
+template<class T, class Tag> class PoolAllocator
+{
+public:
+	typedef T value_type;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+	template<class U> struct rebind { typedef PoolAllocator<U, Tag> other; };
+
+	PoolAllocator() {}
+	template<class U> PoolAllocator(const PoolAllocator<U, Tag>&) {}
+
+	pointer allocate(size_type n, const void* = 0)
+	{
+		if(n == 1)
+		{
+			return static_cast<pointer>(tagged_pool<Tag, sizeof(T)>().allocate());
+		}
+		return static_cast<pointer>(::operator new(n * sizeof(T)));
+	}
+	void deallocate(pointer p, size_type n)
+	{
+		if(n == 1)
+		{
+			tagged_pool<Tag, sizeof(T)>().deallocate(p);
+			return;
+		}
+		::operator delete(p);
+	}
+
+	pointer address(reference r) const { return &r; }
+	const_pointer address(const_reference r) const { return &r; }
+	size_type max_size() const { return size_t(-1) / sizeof(T); }
+	template<class U, class... Args> void construct(U* p, Args&&... args) { ::new((void*)p) U(std::forward<Args>(args)...); }
+	template<class U> void destroy(U* p) { p->~U(); }
+};
+
+template<class T, class U, class Tag> bool operator==(const PoolAllocator<T, Tag>&, const PoolAllocator<U, Tag>&) { return true; }
+template<class T, class U, class Tag> bool operator!=(const PoolAllocator<T, Tag>&, const PoolAllocator<U, Tag>&) { return false; }
+
+
+// tags for the pools used by the draw lists
+struct dle_pool_tag { static const char* name() { return "DLE"; } static const size_t blocks_per_slab = 256; };
+struct md_pool_tag { static const char* name() { return "MD"; } static const size_t blocks_per_slab = 1024; };
+
+#endif /* ELEMENTPOOL_H_ */
@@ -30,6 +30,26 @@
  */
 
 #include "FrameRateLimiter.h"
+#include "Debug.h"
+#include "Trace.h"
+#include "lua.h"
+#ifdef _MSC_VER
+#include <ciso646>   // Visual Studio is not C++ standards complaint...
+#endif
+
+// leave this much of the frame for the scheduler / vsync
+static const Uint32 gc_reserve_ms = 1;
+// size of each incremental step (see lua_gc LUA_GCSTEP)
+static const int gc_step_kb = 8;
+// don't bother starting cycles for tiny heaps
+static const int gc_minimum_threshold_kb = 1024;
+// start a cycle when memory is this much of what was live after the last one
+static const int gc_start_percent = 200;
+// past this, collect for gc_overdue_ms every frame even if there's no time spare
+static const int gc_overdue_percent = 300;
+static const Uint32 gc_overdue_ms = 2;
+// Lua's own pause meanwhile, so it only steps in if we're not getting the chance
+static const int gc_backstop_pause = 400;
 
 
 // +---------------------------------------------------------------------------
@@ -50,11 +70,28 @@ void FrameRateLimiter::limit(bool vsync)
 		delay_required = target_frame_time - frame_time;
 	}
 	
+	if(gc_state)
+	{
+		// with vsync the frame time includes waiting for the vertical blank in
+		// SDL_RenderPresent, so the spare time is what was left when we got there
+		Uint32 time_available = delay_required;
+		if(vsync and present_start)
+		{
+			Uint32 work_time = present_start - start;
+			time_available = target_frame_time > work_time ? target_frame_time - work_time : 0;
+		}
+		Uint32 gc_start = SDL_GetTicks();
+		collect_garbage(time_available);
+		Uint32 gc_time = SDL_GetTicks() - gc_start;
+		delay_required = (delay_required > gc_time + 1) ? delay_required - gc_time : 1;
+	}
+
     if(vsync)
     {
         // should we make this optional based on very long times?
         //if(delay_required > 16)
         {
+            FF_TRACE_ZONE("sleep");
             // I wonder if the vsync yields back to system. If so, this is probably not
             // required... if it doesn't than platforms like MacOSX penalise tasks that
             // don't yield
@@ -65,9 +102,111 @@ void FrameRateLimiter::limit(bool vsync)
     }
     else
     {
+        FF_TRACE_ZONE("sleep");
         SDL_Delay(delay_required);
     }
 	start = SDL_GetTicks();
+	present_start = 0;
+}
+
+// +---------------------------------------------------------------------------
+// | TITLE: presenting
+// | AUTHOR(s): agent
+// | DATE STARTED: 19 Oct 2026
+// +
+// | DESCRIPTION: The frame is drawn, and about to wait for vsync (maybe).
+// +---------------------------------------------------------------------------
+void FrameRateLimiter::presenting()
+{
+	present_start = SDL_GetTicks();
+}
+
+// +---------------------------------------------------------------------------
+// | TITLE: collect_garbage
+// | AUTHOR(s): agent
+// | DATE STARTED: 19 Oct 2026
+// +
+// | DESCRIPTION: Once it's time for a cycle, step the Lua collector until
+// | the time runs out, or the cycle finishes. Recorded in the debug timings
+// | as the GC phase.
+// +---------------------------------------------------------------------------
+void FrameRateLimiter::collect_garbage(Uint32 time_available_ms)
+{
+	Uint64 freq = SDL_GetPerformanceFrequency();
+	Uint64 gc_start = SDL_GetPerformanceCounter();
+	int count_kb = lua_gc(gc_state, LUA_GCCOUNT, 0);
+	if(not gc_cycle_running and count_kb >= gc_start_kb())
+	{
+		gc_cycle_running = true;
+	}
+
+	Uint64 budget = 0;
+	if(gc_cycle_running and time_available_ms > gc_reserve_ms)
+	{
+		budget = (time_available_ms - gc_reserve_ms) * freq / 1000;
+	}
+	// falling behind - spread the rest over the next few frames, rather than
+	// finish it now in one long stop
+	if(gc_cycle_running and count_kb >= gc_start_kb() / gc_start_percent * gc_overdue_percent)
+	{
+		Uint64 overdue_budget = gc_overdue_ms * freq / 1000;
+		if(budget < overdue_budget) { budget = overdue_budget; }
+	}
+
+	int steps = 0;
+	Uint64 now = gc_start;
+	while(now - gc_start < budget)
+	{
+		steps++;
+		if(lua_gc(gc_state, LUA_GCSTEP, gc_step_kb))
+		{
+			// finished a cycle, so now we know how much is really live
+			gc_live_kb = lua_gc(gc_state, LUA_GCCOUNT, 0);
+			gc_cycle_running = false;
+			break;
+		}
+		now = SDL_GetPerformanceCounter();
+	}
+
+	Uint64 gc_end = SDL_GetPerformanceCounter();
+	debug.timing_gc(gc_start, gc_end, steps);
+	if(Trace::enabled()) { Trace::record("gc", gc_start, gc_end); }
+}
+
+// +---------------------------------------------------------------------------
+// | TITLE: set_lua_gc
+// | AUTHOR(s): agent
+// | DATE STARTED: 19 Oct 2026
+// +
+// | DESCRIPTION:
+// +---------------------------------------------------------------------------
+void FrameRateLimiter::set_lua_gc(lua_State* L, bool engine_paced)
+{
+	if(gc_state)
+	{
+		lua_gc(gc_state, LUA_GCSETPAUSE, gc_old_pause);
+		gc_state = 0;
+	}
+	if(L and engine_paced)
+	{
+		gc_state = L;
+		gc_old_pause = lua_gc(gc_state, LUA_GCSETPAUSE, gc_backstop_pause);
+		gc_live_kb = lua_gc(gc_state, LUA_GCCOUNT, 0);
+		gc_cycle_running = false;
+	}
+}
+
+// +---------------------------------------------------------------------------
+// | TITLE: gc_start_kb
+// | AUTHOR(s): agent
+// | DATE STARTED: 19 Oct 2026
+// +
+// | DESCRIPTION: Memory use at which the next cycle starts.
+// +---------------------------------------------------------------------------
+int FrameRateLimiter::gc_start_kb()
+{
+	int kb = gc_live_kb / 100 * gc_start_percent;
+	return kb < gc_minimum_threshold_kb ? gc_minimum_threshold_kb : kb;
 }
 
 // +---------------------------------------------------------------------------
@@ -94,7 +233,12 @@ void FrameRateLimiter::set(int frames_per_second)
 FrameRateLimiter::FrameRateLimiter()
 : start(SDL_GetTicks())
 , end(SDL_GetTicks())
+, present_start(0)
 , vsync_throttle(1)
+, gc_state(0)
+, gc_live_kb(0)
+, gc_cycle_running(false)
+, gc_old_pause(gc_start_percent)
 {
 	set(60);		// default fps
 }
@@ -33,20 +33,42 @@
 #define FRAMTERATELIMITER_H
 
 #include "SDL.h"
+struct lua_State;
 
 class FrameRateLimiter
 {
 public:
 	void limit(bool vsync);
+	void presenting();			// just before SDL_RenderPresent, so vsync waits aren't counted as work
 	void set(int frames_per_second);
 	FrameRateLimiter();
     void test(int frames_per_second);
+
+	// Engine paced garbage collection. Once memory reaches double what it was
+	// after the last full cycle (Lua's default pause), limit() starts a cycle
+	// and runs incremental steps in whatever is left of each frame, before it
+	// sleeps. If frames have no time left and memory reaches triple, it does
+	// a few milliseconds a frame regardless. Lua's own collector is left
+	// running with a long pause, to catch anything that allocates a lot
+	// without returning to the main loop (e.g. a level load).
+	// L=0 or engine_paced=false hands collection back to Lua.
+	void set_lua_gc(lua_State* L, bool engine_paced);
+	bool get_lua_gc_engine_paced() { return gc_state != 0; }
 private:
+	void collect_garbage(Uint32 time_available_ms);
+	int gc_start_kb();
+
 	int fps_target;
 	Uint32 target_frame_time;
 	Uint32 start;
 	Uint32 end;
+	Uint32 present_start;		// 0 if this frame hasn't presented
     Uint32 vsync_throttle;
+
+	lua_State* gc_state;
+	int gc_live_kb;				// after the last cycle finished
+	bool gc_cycle_running;
+	int gc_old_pause;			// to give back to Lua
 };
 
 
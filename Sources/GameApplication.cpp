@@ -34,6 +34,12 @@
 #include "GameToScreenMapping.h"
 #include "Utilities.h"
 #include "LuaCppInterface.h"
+#include "LuaBytecodeCache.h"
+#include "AssetArchive.h"
+#include "VirtualFileSystem.h"
+#include "Trace.h"
+#include "MetricsServer.h"
+#include "AppResourcePath.h"
 
 #include <iostream>
 #include <stdio.h>
@@ -72,17 +78,21 @@ void GameApplication::render(SDL_Renderer *renderer, MyGraphics& graphics)
 	get_rgb_from_simple_colour(&c, fill_background_colour);
 	graphics.clear_screen(c);
 
+    TraceZone draw_zone("draw");
     luabridge::push(lua_user_interface, &graphics);
     run_gulp_function_if_exists(&lua_user_interface, "draw", 1);
     
     debug.print(graphics);
+    draw_zone.end();
 
     // ((done from Lua))
 	// draw UI elements etc
 	//absolute_draw_list.render(graphics, 0);
 
 	debug.timing_prerender();
+    frame_rate_limit.presenting();
     /* update screen */
+    FF_TRACE_ZONE("present");
     SDL_RenderPresent(renderer);
 }
 
@@ -108,6 +118,12 @@ void GameApplication::setup_ff_lua_state(LuaMain* l) //, int argc, char* argv[])
     L.library_init();
     set_up_basic_ff_libraries(l);
     load_conf_file(l);
+
+    // conf.lua has set up where saves go, so the bytecode cache can use it
+    LuaBytecodeCache::save_path_ready();
+
+    // ... and LoadPath can stop probing the disk for every file
+    VirtualFileSystem::build_index();
 }
 
 
@@ -115,6 +131,15 @@ int GameApplication::main(int argc, char* argv[])
 {
     game_argc = argc;
     game_argv = argv;
+    Uint64 startup_start = SDL_GetPerformanceCounter();
+    FF_TRACE_THREAD_NAME("main");
+
+    // all of data/ can be packed into one archive (see Tools/ffpack.cpp).
+    // Android mounts its own from the APK.
+    if(not AssetArchive::any_mounted())
+    {
+        AssetArchive::mount(AppResourcePath("assets.ffpk").str());
+    }
 
     absolute_draw_list.set_size(32);
 
@@ -187,14 +212,26 @@ int GameApplication::main(int argc, char* argv[])
 	run_gulp_function_if_exists(&lua_user_interface, "load", 1);	// called once on game load
 
 
+	// from now on collect garbage in the spare time at the end of each frame,
+	// rather than whenever an allocation in the middle of draw decides to
+	frame_rate_limit.set_lua_gc(lua_user_interface, true);
+
+	// compare runs with the bytecode cache cold (first run, or scripts changed) and warm
+	double startup_ms = double(SDL_GetPerformanceCounter() - startup_start) * 1000.0 / SDL_GetPerformanceFrequency();
+	Utilities::debugMessage("Startup took %.1fms - %d scripts from bytecode cache, %d compiled, %.1fms loading scripts",
+							startup_ms, LuaBytecodeCache::get_hits(), LuaBytecodeCache::get_compiles(), LuaBytecodeCache::get_load_ms());
+
     /* Enter render loop, waiting for user to quit */
     done = false;
     SDL_Event event;
     while (!done)
     {
+		FF_TRACE_ZONE("frame");
 		debug.timing_loop_start();
+		TraceZone events_zone("events");
         while (SDL_PollEvent(&event))
 		{
+			debug.count_event();
             if (event.type == SDL_QUIT)
 			{
                 run_gulp_function_if_exists(&lua_user_interface, "quit_event");
@@ -339,6 +376,10 @@ int GameApplication::main(int argc, char* argv[])
         }
 
 		lua_user_interface.process_console();
+		MetricsServer::poll(graphics);
+		events_zone.end();
+		debug.timing_events_done();
+		TraceZone update_zone("update");
 		//
 		// update the timestep
 		//
@@ -365,9 +406,14 @@ int GameApplication::main(int argc, char* argv[])
 		// handle touch gestures
 		touch_gesture_update(tick_step);
 
+		// advance engine side animations before Lua sees the new frame
+		tweens.update(tick_step);
+
 		// and update lua
 		lua_pushnumber(lua_user_interface, tick_step);
 		run_gulp_function_if_exists(&lua_user_interface, "update", 1);
+		update_zone.end();
+		debug.timing_update_done();
       
       if(gui_enabled)
       {
@@ -379,6 +425,7 @@ int GameApplication::main(int argc, char* argv[])
     }
 
 	run_gulp_function_if_exists(&lua_user_interface, "quit");
+	MetricsServer::stop();
 	delete graphics;
 	return 0;
 }
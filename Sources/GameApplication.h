@@ -51,6 +51,7 @@ class ControllerBaseType;
 #include <set>
 #include "lua.h"
 #include "Clickable.h"
+#include "Tween.h"
 
 class MyGraphics_record;
 
@@ -99,10 +100,13 @@ public:
     MyGraphics_render* get_standard_graphics_context();
     void set_background_colour(simple_colour_t c);
     void fps_test(int frames_per_second) { frame_rate_limit.test(frames_per_second); }
+    // true = Lua GC runs in spare frame time (the default), false = Lua's own automatic GC
+    void set_engine_gc(bool engine_paced) { frame_rate_limit.set_lua_gc(lua_user_interface, engine_paced); }
 
     void SetRenderer(SDL_Renderer *renderer_in, bool vsync_guess);
 
     lua_State* get_ui_lua_state(){return lua_user_interface.get_internal_state();};
+    TweenManager& get_tweens() { return tweens; }
 
     void verbose_engine(bool enabled);
     const char* return_copyright() { return copyright; }
@@ -150,6 +154,10 @@ private:
 
     bool _engine_verbose = false;
 
+    // draw list element tweens - these hold Lua callbacks and are told
+    // when elements die, so must outlive lua_user_interface
+    TweenManager tweens;
+
     // relies on things like mouse_target_list .. to create last, and importantly
     // destroy FIRST
     LuaMain lua_user_interface;
@@ -148,7 +148,31 @@ static const int cell_size_lower_limit = 8;
 // 0.84 - More character flexibility
 // 0.85 - PresentationMaze::update_glyph()
 // 0.86 - PresentationMaze::update_layer()
-#define FORLORN_FOX_ENGINE_VERSION 0.86
+// 0.87 - ParticleEmitter
+// 0.88 - DrawListElement tweens, glyph animation and alpha
+// 0.89 - LightMap on PresentationMaze
+// 0.90 - GridCollision
+// 0.91 - LuaStateQueue lock-free ring, try_send(), benchmark()
+// 0.92 - LuaBroadcastChannel and LuaBroadcastSubscriber
+// 0.93 - LuaStateQueue.select()
+// 0.94 - LuaJobSystem
+// 0.95 - LuaSharedTable
+// 0.96 - LuaAllocator, pooled Lua state memory with per-state counts
+// 0.97 - Engine paced Lua GC in frame idle time
+// 0.98 - Lua bytecode cache
+// 0.99 - AssetArchive packed assets and ffpack tool
+// 1.00 - VirtualFileSystem index for LoadPath
+// 1.01 - LuaProfiler sampling profiler with flamegraph export
+// 1.02 - Trace zones with Chrome trace export
+// 1.03 - HitchDetector frame percentiles and hitch captures
+// 1.04 - AllocationTracker heap counts per frame and phase, texture memory
+// 1.05 - MetricsServer, Prometheus text engine counters on a local socket
+// 1.06 - MyGraphics print_run and GlyphArray, a glyph run in one call
+// 1.07 - DrawStyle for printExT and print_styled (printEx from Lua)
+// 1.08 - DisplayList, MyGraphics calls recorded once and replayed natively
+// 1.09 - TextLayoutCache, print_string layouts kept in an LRU
+// 1.10 - LuaFastCall thunks for hot LuaBridge methods, LuaFastCall.benchmark
+#define FORLORN_FOX_ENGINE_VERSION 1.10
 const double forlorn_fox_engine_version = FORLORN_FOX_ENGINE_VERSION;
 
 #endif
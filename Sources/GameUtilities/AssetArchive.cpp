@@ -0,0 +1,564 @@
+/*
+ * AssetArchive.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#include "AssetArchive.h"
+#include "AppResourcePath.h"
+#include "Utilities.h"
+#include "lodepng.h"
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+#ifdef _MSC_VER
+#include <ciso646>   // Visual Studio is not C++ standards complaint...
+#endif
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+static const char archive_magic[4] = { 'F', 'F', 'P', 'K' };
+static const Uint32 archive_version = 1;
+static const size_t header_size = 24;
+static const size_t index_entry_size = 32;
+static const size_t data_alignment = 16;
+static const Uint16 flag_compressed = 1;
+
+// the most recently mounted first
+static std::vector<AssetArchive*>& mounted()
+{
+	static std::vector<AssetArchive*> archives;
+	return archives;
+}
+
+static Uint32 get_u32(const char* p) { Uint32 v; memcpy(&v, p, 4); return SDL_SwapLE32(v); }
+static Uint16 get_u16(const char* p) { Uint16 v; memcpy(&v, p, 2); return SDL_SwapLE16(v); }
+static Uint64 get_u64(const char* p) { Uint64 v; memcpy(&v, p, 8); return SDL_SwapLE64(v); }
+static void put_u32(std::string& s, Uint32 v) { v = SDL_SwapLE32(v); s.append(reinterpret_cast<const char*>(&v), 4); }
+static void put_u16(std::string& s, Uint16 v) { v = SDL_SwapLE16(v); s.append(reinterpret_cast<const char*>(&v), 2); }
+static void put_u64(std::string& s, Uint64 v) { v = SDL_SwapLE64(v); s.append(reinterpret_cast<const char*>(&v), 8); }
+
+
+AssetArchive::AssetArchive()
+: base(0)
+, length(0)
+, index(0)
+, names(0)
+, entry_count(0)
+, map_address(0)
+, map_length(0)
+#ifdef _WIN32
+, file_handle(INVALID_HANDLE_VALUE)
+, mapping_handle(0)
+#endif
+{
+}
+
+AssetArchive::~AssetArchive()
+{
+#ifdef _WIN32
+	if(map_address) { UnmapViewOfFile(map_address); }
+	if(mapping_handle) { CloseHandle(mapping_handle); }
+	if(file_handle != INVALID_HANDLE_VALUE) { CloseHandle(file_handle); }
+#else
+	if(map_address) { munmap(map_address, map_length); }
+#endif
+}
+
+bool AssetArchive::open_file(const std::string& path)
+{
+	description = path;
+#ifdef _WIN32
+	file_handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+	if(file_handle == INVALID_HANDLE_VALUE) { return false; }
+	LARGE_INTEGER size;
+	if(not GetFileSizeEx(file_handle, &size) or size.QuadPart == 0) { return false; }
+	mapping_handle = CreateFileMappingA(file_handle, 0, PAGE_READONLY, 0, 0, 0);
+	if(mapping_handle == 0) { return false; }
+	map_address = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+	if(map_address == 0) { return false; }
+	map_length = static_cast<size_t>(size.QuadPart);
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+	if(fd < 0) { return false; }
+	struct stat st;
+	if(fstat(fd, &st) != 0 or st.st_size == 0)
+	{
+		close(fd);
+		return false;
+	}
+	void* p = mmap(0, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);		// the mapping keeps the file
+	if(p == MAP_FAILED) { return false; }
+	map_address = p;
+	map_length = static_cast<size_t>(st.st_size);
+#ifdef MADV_WILLNEED
+	// start reading it all in now, in big sequential reads, rather than a
+	// page fault at a time as assets are used
+	madvise(map_address, map_length, MADV_WILLNEED);
+#endif
+#endif
+	return attach(static_cast<const char*>(map_address), map_length);
+}
+
+bool AssetArchive::attach(const char* data, size_t data_length)
+{
+	if(data_length < header_size or memcmp(data, archive_magic, sizeof(archive_magic)) != 0)
+	{
+		return false;
+	}
+	if(get_u32(data+4) != archive_version)
+	{
+		Utilities::debugMessage("AssetArchive %s is version %u, expected %u", description.c_str(), get_u32(data+4), archive_version);
+		return false;
+	}
+	Uint32 count = get_u32(data+8);
+	Uint64 index_offset = get_u64(data+16);
+	if(index_offset > data_length or (data_length - index_offset) / index_entry_size < count)
+	{
+		Utilities::debugMessage("AssetArchive %s is damaged (bad index)", description.c_str());
+		return false;
+	}
+	base = data;
+	length = data_length;
+	entry_count = count;
+	index = data + index_offset;
+	names = index + static_cast<size_t>(count) * index_entry_size;
+
+	// check every entry is inside the file, so lookups don't need to
+	size_t names_length = length - (names - base);
+	for(Uint32 i = 0; i < entry_count; i++)
+	{
+		const char* p = index + i * index_entry_size;
+		Uint64 offset = get_u64(p);
+		Uint64 stored = get_u64(p+8);
+		Uint64 size = get_u64(p+16);
+		Uint32 name_offset = get_u32(p+24);
+		Uint16 name_length = get_u16(p+28);
+		Uint16 flags = get_u16(p+30);
+		// an uncompressed entry is used straight from the file at its full size
+		bool bad_size = not (flags & flag_compressed) and size != stored;
+		if(offset > length or stored > length - offset or bad_size or name_offset > names_length or name_length > names_length - name_offset)
+		{
+			Utilities::debugMessage("AssetArchive %s is damaged (entry %u)", description.c_str(), i);
+			base = 0;
+			return false;
+		}
+	}
+	return true;
+}
+
+bool AssetArchive::find(const std::string& name, Entry& e)
+{
+	// binary search of the sorted index
+	Uint32 low = 0;
+	Uint32 high = entry_count;
+	while(low < high)
+	{
+		Uint32 mid = low + (high - low) / 2;
+		const char* p = index + mid * index_entry_size;
+		Uint32 name_offset = get_u32(p+24);
+		Uint16 name_length = get_u16(p+28);
+		size_t common = std::min<size_t>(name_length, name.size());
+		int c = memcmp(names + name_offset, name.data(), common);
+		if(c == 0) { c = (name_length < name.size()) ? -1 : (name_length > name.size() ? 1 : 0); }
+		if(c == 0)
+		{
+			e.offset = get_u64(p);
+			e.stored_size = get_u64(p+8);
+			e.size = get_u64(p+16);
+			e.name_offset = name_offset;
+			e.name_length = name_length;
+			e.flags = get_u16(p+30);
+			return true;
+		}
+		if(c < 0) { low = mid + 1; } else { high = mid; }
+	}
+	return false;
+}
+
+bool AssetArchive::get(const Entry& e, AssetData& out)
+{
+	const unsigned char* stored = reinterpret_cast<const unsigned char*>(base + e.offset);
+	if(e.flags & flag_compressed)
+	{
+		out.storage.clear();
+		unsigned error = lodepng::decompress(out.storage, stored, static_cast<size_t>(e.stored_size));
+		if(error or out.storage.size() != e.size)
+		{
+			Utilities::debugMessage("AssetArchive %s - couldn't decompress entry: %s", description.c_str(), error ? lodepng_error_text(error) : "wrong size");
+			return false;
+		}
+		out.data = reinterpret_cast<const char*>(out.storage.empty() ? 0 : &out.storage[0]);
+		out.size = out.storage.size();
+	}
+	else
+	{
+		out.storage.clear();
+		out.data = base + e.offset;
+		out.size = static_cast<size_t>(e.size);
+	}
+	return true;
+}
+
+
+//
+// Mounting
+//
+bool AssetArchive::mount(const std::string& path)
+{
+	AssetArchive* a = new AssetArchive;
+	if(not a->open_file(path))
+	{
+		delete a;
+		return false;
+	}
+	mounted().insert(mounted().begin(), a);
+	Utilities::debugMessage("AssetArchive mounted %s (%u entries)", path.c_str(), a->entry_count);
+	return true;
+}
+
+bool AssetArchive::mount_rw(SDL_RWops* rw, const std::string& description)
+{
+	if(rw == 0) { return false; }
+	AssetArchive* a = new AssetArchive;
+	a->description = description;
+
+	// one big read
+	Sint64 size = SDL_RWsize(rw);
+	bool ok = size > 0;
+	if(ok)
+	{
+		a->memory.resize(static_cast<size_t>(size));
+		ok = SDL_RWread(rw, &a->memory[0], a->memory.size(), 1) == 1;
+	}
+	SDL_RWclose(rw);
+	if(not ok or not a->attach(&a->memory[0], a->memory.size()))
+	{
+		delete a;
+		return false;
+	}
+	mounted().insert(mounted().begin(), a);
+	Utilities::debugMessage("AssetArchive mounted %s (%u entries)", description.c_str(), a->entry_count);
+	return true;
+}
+
+void AssetArchive::unmount_all()
+{
+	for(size_t i = 0; i < mounted().size(); i++)
+	{
+		delete mounted()[i];
+	}
+	mounted().clear();
+}
+
+bool AssetArchive::any_mounted()
+{
+	return not mounted().empty();
+}
+
+
+//
+// Lookups
+//
+bool AssetArchive::exists(const std::string& name)
+{
+	Entry e;
+	for(size_t i = 0; i < mounted().size(); i++)
+	{
+		if(mounted()[i]->find(name, e)) { return true; }
+	}
+	return false;
+}
+
+bool AssetArchive::read(const std::string& name, AssetData& out)
+{
+	Entry e;
+	for(size_t i = 0; i < mounted().size(); i++)
+	{
+		if(mounted()[i]->find(name, e))
+		{
+			return mounted()[i]->get(e, out);
+		}
+	}
+	return false;
+}
+
+void AssetArchive::list(std::vector<std::string>& list, std::vector<Uint64>* sizes)
+{
+	for(size_t i = 0; i < mounted().size(); i++)
+	{
+		AssetArchive* a = mounted()[i];
+		for(Uint32 n = 0; n < a->entry_count; n++)
+		{
+			const char* p = a->index + n * index_entry_size;
+			list.push_back(std::string(a->names + get_u32(p+24), get_u16(p+28)));
+			if(sizes) { sizes->push_back(get_u64(p+16)); }
+		}
+	}
+}
+
+// An SDL_RWops over a decompressed copy, freed when it's closed
+namespace {
+	struct OwnedBuffer
+	{
+		std::vector<unsigned char> bytes;
+		size_t position;
+	};
+
+	OwnedBuffer* owned(SDL_RWops* rw) { return static_cast<OwnedBuffer*>(rw->hidden.unknown.data1); }
+
+	Sint64 SDLCALL owned_size(SDL_RWops* rw)
+	{
+		return static_cast<Sint64>(owned(rw)->bytes.size());
+	}
+
+	Sint64 SDLCALL owned_seek(SDL_RWops* rw, Sint64 offset, int whence)
+	{
+		OwnedBuffer* b = owned(rw);
+		Sint64 position;
+		switch(whence)
+		{
+			case RW_SEEK_SET: position = offset; break;
+			case RW_SEEK_CUR: position = static_cast<Sint64>(b->position) + offset; break;
+			case RW_SEEK_END: position = static_cast<Sint64>(b->bytes.size()) + offset; break;
+			default: return SDL_SetError("Unknown value for 'whence'");
+		}
+		if(position < 0) { position = 0; }
+		if(position > static_cast<Sint64>(b->bytes.size())) { position = static_cast<Sint64>(b->bytes.size()); }
+		b->position = static_cast<size_t>(position);
+		return position;
+	}
+
+	size_t SDLCALL owned_read(SDL_RWops* rw, void* ptr, size_t size, size_t maxnum)
+	{
+		OwnedBuffer* b = owned(rw);
+		if(size == 0) { return 0; }
+		size_t available = (b->bytes.size() - b->position) / size;
+		size_t num = std::min(available, maxnum);
+		if(num)
+		{
+			memcpy(ptr, &b->bytes[b->position], num * size);
+			b->position += num * size;
+		}
+		return num;
+	}
+
+	size_t SDLCALL owned_write(SDL_RWops* rw, const void* ptr, size_t size, size_t num)
+	{
+		(void)rw; (void)ptr; (void)size; (void)num;
+		SDL_SetError("Can't write to an archive entry");
+		return 0;
+	}
+
+	int SDLCALL owned_close(SDL_RWops* rw)
+	{
+		delete owned(rw);
+		SDL_FreeRW(rw);
+		return 0;
+	}
+}
+
+SDL_RWops* AssetArchive::open_rw(const std::string& name)
+{
+	AssetData asset;
+	if(not read(name, asset)) { return 0; }
+
+	if(asset.storage.empty())
+	{
+		// in the archive as it is, so no copy
+		return SDL_RWFromConstMem(asset.data, static_cast<int>(asset.size));
+	}
+
+	SDL_RWops* rw = SDL_AllocRW();
+	if(rw == 0) { return 0; }
+	OwnedBuffer* b = new OwnedBuffer;
+	b->bytes.swap(asset.storage);
+	b->position = 0;
+	rw->size = owned_size;
+	rw->seek = owned_seek;
+	rw->read = owned_read;
+	rw->write = owned_write;
+	rw->close = owned_close;
+	rw->type = SDL_RWOPS_UNKNOWN;
+	rw->hidden.unknown.data1 = b;
+	return rw;
+}
+
+
+//
+// Full paths
+//
+bool AssetArchive::name_from_path(const char* path, std::string& name)
+{
+	if(mounted().empty() or path == 0) { return false; }
+
+	std::string root = AppResourcePath("").str();
+	std::string p = path;
+	std::replace(root.begin(), root.end(), '\\', '/');
+	std::replace(p.begin(), p.end(), '\\', '/');
+	if(p.size() <= root.size() or p.compare(0, root.size(), root) != 0)
+	{
+		return false;
+	}
+	name = p.substr(root.size());
+	return true;
+}
+
+bool AssetArchive::exists_path(const char* path)
+{
+	std::string name;
+	return name_from_path(path, name) and exists(name);
+}
+
+bool AssetArchive::read_path(const char* path, AssetData& out)
+{
+	std::string name;
+	return name_from_path(path, name) and read(name, out);
+}
+
+SDL_RWops* AssetArchive::open_rw_path(const char* path)
+{
+	std::string name;
+	if(not name_from_path(path, name)) { return 0; }
+	return open_rw(name);
+}
+
+
+//
+// Writing
+//
+static bool already_compressed(const std::string& name)
+{
+	static const char* extensions[] = { ".png", ".ogg", ".mp3", ".jpg", ".zip", ".ffpk" };
+	for(size_t i = 0; i < sizeof(extensions)/sizeof(extensions[0]); i++)
+	{
+		size_t n = strlen(extensions[i]);
+		if(name.size() >= n)
+		{
+			std::string end = name.substr(name.size() - n);
+			std::transform(end.begin(), end.end(), end.begin(), ::tolower);
+			if(end == extensions[i]) { return true; }
+		}
+	}
+	return false;
+}
+
+std::string AssetArchive::pack(const std::string& archive_path, const std::string& root_dir,
+							   std::vector<std::string> entry_names, bool compress)
+{
+	std::sort(entry_names.begin(), entry_names.end());
+	entry_names.erase(std::unique(entry_names.begin(), entry_names.end()), entry_names.end());
+
+	FILE* out = fopen(archive_path.c_str(), "wb");
+	if(out == 0) { return "Couldn't create " + archive_path; }
+
+	std::string header(archive_magic, sizeof(archive_magic));
+	put_u32(header, archive_version);
+	put_u32(header, static_cast<Uint32>(entry_names.size()));
+	put_u32(header, 0);
+	put_u64(header, 0);		// index offset, filled in at the end
+	fwrite(header.data(), 1, header.size(), out);
+
+	std::string index;
+	std::string name_block;
+	Uint64 position = header.size();
+	std::string error;
+	for(size_t i = 0; i < entry_names.size() and error.empty(); i++)
+	{
+		const std::string& name = entry_names[i];
+		if(name.size() > 0xFFFF) { error = "Name too long: " + name; break; }
+
+		std::vector<unsigned char> contents;
+		std::string full_path = root_dir + "/" + name;
+		FILE* in = fopen(full_path.c_str(), "rb");
+		if(in == 0) { error = "Couldn't read " + full_path; break; }
+		unsigned char buffer[16384];
+		size_t n;
+		while((n = fread(buffer, 1, sizeof(buffer), in)) > 0)
+		{
+			contents.insert(contents.end(), buffer, buffer + n);
+		}
+		fclose(in);
+
+		Uint16 flags = 0;
+		std::vector<unsigned char> packed;
+		if(compress and not already_compressed(name) and contents.size() > 64)
+		{
+			// only worth it if it saves at least 10%
+			if(lodepng::compress(packed, contents) == 0 and packed.size() < contents.size() - contents.size() / 10)
+			{
+				flags |= flag_compressed;
+			}
+		}
+		const std::vector<unsigned char>& stored = (flags & flag_compressed) ? packed : contents;
+
+		// align each entry
+		static const char zeros[data_alignment] = { 0 };
+		size_t padding = static_cast<size_t>((data_alignment - position % data_alignment) % data_alignment);
+		fwrite(zeros, 1, padding, out);
+		position += padding;
+
+		put_u64(index, position);
+		put_u64(index, stored.size());
+		put_u64(index, contents.size());
+		put_u32(index, static_cast<Uint32>(name_block.size()));
+		put_u16(index, static_cast<Uint16>(name.size()));
+		put_u16(index, flags);
+		name_block += name;
+
+		if(not stored.empty() and fwrite(&stored[0], 1, stored.size(), out) != stored.size())
+		{
+			error = "Couldn't write " + archive_path;
+		}
+		position += stored.size();
+	}
+
+	if(error.empty())
+	{
+		std::string index_offset;
+		put_u64(index_offset, position);
+		bool ok = fwrite(index.data(), 1, index.size(), out) == index.size();
+		ok = ok and fwrite(name_block.data(), 1, name_block.size(), out) == name_block.size();
+		ok = ok and fseek(out, 16, SEEK_SET) == 0;
+		ok = ok and fwrite(index_offset.data(), 1, index_offset.size(), out) == index_offset.size();
+		if(not ok) { error = "Couldn't write " + archive_path; }
+	}
+	if(fclose(out) != 0 and error.empty()) { error = "Couldn't write " + archive_path; }
+	if(not error.empty()) { remove(archive_path.c_str()); }
+	return error;
+}
@@ -0,0 +1,141 @@
+/*
+ * AssetArchive.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#ifndef ASSET_ARCHIVE_H
+#define ASSET_ARCHIVE_H
+
+#include "SDL.h"
+#include <string>
+#include <vector>
+
+// The bytes of one asset. Points straight into the archive when the entry is
+// stored uncompressed, otherwise owns a decompressed copy.
+class AssetData
+{
+public:
+	AssetData() : data(0), size(0) {}
+	const char* data;
+	size_t size;
+	std::vector<unsigned char> storage;		// only used for compressed entries
+private:
+	// lets not have these copy constructed or assigned
+	AssetData(const AssetData&);
+	AssetData& operator=(const AssetData&);
+};
+
+// Packed asset archive (.ffpk).
+//
+// All of the data directory in one file - a sorted index and then the
+// entries, each stored as is or zlib compressed. The archive is memory mapped
+// once when mounted (or read in one go where that's not possible, like
+// Android APK assets), and uncompressed entries are used in place.
+//
+// Names are relative to the data directory, e.g. "scripts/main.lua". The
+// *_path versions take a full path from AppResourcePath or LoadPath instead,
+// and only match files under the app resource directory - so anything in
+// the save data directory still overrides the archive.
+//
+// Archives are mounted at startup, before any other threads are running.
+// After that everything here is read only and can be used from any thread.
+//
+// File format (all little endian):
+//   header:  "FFPK", u32 version, u32 entry count, u32 0, u64 index offset
+//   data:    each entry, 16 byte aligned
+//   index:   entry count of { u64 offset, u64 stored size, u64 size,
+//            u32 name offset, u16 name length, u16 flags }, sorted by name
+//   names:   all the names, name offset is from the start of here
+class AssetArchive
+{
+public:
+	// later mounts are searched first. False if there's no archive there.
+	static bool mount(const std::string& path);
+	static bool mount_rw(SDL_RWops* rw, const std::string& description);	// reads all of it, closes rw
+	static void unmount_all();
+	static bool any_mounted();
+
+	static bool exists(const std::string& name);
+	static bool read(const std::string& name, AssetData& out);
+	static SDL_RWops* open_rw(const std::string& name);		// 0 if not in an archive
+
+	static bool name_from_path(const char* path, std::string& name);
+	static bool exists_path(const char* path);
+	static bool read_path(const char* path, AssetData& out);
+	static SDL_RWops* open_rw_path(const char* path);
+
+	// write an archive of the named files (relative to root_dir). Returns
+	// "" or an error message.
+	static std::string pack(const std::string& archive_path, const std::string& root_dir,
+							std::vector<std::string> names, bool compress);
+
+	// everything in the mounted archives, for building indexes. sizes are
+	// the uncompressed sizes.
+	static void list(std::vector<std::string>& names, std::vector<Uint64>* sizes = 0);
+
+private:
+	AssetArchive();
+	~AssetArchive();
+	// lets not have these copy constructed or assigned
+	AssetArchive(const AssetArchive&);
+	AssetArchive& operator=(const AssetArchive&);
+
+	struct Entry
+	{
+		Uint64 offset;
+		Uint64 stored_size;
+		Uint64 size;
+		Uint32 name_offset;
+		Uint16 name_length;
+		Uint16 flags;
+	};
+
+	bool open_file(const std::string& path);
+	bool attach(const char* data, size_t length);
+	bool find(const std::string& name, Entry& e);
+	bool get(const Entry& e, AssetData& out);
+
+	std::string description;
+	const char* base;
+	size_t length;
+	const char* index;
+	const char* names;
+	Uint32 entry_count;
+
+	// where base came from
+	std::vector<char> memory;
+	void* map_address;
+	size_t map_length;
+#ifdef _WIN32
+	void* file_handle;
+	void* mapping_handle;
+#endif
+};
+
+#endif
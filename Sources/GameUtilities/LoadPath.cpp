@@ -32,6 +32,7 @@
 #include "LoadPath.h"
 #include "AppResourcePath.h"
 #include "SaveDataPath.h"
+#include "VirtualFileSystem.h"
 #include "Utilities.h"
 #include <stdio.h>
 
@@ -62,6 +63,17 @@ std::string LoadPath::str()
 
 std::string LoadPath::resolve()
 {
+	// once the index is built it knows where everything is, without touching the disk
+	VirtualFileSystem::Location location = VirtualFileSystem::where(filename_store);
+	if(location == VirtualFileSystem::save_data)
+	{
+		return SaveDataPath(filename_store).str();
+	}
+	if(location != VirtualFileSystem::not_indexed)
+	{
+		return AppResourcePath(filename_store).str();
+	}
+
 	// look for the file in the preferences first...
 	SaveDataPath f1(filename_store);
 	const char* s = f1.c_str();
@@ -0,0 +1,535 @@
+/*
+ * VirtualFileSystem.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#include "VirtualFileSystem.h"
+#include "AppResourcePath.h"
+#include "SaveDataPath.h"
+#include "LoadPath.h"
+#include "AssetArchive.h"
+#include "Utilities.h"
+#include "lua.h"
+#include "lauxlib.h"
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+#ifdef _MSC_VER
+#include <ciso646>   // Visual Studio is not C++ standards complaint...
+#endif
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <dirent.h>
+	#include <sys/stat.h>
+#endif
+
+SDL_SpinLock VirtualFileSystem::index_lock = 0;
+VirtualFileSystem::index_t* VirtualFileSystem::the_index = 0;
+VirtualFileSystem::children_t* VirtualFileSystem::the_children = 0;
+
+static std::string normalise(const std::string& name)
+{
+	std::string n = name;
+	std::replace(n.begin(), n.end(), '\\', '/');
+	while(n.compare(0, 2, "./") == 0) { n.erase(0, 2); }
+	while(not n.empty() and *n.rbegin() == '/') { n.erase(n.size() - 1); }
+	return n;
+}
+
+static std::string parent_of(const std::string& name)
+{
+	size_t slash = name.rfind('/');
+	return slash == std::string::npos ? "" : name.substr(0, slash);
+}
+
+bool VirtualFileSystem::stat_file(const std::string& path, Entry& e)
+{
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA data;
+	if(not GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &data)) { return false; }
+	e.directory = (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+	e.size = (static_cast<Uint64>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+	// 100ns intervals since 1601 to seconds since 1970
+	Uint64 t = (static_cast<Uint64>(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+	e.modified = static_cast<Sint64>(t / 10000000ULL) - 11644473600LL;
+#else
+	struct stat st;
+	if(::stat(path.c_str(), &st) != 0) { return false; }
+	e.directory = S_ISDIR(st.st_mode);
+	e.size = static_cast<Uint64>(st.st_size);
+	e.modified = static_cast<Sint64>(st.st_mtime);
+#endif
+	return true;
+}
+
+// save data entries override the others. Parent directories are added as needed.
+void VirtualFileSystem::add(index_t& index, children_t& children, const std::string& name, const Entry& e)
+{
+	index_t::iterator it = index.find(name);
+	if(it == index.end())
+	{
+		index[name] = e;
+	}
+	else if(e.location == save_data and it->second.location != save_data)
+	{
+		Entry replacement = e;
+		replacement.also_in_app = not it->second.directory;
+		it->second = replacement;
+	}
+	else if(e.location == archive and it->second.location == app_resource)
+	{
+		it->second = e;		// loaders use the archive copy first
+	}
+	else
+	{
+		// already have this name (at least as good). The save data is
+		// scanned first, so this is where it finds out it's hiding a file.
+		if(it->second.location == save_data and e.location != save_data and not e.directory)
+		{
+			it->second.also_in_app = true;
+		}
+		return;
+	}
+
+	std::string parent = parent_of(name);
+	children[parent].insert(name);
+	if(not parent.empty() and index.find(parent) == index.end())
+	{
+		Entry dir;
+		dir.location = e.location;
+		dir.directory = true;
+		add(index, children, parent, dir);
+	}
+}
+
+void VirtualFileSystem::scan_directory(index_t& index, children_t& children, const std::string& root,
+									   const std::string& relative, Location location)
+{
+	std::string dir = root + relative;
+#ifdef _WIN32
+	WIN32_FIND_DATAA found;
+	HANDLE h = FindFirstFileA((dir + "*").c_str(), &found);
+	if(h == INVALID_HANDLE_VALUE) { return; }
+	do {
+		std::string name = found.cFileName;
+		if(name == "." or name == "..") continue;
+		Entry e;
+		e.location = location;
+		e.directory = (found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+		e.size = (static_cast<Uint64>(found.nFileSizeHigh) << 32) | found.nFileSizeLow;
+		Uint64 t = (static_cast<Uint64>(found.ftLastWriteTime.dwHighDateTime) << 32) | found.ftLastWriteTime.dwLowDateTime;
+		e.modified = static_cast<Sint64>(t / 10000000ULL) - 11644473600LL;
+		add(index, children, relative + name, e);
+		if(e.directory) { scan_directory(index, children, root, relative + name + "/", location); }
+	} while(FindNextFileA(h, &found));
+	FindClose(h);
+#else
+	DIR* d = opendir(dir.c_str());
+	if(d == 0) { return; }
+	while(struct dirent* entry = readdir(d))
+	{
+		std::string name = entry->d_name;
+		if(name == "." or name == "..") continue;
+		Entry e;
+		if(not stat_file(dir + name, e)) continue;
+		e.location = location;
+		add(index, children, relative + name, e);
+		if(e.directory) { scan_directory(index, children, root, relative + name + "/", location); }
+	}
+	closedir(d);
+#endif
+}
+
+void VirtualFileSystem::build_index()
+{
+	Uint64 start = SDL_GetPerformanceCounter();
+	index_t* index = new index_t;
+	children_t* children = new children_t;
+
+	// save data first, so it overrides
+	SaveDataPath save_root("");
+	if(save_root.c_str())
+	{
+		scan_directory(*index, *children, save_root.str(), "", save_data);
+	}
+
+	std::vector<std::string> names;
+	std::vector<Uint64> sizes;
+	AssetArchive::list(names, &sizes);
+	for(size_t i = 0; i < names.size(); i++)
+	{
+		Entry e;
+		e.location = archive;
+		e.size = sizes[i];
+		add(*index, *children, names[i], e);
+	}
+
+	scan_directory(*index, *children, AppResourcePath("").str(), "", app_resource);
+
+	SDL_AtomicLock(&index_lock);
+	std::swap(index, the_index);
+	std::swap(children, the_children);
+	size_t count = the_index->size();
+	SDL_AtomicUnlock(&index_lock);
+	delete index;		// the old ones
+	delete children;
+
+	double ms = double(SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+	Utilities::debugMessage("VirtualFileSystem indexed %lu files in %.1fms", static_cast<unsigned long>(count), ms);
+}
+
+bool VirtualFileSystem::is_indexed()
+{
+	SDL_AtomicLock(&index_lock);
+	bool result = the_index != 0;
+	SDL_AtomicUnlock(&index_lock);
+	return result;
+}
+
+bool VirtualFileSystem::lookup(const std::string& name, Entry& e)
+{
+	SDL_AtomicLock(&index_lock);
+	bool found = false;
+	if(the_index)
+	{
+		index_t::const_iterator it = the_index->find(name);
+		if(it != the_index->end())
+		{
+			e = it->second;
+			found = true;
+		}
+	}
+	SDL_AtomicUnlock(&index_lock);
+	return found;
+}
+
+VirtualFileSystem::Location VirtualFileSystem::where(const std::string& name)
+{
+	if(not is_indexed()) { return not_indexed; }
+	Entry e;
+	if(not lookup(normalise(name), e)) { return missing; }
+	return e.location;
+}
+
+void VirtualFileSystem::notify_written(const std::string& name_in)
+{
+	std::string name = normalise(name_in);
+	SaveDataPath path(name);
+	Entry e;
+	if(path.c_str() == 0 or not stat_file(path.str(), e))
+	{
+		notify_removed(name);
+		return;
+	}
+	e.location = save_data;
+
+	SDL_AtomicLock(&index_lock);
+	if(the_index)
+	{
+		index_t::iterator it = the_index->find(name);
+		if(it != the_index->end() and it->second.location == save_data)
+		{
+			e.also_in_app = it->second.also_in_app;
+			it->second = e;		// just an update
+		}
+		else
+		{
+			add(*the_index, *the_children, name, e);
+		}
+	}
+	SDL_AtomicUnlock(&index_lock);
+}
+
+void VirtualFileSystem::notify_removed(const std::string& name_in)
+{
+	std::string name = normalise(name_in);
+	Entry old;
+	if(not lookup(name, old) or old.location != save_data) { return; }
+
+	// was it hiding an app file? That's still there.
+	Entry app;
+	if(old.also_in_app)
+	{
+		app.location = AssetArchive::exists(name) ? archive : app_resource;
+		stat_file(AppResourcePath(name).str(), app);
+	}
+
+	SDL_AtomicLock(&index_lock);
+	if(old.also_in_app)
+	{
+		(*the_index)[name] = app;
+	}
+	else
+	{
+		the_index->erase(name);
+		(*the_children)[parent_of(name)].erase(name);
+	}
+	SDL_AtomicUnlock(&index_lock);
+}
+
+// name relative to the save data directory, false if it's not in there
+bool VirtualFileSystem::save_relative(const char* full_path, std::string& name)
+{
+	SaveDataPath root("");
+	if(full_path == 0 or root.c_str() == 0) { return false; }
+	std::string r = normalise(root.str()) + "/";
+	std::string p = normalise(full_path);
+	if(p.size() > r.size() and p.compare(0, r.size(), r) == 0)
+	{
+		name = p.substr(r.size());
+		return true;
+	}
+	return false;
+}
+
+void VirtualFileSystem::notify_written_path(const char* full_path)
+{
+	std::string name;
+	if(save_relative(full_path, name)) { notify_written(name); }
+}
+
+void VirtualFileSystem::notify_removed_path(const char* full_path)
+{
+	std::string name;
+	if(save_relative(full_path, name)) { notify_removed(name); }
+}
+
+std::string VirtualFileSystem::full_path(const std::string& name, const Entry& e)
+{
+	if(e.location == save_data) { return SaveDataPath(name).str(); }
+	return AppResourcePath(name).str();
+}
+
+
+//
+// Lua
+//
+static const char* location_names[] = { "missing", "save", "app", "archive" };
+
+int VirtualFileSystem::resolve(lua_State* L)
+{
+	std::string name = normalise(luaL_checkstring(L, 1));
+	Entry e;
+	if(lookup(name, e))
+	{
+		lua_pushstring(L, full_path(name, e).c_str());
+	}
+	else
+	{
+		lua_pushnil(L);
+	}
+	return 1;
+}
+
+int VirtualFileSystem::exists(lua_State* L)
+{
+	Entry e;
+	lua_pushboolean(L, lookup(normalise(luaL_checkstring(L, 1)), e));
+	return 1;
+}
+
+int VirtualFileSystem::stat(lua_State* L)
+{
+	Entry e;
+	if(not lookup(normalise(luaL_checkstring(L, 1)), e))
+	{
+		lua_pushnil(L);
+		return 1;
+	}
+	lua_createtable(L, 0, 4);
+	lua_pushnumber(L, static_cast<lua_Number>(e.size));
+	lua_setfield(L, -2, "size");
+	lua_pushnumber(L, static_cast<lua_Number>(e.modified));
+	lua_setfield(L, -2, "modified");
+	lua_pushboolean(L, e.directory);
+	lua_setfield(L, -2, "directory");
+	lua_pushstring(L, location_names[e.location]);
+	lua_setfield(L, -2, "location");
+	return 1;
+}
+
+int VirtualFileSystem::list(lua_State* L)
+{
+	std::string dir = normalise(luaL_optstring(L, 1, ""));
+	std::vector<std::string> names;
+	SDL_AtomicLock(&index_lock);
+	if(the_children)
+	{
+		children_t::const_iterator it = the_children->find(dir);
+		if(it != the_children->end())
+		{
+			names.assign(it->second.begin(), it->second.end());
+		}
+	}
+	SDL_AtomicUnlock(&index_lock);
+
+	// just the leaf names, like lfs.dir
+	size_t skip = dir.empty() ? 0 : dir.size() + 1;
+	lua_createtable(L, static_cast<int>(names.size()), 0);
+	for(size_t i = 0; i < names.size(); i++)
+	{
+		lua_pushstring(L, names[i].c_str() + skip);
+		lua_rawseti(L, -2, static_cast<int>(i + 1));
+	}
+	return 1;
+}
+
+// io.open can't see inside an archive, so this is how scripts read data
+// files that might be packed
+int VirtualFileSystem::read(lua_State* L)
+{
+	std::string name = normalise(luaL_checkstring(L, 1));
+	std::string path = LoadPath(name).str();
+	AssetData asset;
+	if(AssetArchive::read_path(path.c_str(), asset))
+	{
+		lua_pushlstring(L, asset.data, asset.size);
+		return 1;
+	}
+
+	FILE* f = fopen(path.c_str(), "rb");
+	if(f == 0)
+	{
+		lua_pushnil(L);
+		lua_pushfstring(L, "%s: %s", name.c_str(), strerror(errno));
+		return 2;
+	}
+	luaL_Buffer b;
+	luaL_buffinit(L, &b);
+	size_t n;
+	do {
+		char* p = luaL_prepbuffer(&b);
+		n = fread(p, 1, LUAL_BUFFERSIZE, f);
+		luaL_addsize(&b, n);
+	} while(n == LUAL_BUFFERSIZE);
+	bool failed = ferror(f) != 0;
+	fclose(f);
+	if(failed)
+	{
+		lua_pushnil(L);
+		lua_pushfstring(L, "%s: read error", name.c_str());
+		return 2;
+	}
+	luaL_pushresult(&b);
+	return 1;
+}
+
+int VirtualFileSystem::written(lua_State* L)
+{
+	notify_written(luaL_checkstring(L, 1));
+	return 0;
+}
+
+int VirtualFileSystem::removed(lua_State* L)
+{
+	notify_removed(luaL_checkstring(L, 1));
+	return 0;
+}
+
+
+//
+// Wrapped io.open, os.remove and os.rename. Each calls the original (upvalue
+// 1) with its arguments, then tells the index if it worked. The arguments
+// stay on the stack, so the path strings can't be collected.
+//
+static int call_original(lua_State* L)
+{
+	int n = lua_gettop(L);
+	lua_pushvalue(L, lua_upvalueindex(1));
+	for(int i = 1; i <= n; i++) { lua_pushvalue(L, i); }
+	lua_call(L, n, LUA_MULTRET);
+	return n;		// results start after this
+}
+
+static int wrapped_io_open(lua_State* L)
+{
+	luaL_checkstring(L, 1);
+	const char* mode = luaL_optstring(L, 2, "r");
+	bool writing = strpbrk(mode, "wa+") != 0;
+	int n = call_original(L);
+	if(writing and not lua_isnil(L, n + 1))
+	{
+		VirtualFileSystem::notify_written_path(lua_tostring(L, 1));
+	}
+	return lua_gettop(L) - n;
+}
+
+static int wrapped_os_remove(lua_State* L)
+{
+	luaL_checkstring(L, 1);
+	int n = call_original(L);
+	if(lua_toboolean(L, n + 1))
+	{
+		VirtualFileSystem::notify_removed_path(lua_tostring(L, 1));
+	}
+	return lua_gettop(L) - n;
+}
+
+static int wrapped_os_rename(lua_State* L)
+{
+	luaL_checkstring(L, 1);
+	luaL_checkstring(L, 2);
+	int n = call_original(L);
+	if(lua_toboolean(L, n + 1))
+	{
+		VirtualFileSystem::notify_removed_path(lua_tostring(L, 1));
+		VirtualFileSystem::notify_written_path(lua_tostring(L, 2));
+	}
+	return lua_gettop(L) - n;
+}
+
+static void wrap_field(lua_State* L, const char* table, const char* field, lua_CFunction f)
+{
+	lua_getglobal(L, table);
+	if(lua_istable(L, -1))
+	{
+		lua_getfield(L, -1, field);
+		if(lua_isfunction(L, -1))
+		{
+			lua_pushcclosure(L, f, 1);
+			lua_setfield(L, -2, field);
+		}
+		else
+		{
+			lua_pop(L, 1);
+		}
+	}
+	lua_pop(L, 1);
+}
+
+void VirtualFileSystem::wrap_lua_io(lua_State* L)
+{
+	wrap_field(L, "io", "open", wrapped_io_open);
+	wrap_field(L, "os", "remove", wrapped_os_remove);
+	wrap_field(L, "os", "rename", wrapped_os_rename);
+}
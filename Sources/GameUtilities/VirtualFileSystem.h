@@ -0,0 +1,114 @@
+/*
+ * VirtualFileSystem.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#ifndef VIRTUAL_FILE_SYSTEM_H
+#define VIRTUAL_FILE_SYSTEM_H
+
+#include "SDL.h"
+#include <string>
+#include <vector>
+#include <set>
+#include <unordered_map>
+
+struct lua_State;
+
+// In-memory index of everything LoadPath can find: the save data directory
+// (which overrides), the app resource directory and any mounted AssetArchive.
+//
+// The directories are scanned once by build_index(), after which LoadPath
+// resolves names with a hash lookup instead of probing the disk on every
+// call. Before build_index() (e.g. for conf.lua) LoadPath probes as it always
+// did.
+//
+// Anything that writes or deletes in the save data directory must tell us,
+// with notify_written() / notify_removed(), or a new file there won't
+// override the app one. Lua's io.open (for writing), os.remove and os.rename
+// are wrapped to do that for scripts. rescan() rebuilds the whole thing.
+//
+// Safe to use from any thread.
+class VirtualFileSystem
+{
+public:
+	enum Location { not_indexed = -1, missing = 0, save_data, app_resource, archive };
+
+	static void build_index();
+	static void rescan() { build_index(); }
+	static bool is_indexed();
+
+	// name relative to the data directory, e.g. "scripts/main.lua"
+	static Location where(const std::string& name);
+
+	// file added or changed (or removed) in the save data directory
+	static void notify_written(const std::string& name);
+	static void notify_removed(const std::string& name);
+	static void notify_written_path(const char* full_path);		// as above, given a SaveDataPath
+	static void notify_removed_path(const char* full_path);		// (anything else is ignored)
+
+	// replaces io.open, os.remove and os.rename in L with versions that call
+	// the above. After the standard libraries are opened.
+	static void wrap_lua_io(lua_State* L);
+
+	// For Lua
+	static int resolve(lua_State* L);		// VirtualFileSystem.resolve(name) -> full path, or nil
+	static int exists(lua_State* L);		// VirtualFileSystem.exists(name) -> boolean
+	static int stat(lua_State* L);			// VirtualFileSystem.stat(name) -> { size, modified, directory, location } or nil
+	static int list(lua_State* L);			// VirtualFileSystem.list(directory) -> array of names in it
+	static int read(lua_State* L);			// VirtualFileSystem.read(name) -> contents, or nil and an error (archives too)
+	static int written(lua_State* L);		// VirtualFileSystem.written(name) - see notify_written()
+	static int removed(lua_State* L);		// VirtualFileSystem.removed(name)
+
+private:
+	struct Entry
+	{
+		Entry() : location(missing), directory(false), size(0), modified(0), also_in_app(false) {}
+		Location location;
+		bool directory;
+		Uint64 size;
+		Sint64 modified;
+		bool also_in_app;		// a save data file hiding an app one
+	};
+	typedef std::unordered_map<std::string, Entry> index_t;
+	typedef std::unordered_map<std::string, std::set<std::string> > children_t;
+
+	static SDL_SpinLock index_lock;		// protects all of the below
+	static index_t* the_index;
+	static children_t* the_children;
+
+	static void add(index_t& index, children_t& children, const std::string& name, const Entry& e);
+	static void scan_directory(index_t& index, children_t& children, const std::string& root,
+							   const std::string& relative, Location location);
+	static bool stat_file(const std::string& path, Entry& e);
+	static bool lookup(const std::string& name, Entry& e);
+	static std::string full_path(const std::string& name, const Entry& e);
+	static bool save_relative(const char* full_path, std::string& name);
+};
+
+#endif
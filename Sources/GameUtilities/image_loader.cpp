@@ -36,6 +36,8 @@
 #include <iostream>
 #include <cstdio>
 #include "Utilities.h"
+#include "AssetArchive.h"
+#include "VirtualFileSystem.h"
 
 #define SDL2_image_load 0
 #if SDL2_image_load
@@ -66,7 +68,8 @@ SDL_Surface* load_image(const char* filename)
 	}
 	else if(strcmp(extension, ".BMP")==0 or strcmp(extension, ".bmp")==0)
 	{
-		img = SDL_LoadBMP(filename);
+		SDL_RWops* rw = AssetArchive::open_rw_path(filename);
+		img = rw ? SDL_LoadBMP_RW(rw, 1) : SDL_LoadBMP(filename);
 		if(img==NULL)
 		{
 			Utilities::debugMessage("SDL_LoadBMP failed: %s\n", SDL_GetError());
@@ -82,16 +85,27 @@ SDL_Surface* load_image(const char* filename)
 
 SDL_Surface* load_PNG(const char* filename)
 {
-    // stop lodepng::load_file from crashing when the file does not exist...
-    if(not Utilities::file_exists(filename))
-    {
-        Utilities::fatalError("load_PNG() file does not exist: %s", filename);
-    }
-
 	std::vector<unsigned char> buffer, image;
-	lodepng::load_file(buffer, filename); //load the image file with given filename
 	unsigned w, h;
-	unsigned error = lodepng::decode(image, w, h, buffer); //decode the png
+	unsigned error;
+
+	AssetData asset;
+	if(AssetArchive::read_path(filename, asset))
+	{
+		// decode straight out of the archive
+		error = lodepng::decode(image, w, h, reinterpret_cast<const unsigned char*>(asset.data), asset.size);
+	}
+	else
+	{
+		// stop lodepng::load_file from crashing when the file does not exist...
+		if(not Utilities::file_exists(filename))
+		{
+			Utilities::fatalError("load_PNG() file does not exist: %s", filename);
+		}
+
+		lodepng::load_file(buffer, filename); //load the image file with given filename
+		error = lodepng::decode(image, w, h, buffer); //decode the png
+	}
 
 	if (error)
 	{
@@ -237,6 +251,7 @@ int save_PNG(SDL_Surface* surface, const char* filename)
 	}
 
 	lodepng::save_file(png, filename);
+	VirtualFileSystem::notify_written_path(filename);
 	return 0;
 #endif
 }
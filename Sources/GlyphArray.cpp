@@ -0,0 +1,136 @@
+/*
+ * GlyphArray.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#include "GlyphArray.h"
+#include "Utilities.h"
+#include "lua.h"
+#include "lauxlib.h"
+#include <algorithm>
+#ifdef _MSC_VER
+#include <ciso646>   // Visual Studio is not C++ standards complaint...
+#endif
+
+using Utilities::utf8_to_int_helper;
+
+
+GlyphArray::GlyphArray(int size)
+: values(size > 0 ? size : 0, 0)
+{
+}
+
+void GlyphArray::resize(int size)
+{
+	values.resize(size > 0 ? size : 0, 0);
+}
+
+void GlyphArray::fill(Uint32 value)
+{
+	std::fill(values.begin(), values.end(), value);
+}
+
+int GlyphArray::set_string(const std::string& utf8, int first)
+{
+	static std::vector<Uint32> decoded;		// main thread only, like the rest of the drawing
+	decoded.clear();
+	decode_utf8(utf8.c_str(), utf8.size(), decoded);
+
+	if(first < 1) first = 1;
+	int count = 0;
+	for(size_t i = 0; i < decoded.size() and first + count <= size(); i++)
+	{
+		values[first - 1 + count] = decoded[i];
+		count++;
+	}
+	return count;
+}
+
+Uint32 GlyphArray::pack_colour(int r, int g, int b, int a)
+{
+	return (static_cast<Uint32>(r & 0xFF) << 24) | (static_cast<Uint32>(g & 0xFF) << 16) | (static_cast<Uint32>(b & 0xFF) << 8) | static_cast<Uint32>(a & 0xFF);
+}
+
+void GlyphArray::decode_utf8(const char* s, size_t length, std::vector<Uint32>& out)
+{
+	const unsigned char* ustr = reinterpret_cast<const unsigned char*>(s);
+	const unsigned char* end = ustr + length;
+	while(ustr < end)
+	{
+		int c = *ustr++;
+		if(c >= 0x80)
+		{
+			int len = utf8_to_int_helper(&c, ustr);
+			if(len <= 0 or ustr + len > end)
+			{
+				out.push_back('?');		// show error, and don't try to recover
+				return;
+			}
+			ustr += len;
+		}
+		out.push_back(static_cast<Uint32>(c));
+	}
+}
+
+// Lua numbers are doubles, and a packed colour doesn't fit in an int
+static Uint32 to_uint32(lua_Number n)
+{
+	return n < 0 ? static_cast<Uint32>(static_cast<Sint32>(n)) : static_cast<Uint32>(n);
+}
+
+// called as methods, so the array itself is argument 1
+int GlyphArray::lua_get(lua_State* L)
+{
+	int index = luaL_checkint(L, 2);
+	luaL_argcheck(L, index >= 1 and index <= size(), 2, "index out of range");
+	lua_pushnumber(L, values[index-1]);
+	return 1;
+}
+
+int GlyphArray::lua_set(lua_State* L)
+{
+	int index = luaL_checkint(L, 2);
+	luaL_argcheck(L, index >= 1 and index <= size(), 2, "index out of range");
+	values[index-1] = to_uint32(luaL_checknumber(L, 3));
+	return 0;
+}
+
+int GlyphArray::lua_set_string(lua_State* L)
+{
+	size_t length = 0;
+	const char* s = luaL_checklstring(L, 2, &length);
+	lua_pushinteger(L, set_string(std::string(s, length), luaL_optint(L, 3, 1)));
+	return 1;
+}
+
+int GlyphArray::lua_pack_colour(lua_State* L)
+{
+	lua_pushnumber(L, pack_colour(luaL_checkint(L, 1), luaL_checkint(L, 2), luaL_checkint(L, 3), luaL_optint(L, 4, 255)));
+	return 1;
+}
@@ -0,0 +1,88 @@
+/*
+ * GlyphArray.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#ifndef GLYPH_ARRAY_H
+#define GLYPH_ARRAY_H
+
+#include "SDL.h"
+#include <string>
+#include <vector>
+#ifdef _MSC_VER
+#include <ciso646>   // Visual Studio is not C++ standards complaint...
+#endif
+struct lua_State;
+
+// A packed array of 32 bit values that Lua can fill in once and hand to
+// MyGraphics::print_run() as often as it likes - a row of tiles, say, or a
+// row's colours (packed as 0xRRGGBBAA, see pack_colour) or attributes.
+//
+// Indexes from Lua start at 1, like a table.
+//
+// From Lua:
+//		a = GlyphArray(size)
+//		a:size(), a:resize(n), a:fill(value)
+//		a:get(i), a:set(i, value)
+//		a:set_string(utf8_string, [first=1]) - code points from first on, returns how many
+//		GlyphArray.pack_colour(r, g, b, [a=255])
+class GlyphArray
+{
+public:
+	explicit GlyphArray(int size);
+
+	int size() { return static_cast<int>(values.size()); }
+	void resize(int size);
+	void fill(Uint32 value);
+	int set_string(const std::string& utf8, int first);
+
+	const Uint32* data() { return values.empty() ? 0 : &values[0]; }
+
+	static Uint32 pack_colour(int r, int g, int b, int a);
+	static SDL_Colour unpack_colour(Uint32 packed)
+	{
+		SDL_Colour c = { static_cast<Uint8>(packed >> 24), static_cast<Uint8>(packed >> 16), static_cast<Uint8>(packed >> 8), static_cast<Uint8>(packed) };
+		return c;
+	}
+
+	// code points of a UTF-8 string, appended to 'out'. An invalid sequence
+	// comes out as '?' and ends the string, like print_cstring().
+	static void decode_utf8(const char* s, size_t length, std::vector<Uint32>& out);
+
+	// for Lua
+	int lua_get(lua_State* L);
+	int lua_set(lua_State* L);
+	int lua_set_string(lua_State* L);
+	static int lua_pack_colour(lua_State* L);
+
+private:
+	std::vector<Uint32> values;
+};
+
+#endif
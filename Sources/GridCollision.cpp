@@ -0,0 +1,357 @@
+/*
+ * GridCollision.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#include "GridCollision.h"
+#include "PresentationMaze.h"
+#include "MazeConstants.h"
+#include <cmath>
+#include <algorithm>
+#ifdef _MSC_VER
+#include <ciso646>   // Visual Studio is not C++ standards complaint...
+#endif
+
+// keeps edges that are exactly on a cell boundary out of that cell
+static const pos_t edge_epsilon = 1e-6;
+// largest glyph we'll keep a solid flag for
+static const int max_solid_glyph = 0x10FFFF;
+
+GridCollision::GridCollision(PresentationMaze* m)
+: maze(m)
+, circle(false)
+, half_height(0.5)
+, half_width(0.5)
+, radius(0.5)
+, use_transparency(false)
+{
+}
+
+void GridCollision::set_box(double hh, double hw)
+{
+	circle = false;
+	half_height = std::max(0.0, hh);
+	half_width = std::max(0.0, hw);
+}
+
+void GridCollision::set_circle(double r)
+{
+	circle = true;
+	radius = std::max(0.0, r);
+	half_height = half_width = radius;
+}
+
+void GridCollision::set_solid_glyph(int glyph, bool solid)
+{
+	if(glyph < 0 or glyph > max_solid_glyph) return;
+	if(glyph >= static_cast<int>(solid_glyphs.size()))
+	{
+		if(not solid) return;
+		solid_glyphs.resize(glyph+1, false);
+	}
+	solid_glyphs[glyph] = solid;
+}
+
+void GridCollision::set_solid_glyph_range(int first, int last, bool solid)
+{
+	for(int glyph = first; glyph <= last; glyph++)
+	{
+		set_solid_glyph(glyph, solid);
+	}
+}
+
+void GridCollision::clear_solid_glyphs()
+{
+	solid_glyphs.clear();
+}
+
+void GridCollision::set_use_transparency(bool use)
+{
+	use_transparency = use;
+}
+
+bool GridCollision::is_solid(int line, int column)
+{
+	if(line < 0 or column < 0 or line >= maze->height() or column >= maze->width())
+	{
+		return true;
+	}
+	if(use_transparency and maze->is_opaque(line, column))
+	{
+		return true;
+	}
+	if(not solid_glyphs.empty())
+	{
+		int glyph = maze->get_glyph(line, column);
+		if(glyph >= 0 and glyph < static_cast<int>(solid_glyphs.size()) and solid_glyphs[glyph])
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// move the box along columns only, stopping at the first solid column
+pos_t GridCollision::sweep_column(pos_t line, pos_t column, pos_t dcolumn, pos_t& normal)
+{
+	if(dcolumn == 0) return column;
+
+	int top = static_cast<int>(std::floor(line - half_height));
+	int bottom = static_cast<int>(std::floor(line + half_height - edge_epsilon));
+
+	if(dcolumn > 0)
+	{
+		pos_t edge = column + half_width;
+		int first = static_cast<int>(std::floor(edge - edge_epsilon)) + 1;
+		int last = static_cast<int>(std::floor(edge + dcolumn - edge_epsilon));
+		for(int c = first; c <= last; c++)
+		{
+			for(int l = top; l <= bottom; l++)
+			{
+				if(is_solid(l, c))
+				{
+					normal = -1;
+					return c - half_width;
+				}
+			}
+		}
+	}
+	else
+	{
+		pos_t edge = column - half_width;
+		int first = static_cast<int>(std::floor(edge)) - 1;
+		int last = static_cast<int>(std::floor(edge + dcolumn));
+		for(int c = first; c >= last; c--)
+		{
+			for(int l = top; l <= bottom; l++)
+			{
+				if(is_solid(l, c))
+				{
+					normal = 1;
+					return c + 1 + half_width;
+				}
+			}
+		}
+	}
+	return column + dcolumn;
+}
+
+// move the box along lines only, stopping at the first solid line
+pos_t GridCollision::sweep_line(pos_t line, pos_t column, pos_t dline, pos_t& normal)
+{
+	if(dline == 0) return line;
+
+	int left = static_cast<int>(std::floor(column - half_width));
+	int right = static_cast<int>(std::floor(column + half_width - edge_epsilon));
+
+	if(dline > 0)
+	{
+		pos_t edge = line + half_height;
+		int first = static_cast<int>(std::floor(edge - edge_epsilon)) + 1;
+		int last = static_cast<int>(std::floor(edge + dline - edge_epsilon));
+		for(int l = first; l <= last; l++)
+		{
+			for(int c = left; c <= right; c++)
+			{
+				if(is_solid(l, c))
+				{
+					normal = -1;
+					return l - half_height;
+				}
+			}
+		}
+	}
+	else
+	{
+		pos_t edge = line - half_height;
+		int first = static_cast<int>(std::floor(edge)) - 1;
+		int last = static_cast<int>(std::floor(edge + dline));
+		for(int l = first; l >= last; l--)
+		{
+			for(int c = left; c <= right; c++)
+			{
+				if(is_solid(l, c))
+				{
+					normal = 1;
+					return l + 1 + half_height;
+				}
+			}
+		}
+	}
+	return line + dline;
+}
+
+GridCollision::Result GridCollision::resolve_circle(pos_t line, pos_t column, pos_t dline, pos_t dcolumn)
+{
+	Result r = { line, column, 0, 0, false };
+
+	// step no more than half the radius so we can't pass through a cell corner
+	pos_t distance = std::sqrt(dline*dline + dcolumn*dcolumn);
+	pos_t max_step = std::min(0.25, std::max(radius * 0.5, 0.01));
+	int steps = std::max(1, static_cast<int>(std::ceil(distance / max_step)));
+	pos_t step_line = dline / steps;
+	pos_t step_column = dcolumn / steps;
+
+	for(int i = 0; i < steps; i++)
+	{
+		r.line += step_line;
+		r.column += step_column;
+
+		int top = static_cast<int>(std::floor(r.line - radius));
+		int bottom = static_cast<int>(std::floor(r.line + radius));
+		int left = static_cast<int>(std::floor(r.column - radius));
+		int right = static_cast<int>(std::floor(r.column + radius));
+		for(int l = top; l <= bottom; l++)
+		{
+			for(int c = left; c <= right; c++)
+			{
+				if(not is_solid(l, c)) continue;
+
+				// nearest point of the cell to the centre
+				pos_t near_line = std::max<pos_t>(l, std::min<pos_t>(r.line, l + 1));
+				pos_t near_column = std::max<pos_t>(c, std::min<pos_t>(r.column, c + 1));
+				pos_t to_line = r.line - near_line;
+				pos_t to_column = r.column - near_column;
+				pos_t d2 = to_line*to_line + to_column*to_column;
+				if(d2 >= radius*radius) continue;
+
+				pos_t d = std::sqrt(d2);
+				if(d < edge_epsilon)
+				{
+					// centre is inside the cell, back out the way we came
+					pos_t back = std::sqrt(step_line*step_line + step_column*step_column);
+					if(back < edge_epsilon) continue;
+					to_line = -step_line / back;
+					to_column = -step_column / back;
+					d = 0;
+				}
+				else
+				{
+					to_line /= d;
+					to_column /= d;
+				}
+				r.line += to_line * (radius - d);
+				r.column += to_column * (radius - d);
+				r.normal_line += to_line;
+				r.normal_column += to_column;
+				r.hit = true;
+			}
+		}
+	}
+
+	if(r.hit)
+	{
+		pos_t n = std::sqrt(r.normal_line*r.normal_line + r.normal_column*r.normal_column);
+		if(n > edge_epsilon)
+		{
+			r.normal_line /= n;
+			r.normal_column /= n;
+		}
+	}
+	return r;
+}
+
+GridCollision::Result GridCollision::resolve(pos_t line, pos_t column, pos_t dline, pos_t dcolumn)
+{
+	if(circle)
+	{
+		return resolve_circle(line, column, dline, dcolumn);
+	}
+
+	Result r = { line, column, 0, 0, false };
+	r.column = sweep_column(line, column, dcolumn, r.normal_column);
+	r.line = sweep_line(line, r.column, dline, r.normal_line);
+	r.hit = r.normal_line != 0 or r.normal_column != 0;
+	return r;
+}
+
+int GridCollision::move(lua_State* L)
+{
+	pos_t line = luaL_checknumber(L, -4);
+	pos_t column = luaL_checknumber(L, -3);
+	pos_t dline = luaL_checknumber(L, -2);
+	pos_t dcolumn = luaL_checknumber(L, -1);
+
+	Result r = resolve(line, column, dline, dcolumn);
+	lua_pushnumber(L, r.line);
+	lua_pushnumber(L, r.column);
+	lua_pushnumber(L, r.normal_line);
+	lua_pushnumber(L, r.normal_column);
+	lua_pushboolean(L, r.hit);
+	return 5;
+}
+
+static pos_t get_number_field(lua_State* L, int index, const char* name, pos_t def)
+{
+	lua_getfield(L, index, name);
+	pos_t value = lua_isnumber(L, -1) ? lua_tonumber(L, -1) : def;
+	lua_pop(L, 1);
+	return value;
+}
+
+int GridCollision::move_all(lua_State* L)
+{
+	pos_t scale = 1;
+	if(lua_isnumber(L, -1))
+	{
+		scale = lua_tonumber(L, -1);
+		lua_pop(L, 1);
+	}
+	luaL_checktype(L, -1, LUA_TTABLE);
+	int movers = lua_gettop(L);
+
+	int count = static_cast<int>(lua_rawlen(L, movers));
+	for(int i = 1; i <= count; i++)
+	{
+		lua_rawgeti(L, movers, i);
+		if(lua_istable(L, -1))
+		{
+			int m = lua_gettop(L);
+			pos_t line = get_number_field(L, m, "line", 0);
+			pos_t column = get_number_field(L, m, "column", 0);
+			pos_t dline = get_number_field(L, m, "dline", 0) * scale;
+			pos_t dcolumn = get_number_field(L, m, "dcolumn", 0) * scale;
+
+			Result r = resolve(line, column, dline, dcolumn);
+
+			lua_pushnumber(L, r.line);
+			lua_setfield(L, m, "line");
+			lua_pushnumber(L, r.column);
+			lua_setfield(L, m, "column");
+			lua_pushnumber(L, r.normal_line);
+			lua_setfield(L, m, "normal_line");
+			lua_pushnumber(L, r.normal_column);
+			lua_setfield(L, m, "normal_column");
+			lua_pushboolean(L, r.hit);
+			lua_setfield(L, m, "hit");
+		}
+		lua_pop(L, 1);
+	}
+	return 0;
+}
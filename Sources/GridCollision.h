@@ -0,0 +1,99 @@
+/*
+ * GridCollision.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#ifndef GRIDCOLLISION_H_
+#define GRIDCOLLISION_H_
+
+#include <vector>
+#include "BasicTypes.h"
+
+#include "lua.h"
+#include "lauxlib.h"
+
+class PresentationMaze;
+
+// Collision of moving things against the solid cells of a PresentationMaze.
+//
+// Movers are either axis aligned boxes or circles, positioned by their centre
+// in map cells (so a 1x1 box at line=3.5, column=4.5 exactly fills cell 3,4).
+// A cell is solid if it's off the map, if its glyph has been marked solid,
+// or (if enabled) if it is opaque in the wall transparency.
+//
+// Boxes are swept exactly along each axis in turn, so they slide along walls
+// and can't tunnel however far they move. Circles move in small steps and are
+// pushed out of any solid cell they overlap, so they round corners.
+class GridCollision
+{
+public:
+	GridCollision(PresentationMaze* m);
+
+	void set_box(double half_height, double half_width);
+	void set_circle(double radius);
+	void set_solid_glyph(int glyph, bool solid);
+	void set_solid_glyph_range(int first, int last, bool solid);
+	void clear_solid_glyphs();
+	void set_use_transparency(bool use);
+
+	bool is_solid(int line, int column);
+
+	// move(line, column, dline, dcolumn)
+	// returns line, column, normal_line, normal_column, hit
+	int move(lua_State* L);
+	// move_all({ {line=, column=, dline=, dcolumn=}, ...}, [scale])
+	// the line, column, normal_line, normal_column and hit fields of each mover
+	// are updated in place. dline/dcolumn are multiplied by scale if given.
+	int move_all(lua_State* L);
+
+	struct Result
+	{
+		pos_t line;
+		pos_t column;
+		pos_t normal_line;
+		pos_t normal_column;
+		bool hit;
+	};
+	Result resolve(pos_t line, pos_t column, pos_t dline, pos_t dcolumn);
+
+private:
+	pos_t sweep_column(pos_t line, pos_t column, pos_t dcolumn, pos_t& normal);
+	pos_t sweep_line(pos_t line, pos_t column, pos_t dline, pos_t& normal);
+	Result resolve_circle(pos_t line, pos_t column, pos_t dline, pos_t dcolumn);
+
+	PresentationMaze* maze;
+	bool circle;
+	pos_t half_height;
+	pos_t half_width;
+	pos_t radius;
+	bool use_transparency;
+	std::vector<bool> solid_glyphs;		// indexed by glyph
+};
+
+#endif /* GRIDCOLLISION_H_ */
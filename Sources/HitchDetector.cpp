@@ -0,0 +1,261 @@
+/*
+ * HitchDetector.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#include "HitchDetector.h"
+#include "Trace.h"
+#include "SaveDataPath.h"
+#include "VirtualFileSystem.h"
+#include "Utilities.h"
+#include "lua.h"
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#ifdef _MSC_VER
+#include <ciso646>   // Visual Studio is not C++ standards complaint...
+#endif
+
+// about 10 seconds at 60fps for the percentiles and captures
+static const size_t history_frames = 600;
+// the percentiles are sorted this often (in frames)
+static const int percentile_interval = 30;
+// the first few frames upload textures, etc. and aren't interesting
+static const int warm_up_frames = 10;
+
+// +---------------------------------------------------------------------------
+// | TITLE: HitchDetector
+// | AUTHOR(s): agent
+// | DATE STARTED: 19 Oct 2026
+// +
+// | DESCRIPTION: 50ms catches the hitches players notice, without firing
+// | on every frame of a game running at 30fps.
+// +---------------------------------------------------------------------------
+HitchDetector::HitchDetector()
+: history(history_frames)
+, write_index(0)
+, stored(0)
+, budget_ms(50)
+, capture_seconds(3)
+, max_captures(5)
+, captures(0)
+, no_capture_until(0)
+, frame_count(0)
+, hitch_count(0)
+, worst_ms(0)
+, p50(0)
+, p95(0)
+, p99(0)
+{
+	scratch.reserve(history_frames);
+}
+
+void HitchDetector::set_capture(double seconds, int max_files)
+{
+	capture_seconds = seconds > 0 ? seconds : 0;
+	max_captures = max_files;
+	captures = 0;
+}
+
+// +---------------------------------------------------------------------------
+// | TITLE: add_frame
+// | AUTHOR(s): agent
+// | DATE STARTED: 19 Oct 2026
+// +
+// | DESCRIPTION: Called once a frame, when the next one starts.
+// +---------------------------------------------------------------------------
+void HitchDetector::add_frame(const Frame& f)
+{
+	history[write_index] = f;
+	write_index = (write_index + 1) % history.size();
+	if(stored < history.size()) { stored++; }
+
+	frame_count++;
+	if(frame_count % percentile_interval == 0)
+	{
+		update_percentiles();
+	}
+
+	if(frame_count <= warm_up_frames or f.total_ms <= budget_ms)
+	{
+		return;
+	}
+
+	hitch_count++;
+	if(f.total_ms > worst_ms) { worst_ms = f.total_ms; }
+	if(capture_seconds > 0 and f.start >= no_capture_until)
+	{
+		capture();
+		no_capture_until = f.start + static_cast<Uint64>(capture_seconds * SDL_GetPerformanceFrequency());
+	}
+}
+
+void HitchDetector::update_percentiles()
+{
+	scratch.clear();
+	for(size_t i = 0; i < stored; i++)
+	{
+		scratch.push_back(history[i].total_ms);
+	}
+	if(scratch.empty()) { return; }
+
+	size_t n = scratch.size();
+	std::vector<float>::iterator p;
+	p = scratch.begin() + (n * 50) / 100; std::nth_element(scratch.begin(), p, scratch.end()); p50 = *p;
+	p = scratch.begin() + (n * 95) / 100; std::nth_element(scratch.begin(), p, scratch.end()); p95 = *p;
+	p = scratch.begin() + (n * 99) / 100; std::nth_element(scratch.begin(), p, scratch.end()); p99 = *p;
+}
+
+int HitchDetector::recent_totals(float* totals, int count)
+{
+	int n = std::min(count, static_cast<int>(stored));
+	for(int i = 0; i < n; i++)
+	{
+		size_t index = (write_index + history.size() - n + i) % history.size();
+		totals[i] = history[index].total_ms;
+	}
+	return n;
+}
+
+// +---------------------------------------------------------------------------
+// | TITLE: capture
+// | AUTHOR(s): agent
+// | DATE STARTED: 19 Oct 2026
+// +
+// | DESCRIPTION: Freeze the frames up to and including the hitch, and save them.
+// +---------------------------------------------------------------------------
+void HitchDetector::capture()
+{
+	// walk back from the hitch until we have enough time
+	const Frame& hitch = history[(write_index + history.size() - 1) % history.size()];
+	size_t count = 0;
+	double ms = 0;
+	while(count < stored and ms < capture_seconds * 1000.0)
+	{
+		ms += history[(write_index + history.size() - 1 - count) % history.size()].total_ms;
+		count++;
+	}
+	frozen.clear();
+	for(size_t i = count; i > 0; i--)
+	{
+		frozen.push_back(history[(write_index + history.size() - i) % history.size()]);
+	}
+
+	Utilities::debugMessage("Hitch: %.1fms frame (budget %.1fms, p99 %.1fms)", hitch.total_ms, budget_ms, p99);
+	if(captures >= max_captures)
+	{
+		return;
+	}
+	captures++;
+
+	char date[32];
+	time_t now = time(0);
+	strftime(date, sizeof(date), "%Y%m%d_%H%M%S", localtime(&now));
+	char name[64];
+	snprintf(name, sizeof(name), "hitch_%s_%d", date, captures);
+	std::string path = save_csv(std::string(name) + ".csv");
+	if(Trace::enabled())
+	{
+		Trace::save((std::string(name) + "_trace.json").c_str(), ms / 1000.0 + 0.1);
+	}
+	if(not path.empty())
+	{
+		Utilities::debugMessage("Hitch capture saved to %s", path.c_str());
+	}
+}
+
+std::string HitchDetector::save_csv(const std::string& name)
+{
+	SaveDataPath path(name);
+	if(path.c_str() == 0) { return ""; }
+	FILE* f = fopen(path.c_str(), "w");
+	if(f == 0) { return ""; }
+
+	// something that will import into a spreadsheet for graphing
+	fprintf(f, "frame,start_ms,total_ms,events_ms,update_ms,draw_ms,present_ms,limiter_ms,gc_ms,gc_steps,events,allocations,lua_allocations,lua_kb\n");
+	double freq = static_cast<double>(SDL_GetPerformanceFrequency());
+	Uint64 first = frozen.empty() ? 0 : frozen[0].start;
+	for(size_t i = 0; i < frozen.size(); i++)
+	{
+		const Frame& fr = frozen[i];
+		fprintf(f, "%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%d,%d,%d,%d,%d\n",
+				static_cast<int>(i) - static_cast<int>(frozen.size()) + 1,
+				(fr.start - first) * 1000.0 / freq, fr.total_ms, fr.events_ms, fr.update_ms, fr.draw_ms,
+				fr.present_ms, fr.limiter_ms, fr.gc_ms, fr.gc_steps, fr.events, fr.allocations, fr.lua_allocations, fr.lua_kb);
+	}
+	fclose(f);
+	VirtualFileSystem::notify_written(name);
+	return path.str();
+}
+
+
+//
+// Lua
+//
+int HitchDetector::stats(lua_State* L)
+{
+	lua_createtable(L, 0, 7);
+	lua_pushnumber(L, p50); lua_setfield(L, -2, "p50");
+	lua_pushnumber(L, p95); lua_setfield(L, -2, "p95");
+	lua_pushnumber(L, p99); lua_setfield(L, -2, "p99");
+	lua_pushnumber(L, budget_ms); lua_setfield(L, -2, "budget");
+	lua_pushnumber(L, hitch_count); lua_setfield(L, -2, "hitches");
+	lua_pushnumber(L, frame_count); lua_setfield(L, -2, "frames");
+	lua_pushnumber(L, worst_ms); lua_setfield(L, -2, "worst");
+	return 1;
+}
+
+int HitchDetector::last_hitch(lua_State* L)
+{
+	if(frozen.empty())
+	{
+		lua_pushnil(L);
+		return 1;
+	}
+	lua_createtable(L, static_cast<int>(frozen.size()), 0);
+	for(size_t i = 0; i < frozen.size(); i++)
+	{
+		const Frame& fr = frozen[i];
+		lua_createtable(L, 0, 12);
+		lua_pushnumber(L, fr.total_ms); lua_setfield(L, -2, "total_ms");
+		lua_pushnumber(L, fr.events_ms); lua_setfield(L, -2, "events_ms");
+		lua_pushnumber(L, fr.update_ms); lua_setfield(L, -2, "update_ms");
+		lua_pushnumber(L, fr.draw_ms); lua_setfield(L, -2, "draw_ms");
+		lua_pushnumber(L, fr.present_ms); lua_setfield(L, -2, "present_ms");
+		lua_pushnumber(L, fr.limiter_ms); lua_setfield(L, -2, "limiter_ms");
+		lua_pushnumber(L, fr.gc_ms); lua_setfield(L, -2, "gc_ms");
+		lua_pushnumber(L, fr.gc_steps); lua_setfield(L, -2, "gc_steps");
+		lua_pushnumber(L, fr.events); lua_setfield(L, -2, "events");
+		lua_pushnumber(L, fr.allocations); lua_setfield(L, -2, "allocations");
+		lua_pushnumber(L, fr.lua_allocations); lua_setfield(L, -2, "lua_allocations");
+		lua_pushnumber(L, fr.lua_kb); lua_setfield(L, -2, "lua_kb");
+		lua_rawseti(L, -2, static_cast<int>(i + 1));
+	}
+	return 1;
+}
@@ -0,0 +1,113 @@
+/*
+ * HitchDetector.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#ifndef HITCH_DETECTOR_H
+#define HITCH_DETECTOR_H
+
+#include "SDL.h"
+#include <string>
+#include <vector>
+struct lua_State;
+
+// Keeps the last few seconds of per-frame timings (fed by Debug), works out
+// frame time percentiles, and spots frames over a time budget.
+//
+// When a hitch happens, the frames leading up to it are frozen (see
+// last_hitch) and saved to the save data directory as a CSV, along with a
+// Chrome trace of the same period if Trace is recording. After a capture
+// there's a pause of the same length before the next, so one long stall
+// doesn't make lots of files, and at most max_captures are saved per run.
+class HitchDetector
+{
+public:
+	struct Frame
+	{
+		Uint64 start;			// performance counter at the start of the frame
+		float total_ms;
+		float events_ms;		// event dispatch and console
+		float update_ms;		// tweens and Lua update
+		float draw_ms;			// Lua draw and debug overlay
+		float present_ms;		// SDL_RenderPresent
+		float limiter_ms;		// GC plus sleep, in FrameRateLimiter
+		float gc_ms;
+		int gc_steps;
+		int events;
+		int allocations;		// C++ and SDL heap, all threads
+		int lua_allocations;	// all Lua states
+		int lua_kb;				// all Lua states
+	};
+
+	HitchDetector();
+	void add_frame(const Frame& f);
+
+	void set_budget(double ms) { budget_ms = ms; }
+	double get_budget() { return budget_ms; }
+	void set_capture(double seconds, int max_files);		// seconds=0 turns captures off
+
+	double get_p50() { return p50; }
+	double get_p95() { return p95; }
+	double get_p99() { return p99; }
+	int get_hitch_count() { return hitch_count; }
+	int get_frame_count() { return frame_count; }
+
+	// newest last, up to 'count' frame totals (for the graph)
+	int recent_totals(float* totals, int count);
+
+	// Lua, e.g. gulp.debug:hitches():stats()
+	int stats(lua_State* L);		// { p50, p95, p99, budget, hitches, frames, worst }
+	int last_hitch(lua_State* L);	// array of frame tables, the hitch last, or nil
+
+private:
+	void update_percentiles();
+	void capture();
+	std::string save_csv(const std::string& name);
+
+	std::vector<Frame> history;		// ring
+	size_t write_index;
+	size_t stored;
+	std::vector<float> scratch;		// for the percentiles
+	std::vector<Frame> frozen;		// the last hitch, and what came before it
+
+	double budget_ms;
+	double capture_seconds;
+	int max_captures;
+	int captures;
+	Uint64 no_capture_until;
+
+	int frame_count;
+	int hitch_count;
+	double worst_ms;
+	double p50;
+	double p95;
+	double p99;
+};
+
+#endif
@@ -0,0 +1,436 @@
+/*
+ * LightMap.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#include "LightMap.h"
+#include "PresentationMaze.h"
+#include "Utilities.h"
+#include <cmath>
+#include <algorithm>
+#ifdef _MSC_VER
+#include <ciso646>   // Visual Studio is not C++ standards complaint...
+#endif
+
+static const int W = MazeConstants::maze_width_max;
+static const int H = MazeConstants::maze_height_max;
+
+// very large lights would make incremental updates pointless
+static const double max_light_radius = 64;
+static const int max_light_threads = 8;
+
+// directions in flood order: north, east, south, west
+static const int dir_line[4] = { -1, 0, 1, 0 };
+static const int dir_column[4] = { 0, 1, 0, -1 };
+static const direction_t dir_side[4] = { NORTH, EAST, SOUTH, WEST };
+static const int from_source = 4;
+
+
+LightMap::LightMap(transparency_array_t* t)
+: transparency(t)
+, enabled(false)
+, lines(H)
+, columns(W)
+, next_id(1)
+{
+	SDL_Color dark = { 0, 0, 0, 255 };
+	ambient = dark;
+}
+
+LightMap::~LightMap()
+{
+}
+
+void LightMap::set_enabled(bool on)
+{
+	if(on and not enabled)
+	{
+		// only pay for the memory if someone actually wants lighting
+		accumulated.assign(H * W * 3, 0.0f);
+		result.assign(H * W * 3, 0);
+		enabled = true;
+		Rect all = { 0, 0, lines-1, columns-1 };
+		mark_dirty(all);
+	}
+	else if(not on)
+	{
+		enabled = false;
+		dirty.clear();
+	}
+}
+
+void LightMap::set_size(int l, int c)
+{
+	lines = std::max(0, std::min(l, H));
+	columns = std::max(0, std::min(c, W));
+	Rect all = { 0, 0, lines-1, columns-1 };
+	mark_dirty(all);
+}
+
+void LightMap::set_ambient(SDL_Color c)
+{
+	ambient = c;
+	Rect all = { 0, 0, lines-1, columns-1 };
+	mark_dirty(all);
+}
+
+LightMap::Light* LightMap::find_light(int id)
+{
+	for(size_t i = 0; i < lights.size(); i++)
+	{
+		if(lights[i].id == id) return &lights[i];
+	}
+	return 0;
+}
+
+LightMap::Rect LightMap::light_rect(const Light& l)
+{
+	Rect r;
+	r.top = static_cast<int>(std::floor(l.line - l.radius));
+	r.left = static_cast<int>(std::floor(l.column - l.radius));
+	r.bottom = static_cast<int>(std::ceil(l.line + l.radius));
+	r.right = static_cast<int>(std::ceil(l.column + l.radius));
+	return r;
+}
+
+bool LightMap::clip(Rect& r)
+{
+	r.top = std::max(r.top, 0);
+	r.left = std::max(r.left, 0);
+	r.bottom = std::min(r.bottom, lines-1);
+	r.right = std::min(r.right, columns-1);
+	return r.top <= r.bottom and r.left <= r.right;
+}
+
+void LightMap::mark_dirty(Rect r)
+{
+	if(not enabled) return;		// everything gets done when we are enabled
+	if(not clip(r)) return;
+
+	// merge with anything it overlaps, so we don't do areas twice
+	for(size_t i = 0; i < dirty.size(); )
+	{
+		Rect& d = dirty[i];
+		if(d.top <= r.bottom and r.top <= d.bottom and d.left <= r.right and r.left <= d.right)
+		{
+			r.top = std::min(r.top, d.top);
+			r.left = std::min(r.left, d.left);
+			r.bottom = std::max(r.bottom, d.bottom);
+			r.right = std::max(r.right, d.right);
+			dirty[i] = dirty.back();
+			dirty.pop_back();
+			i = 0;		// the bigger rect might now overlap something we've already checked
+		}
+		else
+		{
+			i++;
+		}
+	}
+	dirty.push_back(r);
+}
+
+int LightMap::add_light(pos_t line, pos_t column, double radius, SDL_Color colour, double intensity)
+{
+	Light l;
+	l.id = next_id++;
+	l.line = line;
+	l.column = column;
+	l.radius = std::max(0.0, std::min(radius, max_light_radius));
+	l.colour = colour;
+	l.intensity = intensity;
+	lights.push_back(l);
+	mark_dirty(light_rect(l));
+	return l.id;
+}
+
+bool LightMap::move_light(int id, pos_t line, pos_t column)
+{
+	Light* l = find_light(id);
+	if(not l) return false;
+	if(l->line == line and l->column == column) return true;
+
+	mark_dirty(light_rect(*l));
+	l->line = line;
+	l->column = column;
+	mark_dirty(light_rect(*l));
+	return true;
+}
+
+bool LightMap::set_light(int id, double radius, SDL_Color colour, double intensity)
+{
+	Light* l = find_light(id);
+	if(not l) return false;
+
+	mark_dirty(light_rect(*l));
+	l->radius = std::max(0.0, std::min(radius, max_light_radius));
+	l->colour = colour;
+	l->intensity = intensity;
+	mark_dirty(light_rect(*l));
+	return true;
+}
+
+bool LightMap::remove_light(int id)
+{
+	for(size_t i = 0; i < lights.size(); i++)
+	{
+		if(lights[i].id == id)
+		{
+			mark_dirty(light_rect(lights[i]));
+			lights.erase(lights.begin() + i);
+			return true;
+		}
+	}
+	return false;
+}
+
+void LightMap::remove_all_lights()
+{
+	lights.clear();
+	Rect all = { 0, 0, lines-1, columns-1 };
+	mark_dirty(all);
+}
+
+void LightMap::cell_changed(int line, int column)
+{
+	// anything that could reach this cell might now go further, or less far
+	for(size_t i = 0; i < lights.size(); i++)
+	{
+		Rect r = light_rect(lights[i]);
+		if(line >= r.top and line <= r.bottom and column >= r.left and column <= r.right)
+		{
+			mark_dirty(r);
+		}
+	}
+}
+
+int LightMap::get_light_level(int line, int column)
+{
+	if(not enabled) return 255;
+	if(line < 0 or column < 0 or line >= H or column >= W) return 0;
+	update();
+	const Uint8* p = &result[(line * W + column) * 3];
+	return std::max(p[0], std::max(p[1], p[2]));
+}
+
+void LightMap::update()
+{
+	if(not enabled or dirty.empty()) return;
+
+	// if most of the map is dirty, do it all in parallel
+	long area = 0;
+	for(size_t i = 0; i < dirty.size(); i++)
+	{
+		area += long(dirty[i].bottom - dirty[i].top + 1) * (dirty[i].right - dirty[i].left + 1);
+	}
+	if(area * 2 > long(lines) * columns)
+	{
+		recompute_all();
+		return;
+	}
+
+	std::vector<Rect> todo;
+	todo.swap(dirty);
+	for(size_t i = 0; i < todo.size(); i++)
+	{
+		recompute_rect(todo[i]);
+	}
+}
+
+// flood light l out from its cell, only stopping at opaque cell sides or the
+// edge of its radius. Only cells inside r are written.
+void LightMap::flood(const Light& l, const Rect& r, std::vector<unsigned char>& visited)
+{
+	if(l.radius <= 0) return;
+
+	const int src_line = static_cast<int>(std::floor(l.line));
+	const int src_column = static_cast<int>(std::floor(l.column));
+	if(src_line < 0 or src_column < 0 or src_line >= lines or src_column >= columns) return;
+
+	const int reach = static_cast<int>(std::ceil(l.radius));
+	const int span = 2 * reach + 1;
+
+	// 5 states per cell: entered from each of the 4 sides, plus 'lit'
+	visited.assign(span * span * 5, 0);
+	std::vector<int> queue;
+	queue.reserve(span * span);
+
+	const float cr = l.colour.r * static_cast<float>(l.intensity);
+	const float cg = l.colour.g * static_cast<float>(l.intensity);
+	const float cb = l.colour.b * static_cast<float>(l.intensity);
+	transparency_array_t& t = *transparency;
+
+	#define LIGHT_CELL(line_, column_, local_) \
+		if(not visited[(local_)*5+4]) { \
+			visited[(local_)*5+4] = 1; \
+			if((line_) >= r.top and (line_) <= r.bottom and (column_) >= r.left and (column_) <= r.right) { \
+				float dl = (line_) - l.line; float dc = (column_) - l.column; \
+				float f = 1.0f - std::sqrt(dl*dl + dc*dc) / static_cast<float>(l.radius + 0.5); \
+				if(f > 0) { \
+					f *= f; \
+					float* a = &accumulated[((line_) * W + (column_)) * 3]; \
+					a[0] += cr * f; a[1] += cg * f; a[2] += cb * f; \
+				} \
+			} \
+		}
+
+	int local = reach * span + reach;
+	LIGHT_CELL(src_line, src_column, local);
+	queue.push_back(local * 5 + from_source);
+
+	for(size_t q = 0; q < queue.size(); q++)
+	{
+		int state = queue[q];
+		int entry = state % 5;
+		int cell = state / 5;
+		int cell_line = src_line + cell / span - reach;
+		int cell_column = src_column + cell % span - reach;
+		Transparency& here = t[cell_line][cell_column];
+
+		for(int d = 0; d < 4; d++)
+		{
+			if(entry == from_source)
+			{
+				// leaving the source cell, just need that side to be open at all
+				bool open = false;
+				for(int s = 0; s < 4 and not open; s++)
+				{
+					if(s != d and here.IsTransparent(dir_side[s], dir_side[d])) open = true;
+				}
+				if(not open) continue;
+			}
+			else
+			{
+				if(entry == d) continue;	// don't go back the way we came
+				if(not here.IsTransparent(dir_side[entry], dir_side[d])) continue;
+			}
+
+			int n_line = cell_line + dir_line[d];
+			int n_column = cell_column + dir_column[d];
+			if(n_line < 0 or n_column < 0 or n_line >= lines or n_column >= columns) continue;
+
+			float dl = n_line - l.line;
+			float dc = n_column - l.column;
+			if(dl*dl + dc*dc > l.radius * l.radius) continue;
+
+			int n_local = (n_line - src_line + reach) * span + (n_column - src_column + reach);
+			int n_entry = (d + 2) % 4;		// we arrive on the opposite side
+			int n_state = n_local * 5 + n_entry;
+			if(visited[n_state]) continue;
+			visited[n_state] = 1;
+
+			LIGHT_CELL(n_line, n_column, n_local);
+			queue.push_back(n_state);
+		}
+	}
+	#undef LIGHT_CELL
+}
+
+void LightMap::recompute_rect(const Rect& r)
+{
+	for(int line = r.top; line <= r.bottom; line++)
+	{
+		std::fill(&accumulated[(line * W + r.left) * 3], &accumulated[(line * W + r.right) * 3 + 3], 0.0f);
+	}
+
+	std::vector<unsigned char> visited;
+	for(size_t i = 0; i < lights.size(); i++)
+	{
+		Rect lr = light_rect(lights[i]);
+		if(lr.top <= r.bottom and r.top <= lr.bottom and lr.left <= r.right and r.left <= lr.right)
+		{
+			flood(lights[i], r, visited);
+		}
+	}
+
+	for(int line = r.top; line <= r.bottom; line++)
+	{
+		const float* a = &accumulated[(line * W + r.left) * 3];
+		Uint8* out = &result[(line * W + r.left) * 3];
+		for(int column = r.left; column <= r.right; column++)
+		{
+			out[0] = static_cast<Uint8>(std::min(255.0f, ambient.r + a[0]));
+			out[1] = static_cast<Uint8>(std::min(255.0f, ambient.g + a[1]));
+			out[2] = static_cast<Uint8>(std::min(255.0f, ambient.b + a[2]));
+			a += 3;
+			out += 3;
+		}
+	}
+}
+
+struct LightMapBand
+{
+	LightMap* map;
+	void* rect;
+};
+
+int LightMap::recompute_thread(void* data)
+{
+	LightMapBand* band = static_cast<LightMapBand*>(data);
+	band->map->recompute_rect(*static_cast<Rect*>(band->rect));
+	return 0;
+}
+
+void LightMap::recompute_all()
+{
+	dirty.clear();
+	if(not enabled or lines <= 0 or columns <= 0) return;
+
+	// each band only writes its own lines, so the threads don't need any locking
+	int threads = std::max(1, std::min(SDL_GetCPUCount(), max_light_threads));
+	if(threads > lines) threads = lines;
+
+	std::vector<Rect> rects(threads);
+	std::vector<LightMapBand> bands(threads);
+	std::vector<SDL_Thread*> handles(threads, static_cast<SDL_Thread*>(0));
+	for(int i = 0; i < threads; i++)
+	{
+		rects[i].top = (lines * i) / threads;
+		rects[i].bottom = (lines * (i+1)) / threads - 1;
+		rects[i].left = 0;
+		rects[i].right = columns - 1;
+		bands[i].map = this;
+		bands[i].rect = &rects[i];
+	}
+
+	// band 0 is done on this thread
+	for(int i = 1; i < threads; i++)
+	{
+		handles[i] = SDL_CreateThread(recompute_thread, "LightMap", &bands[i]);
+		if(not handles[i])
+		{
+			// couldn't get a thread, just do it here
+			recompute_rect(rects[i]);
+		}
+	}
+	recompute_rect(rects[0]);
+	for(int i = 1; i < threads; i++)
+	{
+		if(handles[i]) SDL_WaitThread(handles[i], 0);
+	}
+}
@@ -0,0 +1,130 @@
+/*
+ * LightMap.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#ifndef LIGHTMAP_H_
+#define LIGHTMAP_H_
+
+#include <vector>
+#include "SDL.h"
+#include "BasicTypes.h"
+#include "MazeConstants.h"
+
+class Transparency;
+
+// Per-cell lighting for a PresentationMaze.
+//
+// Light sources (torches, spells...) have a position, radius, colour and intensity.
+// Light floods out from each source over the grid, and is stopped by the same
+// Transparency bits that line_of_sight() uses. The result is a colour per cell
+// that the maze multiplies its fg/bg colours by when rendering.
+//
+// Changes (moving a source, changing a wall) only mark the affected rectangles
+// dirty, and those are recomputed lazily before the next render. recompute_all()
+// splits the whole map into bands and does them on several threads, for map loads.
+class LightMap
+{
+public:
+	typedef Transparency transparency_array_t[MazeConstants::maze_height_max][MazeConstants::maze_width_max];
+
+	LightMap(transparency_array_t* transparency);
+	~LightMap();
+
+	void set_enabled(bool on);
+	bool is_enabled() { return enabled; }
+	void set_size(int lines, int columns);		// the area of the map in use
+	void set_ambient(SDL_Color c);
+
+	int add_light(pos_t line, pos_t column, double radius, SDL_Color colour, double intensity);
+	bool move_light(int id, pos_t line, pos_t column);
+	bool set_light(int id, double radius, SDL_Color colour, double intensity);
+	bool remove_light(int id);
+	void remove_all_lights();
+	int get_light_count() { return static_cast<int>(lights.size()); }
+
+	// the transparency of this cell has changed
+	void cell_changed(int line, int column);
+
+	// bring dirty areas up to date - called before rendering
+	void update();
+	// recompute the whole map using worker threads
+	void recompute_all();
+
+	SDL_Color get_light(int line, int column)
+	{
+		const Uint8* p = &result[(line * MazeConstants::maze_width_max + column) * 3];
+		SDL_Color c = { p[0], p[1], p[2], 255 };
+		return c;
+	}
+	// brightest channel, 0-255, for gameplay use from Lua
+	int get_light_level(int line, int column);
+
+private:
+	// lets not have these copy constructed or assigned
+	LightMap(const LightMap&);
+	LightMap& operator=(const LightMap&);
+
+	struct Light
+	{
+		int id;
+		pos_t line;
+		pos_t column;
+		double radius;
+		SDL_Color colour;
+		double intensity;
+	};
+	struct Rect { int top, left, bottom, right; };	// inclusive
+
+	Light* find_light(int id);
+	Rect light_rect(const Light& l);
+	void mark_dirty(Rect r);
+	bool clip(Rect& r);
+
+	void recompute_rect(const Rect& r);
+	void flood(const Light& l, const Rect& r, std::vector<unsigned char>& visited);
+	static int recompute_thread(void* data);
+
+	transparency_array_t* transparency;
+	bool enabled;
+	int lines;
+	int columns;
+	SDL_Color ambient;
+
+	std::vector<Light> lights;
+	int next_id;
+
+	std::vector<Rect> dirty;
+
+	// per cell accumulated light (r,g,b floats) and the final clamped colour (r,g,b bytes)
+	std::vector<float> accumulated;
+	std::vector<Uint8> result;
+};
+
+#endif /* LIGHTMAP_H_ */
@@ -0,0 +1,341 @@
+/*
+ * LuaAllocator.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#include "LuaAllocator.h"
+#include "ElementPool.h"
+#include "Utilities.h"
+#include "lauxlib.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <new>
+#ifdef _MSC_VER
+#include <ciso646>   // Visual Studio is not C++ standards complaint...
+#endif
+
+// Size classes. Most Lua allocations are well under 256 bytes: a Table is 56
+// on a 64 bit machine, a Lua closure 40 plus 8 per upvalue, a short string 24
+// plus the characters.
+static const size_t size_classes[] = { 16, 32, 48, 64, 80, 96, 128, 160, 192, 256 };
+static const int num_size_classes = sizeof(size_classes)/sizeof(size_classes[0]);
+static const size_t largest_pooled = 256;
+static const size_t class_granularity = 16;
+static const size_t blocks_per_slab_bytes = 16*1024;
+
+// size (rounded up to class_granularity) -> size class
+static signed char class_lookup[largest_pooled/class_granularity + 1];
+static bool class_lookup_built = false;
+
+static void build_class_lookup()
+{
+    int c = 0;
+    for(size_t i = 0; i <= largest_pooled/class_granularity; i++)
+    {
+        while(size_classes[c] < i * class_granularity) c++;
+        class_lookup[i] = static_cast<signed char>(c);
+    }
+    class_lookup_built = true;
+}
+
+// -1 for anything not pooled
+static inline int size_class(size_t size)
+{
+    if(size > largest_pooled) return -1;
+    return class_lookup[(size + class_granularity - 1) / class_granularity];
+}
+
+static SDL_SpinLock list_lock = 0;
+static std::vector<LuaAllocator*>& allocator_list()
+{
+    static std::vector<LuaAllocator*>* list = new std::vector<LuaAllocator*>;     // never deleted, states can outlive statics
+    return *list;
+}
+static SDL_atomic_t allocators_created = { 0 };
+
+
+LuaAllocator::LuaAllocator()
+: limit(0)
+, bytes(0)
+, peak_bytes(0)
+, blocks(0)
+, allocation_count(0)
+, refused_count(0)
+{
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "Lua%d", SDL_AtomicAdd(&allocators_created, 1) + 1);
+    name = buffer;
+
+    lock_list();
+    if(not class_lookup_built) build_class_lookup();
+    allocator_list().push_back(this);
+    unlock_list();
+
+    for(int i = 0; i < num_size_classes; i++)
+    {
+        pools.push_back(new FixedBlockPool("Lua", size_classes[i], blocks_per_slab_bytes / size_classes[i], false));
+    }
+}
+
+LuaAllocator::~LuaAllocator()
+{
+    lock_list();
+    std::vector<LuaAllocator*>& list = allocator_list();
+    list.erase(std::remove(list.begin(), list.end(), this), list.end());
+    unlock_list();
+
+    // the state must be closed by now
+    for(size_t i = 0; i < pools.size(); i++)
+    {
+        delete pools[i];
+    }
+}
+
+void* LuaAllocator::allocate(size_t size)
+{
+    int c = size_class(size);
+    void* p;
+    if(c >= 0)
+    {
+        try {
+            p = pools[c]->allocate();
+        }
+        catch(std::bad_alloc&)
+        {
+            return 0;       // Lua has to see NULL, it'll tidy up and raise the error
+        }
+    }
+    else
+    {
+        p = std::malloc(size);
+        if(p == 0) return 0;
+    }
+    blocks++;
+    allocation_count++;
+    return p;
+}
+
+void LuaAllocator::deallocate(void* ptr, size_t size)
+{
+    int c = size_class(size);
+    if(c >= 0)
+    {
+        pools[c]->deallocate(ptr);
+    }
+    else
+    {
+        std::free(ptr);
+    }
+    blocks--;
+}
+
+void* LuaAllocator::alloc(void* ud, void* ptr, size_t osize, size_t nsize)
+{
+    LuaAllocator* a = static_cast<LuaAllocator*>(ud);
+    if(ptr == 0)
+    {
+        osize = 0;      // for new blocks it's the object type, not a size
+    }
+
+    if(nsize == 0)
+    {
+        if(ptr)
+        {
+            a->deallocate(ptr, osize);
+            a->bytes -= osize;
+        }
+        return 0;
+    }
+
+    // Lua assumes shrinking always works, so only growth is refused
+    if(a->limit and nsize > osize and a->bytes - osize + nsize > a->limit)
+    {
+        a->refused_count++;
+        return 0;
+    }
+
+    void* p;
+    int old_class = ptr ? size_class(osize) : -2;
+    int new_class = size_class(nsize);
+    if(ptr and old_class == new_class and new_class >= 0)
+    {
+        p = ptr;        // still fits the same block
+    }
+    else if(ptr and old_class < 0 and new_class < 0)
+    {
+        p = std::realloc(ptr, nsize);
+        if(p == 0) return 0;
+        a->allocation_count++;
+    }
+    else
+    {
+        p = a->allocate(nsize);
+        if(p == 0) return 0;
+        if(ptr)
+        {
+            std::memcpy(p, ptr, std::min(osize, nsize));
+            a->deallocate(ptr, osize);
+        }
+    }
+
+    a->bytes += nsize - osize;
+    if(a->bytes > a->peak_bytes) a->peak_bytes = a->bytes;
+    return p;
+}
+
+LuaAllocator* LuaAllocator::of(lua_State* L)
+{
+    void* ud = 0;
+    if(lua_getallocf(L, &ud) != &LuaAllocator::alloc) return 0;
+    return static_cast<LuaAllocator*>(ud);
+}
+
+int LuaAllocator::stats(lua_State* L)
+{
+    LuaAllocator* a = of(L);
+    if(a == 0)
+    {
+        lua_pushnil(L);
+        return 1;
+    }
+    lua_createtable(L, 0, 7);
+    lua_pushstring(L, a->name.c_str()); lua_setfield(L, -2, "name");
+    lua_pushnumber(L, static_cast<lua_Number>(a->bytes)); lua_setfield(L, -2, "bytes");
+    lua_pushnumber(L, static_cast<lua_Number>(a->peak_bytes)); lua_setfield(L, -2, "peak_bytes");
+    lua_pushnumber(L, static_cast<lua_Number>(a->blocks)); lua_setfield(L, -2, "blocks");
+    lua_pushnumber(L, static_cast<lua_Number>(a->allocation_count)); lua_setfield(L, -2, "allocations");
+    lua_pushnumber(L, static_cast<lua_Number>(a->refused_count)); lua_setfield(L, -2, "refused");
+    lua_pushnumber(L, static_cast<lua_Number>(a->limit)); lua_setfield(L, -2, "limit");
+    return 1;
+}
+
+int LuaAllocator::limit_memory(lua_State* L)
+{
+    lua_Number n = luaL_checknumber(L, 1);
+    LuaAllocator* a = of(L);
+    if(a == 0)
+    {
+        return luaL_error(L, "LuaAllocator.limit_memory - this Lua state doesn't use the engine allocator");
+    }
+    a->set_limit(n > 0 ? static_cast<size_t>(n) : 0);
+    return 0;
+}
+
+void LuaAllocator::lock_list()
+{
+    SDL_AtomicLock(&list_lock);
+}
+
+void LuaAllocator::unlock_list()
+{
+    SDL_AtomicUnlock(&list_lock);
+}
+
+const std::vector<LuaAllocator*>& LuaAllocator::get_list()
+{
+    return allocator_list();
+}
+
+
+//
+// Benchmark
+//
+namespace {
+
+    // the sort of thing game scripts do every frame
+    const char* benchmark_script =
+        "local n = ...\n"
+        "local keep = {}\n"
+        "for i = 1, n do\n"
+        "    local v = { x = i, y = i * 2 }\n"
+        "    local f = function() return v.x + v.y end\n"
+        "    local s = 'id' .. (i % 1000)\n"
+        "    keep[i % 64] = { v, f, s }\n"
+        "end\n";
+
+    void* system_alloc(void* ud, void* ptr, size_t osize, size_t nsize)
+    {
+        (void)ud; (void)osize;
+        if(nsize == 0)
+        {
+            std::free(ptr);
+            return 0;
+        }
+        return std::realloc(ptr, nsize);
+    }
+
+    // returns seconds taken, or 0 if the script failed
+    double run_benchmark(lua_Alloc f, void* ud, int iterations)
+    {
+        Uint64 start = SDL_GetPerformanceCounter();
+        lua_State* L = lua_newstate(f, ud);
+        if(L == 0) return 0;
+        int status = luaL_loadstring(L, benchmark_script);
+        if(status == LUA_OK)
+        {
+            lua_pushinteger(L, iterations);
+            status = lua_pcall(L, 1, 0, 0);
+        }
+        lua_close(L);
+        Uint64 end = SDL_GetPerformanceCounter();
+
+        if(status != LUA_OK) return 0;
+        return double(end - start) / SDL_GetPerformanceFrequency();
+    }
+
+}
+
+int LuaAllocator::benchmark(lua_State* L)
+{
+    int iterations = static_cast<int>(luaL_optinteger(L, 1, 200000));
+    if(iterations < 1) iterations = 1;
+
+    double system_time = run_benchmark(&system_alloc, 0, iterations);
+    double pooled_time;
+    size_t pooled_allocations;
+    {
+        LuaAllocator a;
+        pooled_time = run_benchmark(&LuaAllocator::alloc, &a, iterations);
+        pooled_allocations = a.get_allocation_count();
+    }
+    double system_rate = system_time > 0 ? iterations / system_time : 0;
+    double pooled_rate = pooled_time > 0 ? iterations / pooled_time : 0;
+
+    Utilities::debugMessage("LuaAllocator benchmark: system %.0f iterations/s, pooled %.0f iterations/s (%lu allocations per run)",
+                            system_rate, pooled_rate, static_cast<unsigned long>(pooled_allocations));
+
+    lua_createtable(L, 0, 2);
+    lua_pushnumber(L, system_rate);
+    lua_setfield(L, -2, "system");
+    lua_pushnumber(L, pooled_rate);
+    lua_setfield(L, -2, "pooled");
+    return 1;
+}
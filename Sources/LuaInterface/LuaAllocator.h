@@ -0,0 +1,110 @@
+/*
+ * LuaAllocator.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#ifndef LUAALLOCATOR_H_
+#define LUAALLOCATOR_H_
+
+#include "SDL.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "lua.h"
+
+class FixedBlockPool;
+
+// Memory allocator for one Lua state (see lua_newstate).
+//
+// Small blocks (tables, closures, short strings, upvalues) come from size
+// class pools, everything bigger goes to realloc. Lua tells us the old size
+// of every block it frees or resizes, so blocks don't need a header.
+//
+// Each state keeps its own pools, so there's no locking - a Lua state is only
+// ever used by one thread at a time.
+//
+// Also counts how much each state is using, for the debug display, and can
+// refuse to let a state grow past a limit (Lua then raises a memory error
+// in the script that asked for it).
+class LuaAllocator {
+public:
+    LuaAllocator();
+    ~LuaAllocator();
+
+    static void* alloc(void* ud, void* ptr, size_t osize, size_t nsize);   // a lua_Alloc, ud is the LuaAllocator
+
+    void set_limit(size_t bytes) { limit = bytes; }     // 0 = no limit
+    size_t get_limit() { return limit; }
+
+    // These are only written by the thread running the state. Other threads
+    // (i.e. the debug display) can read them, but might see a slightly old value.
+    size_t get_bytes() { return bytes; }
+    size_t get_peak_bytes() { return peak_bytes; }
+    size_t get_blocks() { return blocks; }
+    size_t get_allocation_count() { return allocation_count; }
+    size_t get_refused_count() { return refused_count; }
+    const std::string& get_name() { return name; }
+
+    // the allocator of a state created with one, or 0
+    static LuaAllocator* of(lua_State* L);
+
+    // called from Lua on the calling state's allocator
+    static int stats(lua_State* L);         // LuaAllocator.stats() returns a table
+    static int limit_memory(lua_State* L);  // LuaAllocator.limit_memory(bytes), 0 = no limit
+
+    // LuaAllocator.benchmark([iterations]) times a table/closure/string heavy
+    // script with the system allocator and with this one.
+    // Returns { system = iterations/s, pooled = iterations/s }
+    static int benchmark(lua_State* L);
+
+    // every allocator currently alive, for the debug display. Hold the lock
+    // while looking at the list.
+    static void lock_list();
+    static void unlock_list();
+    static const std::vector<LuaAllocator*>& get_list();
+
+private:
+    // lets not have these copy constructed or assigned
+    LuaAllocator(const LuaAllocator&);
+    LuaAllocator& operator=(const LuaAllocator&);
+
+    void* allocate(size_t size);
+    void deallocate(void* ptr, size_t size);
+
+    std::vector<FixedBlockPool*> pools;     // one per size class
+    std::string name;
+    size_t limit;
+    size_t bytes;
+    size_t peak_bytes;
+    size_t blocks;
+    size_t allocation_count;
+    size_t refused_count;
+};
+
+#endif /* LUAALLOCATOR_H_ */
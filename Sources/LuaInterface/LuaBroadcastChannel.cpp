@@ -0,0 +1,300 @@
+/*
+ * LuaBroadcastChannel.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#include "LuaBroadcastChannel.h"
+#include "LuaMessage.h"
+#include "lauxlib.h"
+#include "Utilities.h"
+#ifdef _MSC_VER
+#include <ciso646>   // Visual Studio is not C++ standards complaint...
+#endif
+
+// Publishing is serialize (no locks), then a spinlock to get a sequence number
+// and a per-slot spinlock to swap the message in. Reading is a per-slot spinlock
+// just long enough to add a reference to the message - decoding happens outside
+// any lock. So lots of subscribers reading the same message at once only
+// contend for a few instructions each.
+
+static void LBC_abort(const char* s)
+{
+    Utilities::fatalError("LuaBroadcastChannel failed to %s (SDL Error %s)",  s, SDL_GetError());
+}
+
+LuaBroadcastChannel::LuaBroadcastChannel(std::string identifier_name, int capacity)
+: slots(capacity < 1 ? 1 : capacity)
+, publish_lock(0)
+, published(0)
+, id(identifier_name)
+{
+    for(size_t i = 0; i < slots.size(); i++)
+    {
+        slots[i].lock = 0;
+        slots[i].sequence = 0;
+        slots[i].message = 0;
+    }
+    SDL_AtomicSet(&subscribers, 0);
+    SDL_AtomicSet(&waiters, 0);
+    wait_mutex = SDL_CreateMutex(); if(wait_mutex == 0) {  LBC_abort("create mutex"); }
+    wait_cond = SDL_CreateCond(); if(wait_cond == 0) { LBC_abort("create condition"); }
+}
+
+LuaBroadcastChannel::~LuaBroadcastChannel()
+{
+    if(SDL_AtomicGet(&subscribers))
+    {
+        Utilities::debugMessage("LuaBroadcastChannel %s deleted with %d subscribers", id.c_str(), SDL_AtomicGet(&subscribers));
+    }
+    for(size_t i = 0; i < slots.size(); i++)
+    {
+        if(slots[i].message) slots[i].message->release();
+    }
+    SDL_DestroyMutex(wait_mutex);
+    SDL_DestroyCond(wait_cond);
+}
+
+double LuaBroadcastChannel::publish(lua_State* L)
+{
+    LuaMessage* m = LuaMessage::acquire();
+    if(not m->encode(L, -1))
+    {
+        m->release();
+        luaL_error(L, "LuaBroadcastChannel %s: message nested too deeply", id.c_str());
+    }
+
+    SDL_AtomicLock(&publish_lock);
+    Uint64 sequence = published;
+    Slot& slot = slots[sequence % slots.size()];
+    SDL_AtomicLock(&slot.lock);
+    LuaMessage* old = slot.message;
+    slot.message = m;
+    slot.sequence = sequence;
+    SDL_AtomicUnlock(&slot.lock);
+    published = sequence + 1;
+    SDL_AtomicUnlock(&publish_lock);
+
+    // subscribers that already took a reference keep the old one alive
+    if(old) old->release();
+
+    // a read-modify-write, so it's a full barrier against the publish above
+    if(SDL_AtomicAdd(&waiters, 0))
+    {
+        if(SDL_LockMutex(wait_mutex) != 0) { LBC_abort("lock mutex in publish"); }
+        if(SDL_CondBroadcast(wait_cond) != 0) { LBC_abort("broadcast"); }
+        if(SDL_UnlockMutex(wait_mutex) != 0) { LBC_abort("unlock mutex in publish"); }
+    }
+    return static_cast<double>(sequence);
+}
+
+Uint64 LuaBroadcastChannel::next_sequence()
+{
+    SDL_AtomicLock(&publish_lock);
+    Uint64 s = published;
+    SDL_AtomicUnlock(&publish_lock);
+    return s;
+}
+
+Uint64 LuaBroadcastChannel::oldest_sequence()
+{
+    Uint64 next = next_sequence();
+    return next > slots.size() ? next - slots.size() : 0;
+}
+
+double LuaBroadcastChannel::get_published_count()
+{
+    return static_cast<double>(next_sequence());
+}
+
+LuaBroadcastChannel::take_result_t LuaBroadcastChannel::take(Uint64 sequence, LuaMessage*& m)
+{
+    Slot& slot = slots[sequence % slots.size()];
+    take_result_t result;
+    SDL_AtomicLock(&slot.lock);
+    if(slot.message and slot.sequence == sequence)
+    {
+        m = slot.message;
+        m->add_ref();
+        result = TAKEN;
+    }
+    else if(slot.message and slot.sequence > sequence)
+    {
+        result = LAPPED;
+    }
+    else
+    {
+        result = NOT_YET;
+    }
+    SDL_AtomicUnlock(&slot.lock);
+    return result;
+}
+
+// wait until 'sequence' has been published, or we run out of time
+bool LuaBroadcastChannel::wait(Uint64 sequence, Uint32 ms)
+{
+    if(ms == 0)
+    {
+        return next_sequence() > sequence;
+    }
+
+    bool available = false;
+    Uint32 start = SDL_GetTicks();
+    if(SDL_LockMutex(wait_mutex) != 0) { LBC_abort("lock mutex in read"); }
+    SDL_AtomicAdd(&waiters, 1);
+    for(;;)
+    {
+        if(next_sequence() > sequence)
+        {
+            available = true;
+            break;
+        }
+        Uint32 remaining = ms;
+        if(ms != SDL_MUTEX_MAXWAIT)
+        {
+            Uint32 elapsed = SDL_GetTicks() - start;
+            if(elapsed >= ms)
+            {
+                break;
+            }
+            remaining = ms - elapsed;
+        }
+        if(SDL_CondWaitTimeout(wait_cond, wait_mutex, remaining) < 0) { LBC_abort("wait on signal"); }
+    }
+    SDL_AtomicAdd(&waiters, -1);
+    if(SDL_UnlockMutex(wait_mutex) != 0) { LBC_abort("unlock mutex in read"); }
+    return available;
+}
+
+
+LuaBroadcastSubscriber::LuaBroadcastSubscriber(LuaBroadcastChannel* c)
+: channel(c)
+, cursor(0)
+, missed(0)
+{
+    if(not channel)
+    {
+        Utilities::fatalError("LuaBroadcastSubscriber needs a channel");
+    }
+    cursor = channel->next_sequence();
+    SDL_AtomicAdd(&channel->subscribers, 1);
+}
+
+LuaBroadcastSubscriber::~LuaBroadcastSubscriber()
+{
+    SDL_AtomicAdd(&channel->subscribers, -1);
+}
+
+LuaMessage* LuaBroadcastSubscriber::next(Uint32 ms)
+{
+    for(;;)
+    {
+        LuaMessage* m = 0;
+        switch(channel->take(cursor, m))
+        {
+            case LuaBroadcastChannel::TAKEN:
+                cursor++;
+                return m;
+            case LuaBroadcastChannel::LAPPED:
+            {
+                // we've been too slow, go to the oldest one still there
+                Uint64 oldest = channel->oldest_sequence();
+                if(oldest > cursor)
+                {
+                    missed += oldest - cursor;
+                    cursor = oldest;
+                }
+                break;
+            }
+            case LuaBroadcastChannel::NOT_YET:
+                if(not channel->wait(cursor, ms))
+                {
+                    return 0;
+                }
+                break;
+        }
+    }
+}
+
+int LuaBroadcastSubscriber::read(lua_State* L)
+{
+    lua_pushnumber(L, SDL_MUTEX_MAXWAIT);
+    return read_timeout(L);
+}
+
+int LuaBroadcastSubscriber::read_timeout(lua_State* L)
+{
+    Uint32 ms = lua_tonumber(L, -1);
+    lua_pop(L, 1);
+
+    LuaMessage* m = next(ms);
+    if(not m)
+    {
+        lua_pushnil(L);
+        return 1;
+    }
+    int return_values = m->decode(L);
+    m->release();
+    return return_values;
+}
+
+int LuaBroadcastSubscriber::read_latest(lua_State* L)
+{
+    Uint64 latest = channel->next_sequence();
+    if(latest <= cursor)
+    {
+        lua_pushnil(L);     // nothing new
+        return 1;
+    }
+    cursor = latest - 1;    // the newest one
+    LuaMessage* m = next(0);
+    if(not m)
+    {
+        lua_pushnil(L);
+        return 1;
+    }
+    int return_values = m->decode(L);
+    m->release();
+    return return_values;
+}
+
+int LuaBroadcastSubscriber::skip_to_latest()
+{
+    Uint64 latest = channel->next_sequence();
+    int skipped = latest > cursor ? static_cast<int>(latest - cursor) : 0;
+    cursor = latest;
+    return skipped;
+}
+
+int LuaBroadcastSubscriber::get_pending()
+{
+    Uint64 latest = channel->next_sequence();
+    Uint64 oldest = channel->oldest_sequence();
+    Uint64 from = cursor > oldest ? cursor : oldest;
+    return latest > from ? static_cast<int>(latest - from) : 0;
+}
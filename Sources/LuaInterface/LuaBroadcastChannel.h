@@ -0,0 +1,128 @@
+/*
+ * LuaBroadcastChannel.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#ifndef LUABROADCASTCHANNEL_H_
+#define LUABROADCASTCHANNEL_H_
+
+#include "SDL.h"
+#include <string>
+#include <vector>
+#include "lua.h"
+
+class LuaMessage;
+
+// One to many messages between Lua states.
+//
+// publish() serializes the value once into a LuaMessage. Every subscriber
+// then decodes that same, immutable, buffer - so the cost of publishing doesn't
+// go up with the number of subscribers.
+//
+// The channel keeps the last 'capacity' messages. Each LuaBroadcastSubscriber has
+// its own read position; a subscriber that falls more than 'capacity' behind
+// loses the oldest messages (see get_missed()), and one that only cares about
+// the current state can skip_to_latest().
+//
+// Like LuaStateQueue, the channel must outlive its subscribers.
+class LuaBroadcastChannel {
+public:
+    LuaBroadcastChannel(std::string identifier_name, int capacity);
+    ~LuaBroadcastChannel();
+
+    // returns the sequence number of the message
+    double publish(lua_State* L);
+
+    std::string get_identifier() { return id; }
+    int get_capacity() { return static_cast<int>(slots.size()); }
+    int get_subscriber_count() { return SDL_AtomicGet(&subscribers); }
+    double get_published_count();
+
+private:
+    friend class LuaBroadcastSubscriber;
+
+    // lets not have these copy constructed or assigned
+    LuaBroadcastChannel(const LuaBroadcastChannel&);
+    LuaBroadcastChannel& operator=(const LuaBroadcastChannel&);
+
+    enum take_result_t { TAKEN, NOT_YET, LAPPED };
+    // get a reference to message 'sequence', if it's still there
+    take_result_t take(Uint64 sequence, LuaMessage*& m);
+    Uint64 next_sequence();
+    Uint64 oldest_sequence();
+    bool wait(Uint64 sequence, Uint32 ms);
+
+    struct Slot {
+        SDL_SpinLock lock;
+        Uint64 sequence;
+        LuaMessage* message;
+    };
+    std::vector<Slot> slots;
+
+    SDL_SpinLock publish_lock;
+    Uint64 published;           // sequence number of the next message
+
+    std::string id;
+    SDL_atomic_t subscribers;
+
+    // only used when subscribers need to sleep
+    SDL_atomic_t waiters;
+    SDL_mutex* wait_mutex;
+    SDL_cond* wait_cond;
+};
+
+
+class LuaBroadcastSubscriber {
+public:
+    // starts at the next message published
+    LuaBroadcastSubscriber(LuaBroadcastChannel* channel);
+    ~LuaBroadcastSubscriber();
+
+    // these return the message, or nil
+    int read(lua_State* L);                 // waits forever
+    int read_timeout(lua_State* L);         // read_timeout(ms)
+    int read_latest(lua_State* L);          // newest message only, doesn't wait
+
+    int skip_to_latest();                   // returns the number of messages skipped
+    int get_pending();
+    double get_missed() { return static_cast<double>(missed); }
+
+private:
+    // lets not have these copy constructed or assigned
+    LuaBroadcastSubscriber(const LuaBroadcastSubscriber&);
+    LuaBroadcastSubscriber& operator=(const LuaBroadcastSubscriber&);
+
+    LuaMessage* next(Uint32 ms);
+
+    LuaBroadcastChannel* channel;
+    Uint64 cursor;
+    Uint64 missed;
+};
+
+#endif /* LUABROADCASTCHANNEL_H_ */
@@ -0,0 +1,372 @@
+/*
+ * LuaBytecodeCache.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#include "LuaBytecodeCache.h"
+#include "GameConfig.h"
+#include "SaveDataPath.h"
+#include "AssetArchive.h"
+#include "VirtualFileSystem.h"
+#include "Utilities.h"
+#include "lauxlib.h"
+#include "sha256.hpp"
+#include "SDL.h"
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#ifdef _MSC_VER
+#include <ciso646>   // Visual Studio is not C++ standards complaint...
+#endif
+
+static const char cache_magic[4] = { 'F', 'F', 'B', 'C' };
+static const size_t hash_size = 256/8;
+
+static bool cache_enabled = true;
+static bool cache_save_path_ready = false;
+static SDL_atomic_t cache_hits = { 0 };
+static SDL_atomic_t cache_compiles = { 0 };
+static SDL_atomic_t cache_load_us = { 0 };
+static SDL_atomic_t cache_write_failures = { 0 };
+static SDL_atomic_t temp_file_counter = { 0 };
+
+
+static bool read_whole_file(const char* filename, std::string& contents)
+{
+    FILE* f = fopen(filename, "rb");
+    if(f == 0) return false;
+    char buffer[8192];
+    size_t n;
+    contents.clear();
+    while((n = fread(buffer, 1, sizeof(buffer), f)) > 0)
+    {
+        contents.append(buffer, n);
+    }
+    bool ok = not ferror(f);
+    fclose(f);
+    return ok;
+}
+
+static std::string sha256(const std::string& s)
+{
+    sha256_state state;
+    sha_init(state);
+    sha_process(state, s.data(), static_cast<std::uint32_t>(s.size()));
+    char result[hash_size];
+    sha_done(state, result);
+    return std::string(result, hash_size);
+}
+
+static std::string to_hex(const std::string& s)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    for(size_t i = 0; i < s.size(); i++)
+    {
+        unsigned char c = static_cast<unsigned char>(s[i]);
+        hex += digits[c >> 4];
+        hex += digits[c & 15];
+    }
+    return hex;
+}
+
+// everything the compiled chunk depends on
+static std::string cache_key(const std::string& source)
+{
+    char versions[128];
+    snprintf(versions, sizeof(versions), "|%f|%s|%d|%d|%d",
+             forlorn_fox_engine_version, LUA_RELEASE,
+             static_cast<int>(sizeof(lua_Number)), static_cast<int>(sizeof(size_t)), static_cast<int>(sizeof(int)));
+    return sha256(source + versions);
+}
+
+static int bytecode_writer(lua_State* L, const void* p, size_t size, void* ud)
+{
+    (void)L;
+    static_cast<std::string*>(ud)->append(static_cast<const char*>(p), size);
+    return 0;
+}
+
+static void write_cache_file(const std::string& cache_path, const std::string& contents)
+{
+    // write it somewhere else first, so another thread (or a crash) never
+    // sees half a file
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%d.tmp", SDL_AtomicAdd(&temp_file_counter, 1));
+    std::string temp_path = cache_path + suffix;
+
+    FILE* f = fopen(temp_path.c_str(), "wb");
+    bool ok = (f != 0);
+    if(ok)
+    {
+        ok = fwrite(contents.data(), 1, contents.size(), f) == contents.size();
+        ok = (fclose(f) == 0) and ok;
+    }
+    if(ok)
+    {
+        remove(cache_path.c_str());     // rename won't replace on Windows
+        ok = rename(temp_path.c_str(), cache_path.c_str()) == 0;
+        VirtualFileSystem::notify_written_path(cache_path.c_str());
+    }
+    if(not ok)
+    {
+        remove(temp_path.c_str());
+        if(SDL_AtomicAdd(&cache_write_failures, 1) == 0)
+        {
+            Utilities::debugMessage("LuaBytecodeCache couldn't write %s", cache_path.c_str());
+        }
+    }
+}
+
+static int load_with_cache(lua_State* L, const char* filename, const char* text, size_t length, const char* chunkname)
+{
+    if(not cache_enabled or not cache_save_path_ready or length == 0 or text[0] == LUA_SIGNATURE[0])
+    {
+        return luaL_loadbuffer(L, text, length, chunkname);
+    }
+
+    SaveDataPath cache_file("luacache_" + to_hex(sha256(filename)).substr(0, 32) + ".luac");
+    if(cache_file.c_str() == 0)
+    {
+        return luaL_loadbuffer(L, text, length, chunkname);
+    }
+    std::string cache_path = cache_file.str();
+    std::string key = cache_key(std::string(text, length));
+
+    std::string cached;
+    if(read_whole_file(cache_path.c_str(), cached)
+       and cached.size() > sizeof(cache_magic) + hash_size
+       and cached.compare(0, sizeof(cache_magic), cache_magic, sizeof(cache_magic)) == 0
+       and cached.compare(sizeof(cache_magic), hash_size, key) == 0)
+    {
+        size_t header = sizeof(cache_magic) + hash_size;
+        int status = luaL_loadbufferx(L, cached.data() + header, cached.size() - header, chunkname, "b");
+        if(status == LUA_OK)
+        {
+            SDL_AtomicAdd(&cache_hits, 1);
+            return LUA_OK;
+        }
+        lua_pop(L, 1);      // bad cache file, compile it again
+    }
+
+    int status = luaL_loadbuffer(L, text, length, chunkname);
+    if(status != LUA_OK) return status;
+    SDL_AtomicAdd(&cache_compiles, 1);
+
+    std::string contents(cache_magic, sizeof(cache_magic));
+    contents += key;
+    if(lua_dump(L, bytecode_writer, &contents) == 0)
+    {
+        write_cache_file(cache_path, contents);
+    }
+    return LUA_OK;
+}
+
+int LuaBytecodeCache::load_file(lua_State* L, const char* filename)
+{
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    // scripts in a packed archive are used where they are
+    AssetData asset;
+    std::string file_contents;
+    const char* source;
+    size_t length;
+    if(AssetArchive::read_path(filename, asset))
+    {
+        source = asset.data;
+        length = asset.size;
+    }
+    else if(read_whole_file(filename, file_contents))
+    {
+        source = file_contents.data();
+        length = file_contents.size();
+    }
+    else
+    {
+        lua_pushfstring(L, "cannot open %s: %s", filename, strerror(errno));
+        return LUA_ERRFILE;
+    }
+
+    // same as luaL_loadfile: skip a UTF-8 BOM, and a first line starting
+    // with '#' (but keep its newline so the line numbers are right)
+    if(length >= 3 and memcmp(source, "\xEF\xBB\xBF", 3) == 0)
+    {
+        source += 3;
+        length -= 3;
+    }
+    if(length and source[0] == '#')
+    {
+        const char* eol = static_cast<const char*>(memchr(source, '\n', length));
+        size_t skip = eol ? eol - source : length;
+        source += skip;
+        length -= skip;
+    }
+
+    std::string chunkname = std::string("@") + filename;
+    int status = load_with_cache(L, filename, source, length, chunkname.c_str());
+
+    Uint64 end = SDL_GetPerformanceCounter();
+    SDL_AtomicAdd(&cache_load_us, static_cast<int>((end - start) * 1000000 / SDL_GetPerformanceFrequency()));
+    return status;
+}
+
+
+static bool readable(const char* filename)
+{
+    if(AssetArchive::exists_path(filename)) return true;
+    FILE* f = fopen(filename, "r");
+    if(f == 0) return false;
+    fclose(f);
+    return true;
+}
+
+// as in loadlib.c
+static const char path_separator = ';';
+static const char path_mark = '?';
+
+// Like package.searchpath, but also looks in the packed archives. Pushes the
+// file name, or the list of places tried.
+static bool search_path(lua_State* L, const char* name, const char* path)
+{
+    luaL_Buffer tried;
+    luaL_buffinit(L, &tried);
+    std::string module_path = name;
+    for(size_t i = 0; i < module_path.size(); i++)
+    {
+        if(module_path[i] == '.') module_path[i] = LUA_DIRSEP[0];
+    }
+    std::string templates = path;
+    size_t start = 0;
+    while(start <= templates.size())
+    {
+        size_t end = templates.find(path_separator, start);
+        if(end == std::string::npos) end = templates.size();
+        std::string filename = templates.substr(start, end - start);
+        start = end + 1;
+        if(filename.empty()) continue;
+
+        size_t mark;
+        while((mark = filename.find(path_mark)) != std::string::npos)
+        {
+            filename.replace(mark, 1, module_path);
+        }
+        if(readable(filename.c_str()))
+        {
+            lua_pushstring(L, filename.c_str());
+            return true;
+        }
+        lua_pushfstring(L, "\n\tno file " LUA_QS, filename.c_str());
+        luaL_addvalue(&tried);
+    }
+    luaL_pushresult(&tried);
+    return false;
+}
+
+// package.searchers[2] replacement, the same as searcher_Lua in loadlib.c
+// except for the searching and loading. The package table is upvalue 1.
+static int cached_lua_searcher(lua_State* L)
+{
+    const char* name = luaL_checkstring(L, 1);
+    lua_getfield(L, lua_upvalueindex(1), "path");
+    const char* path = lua_tostring(L, -1);
+    if(path == 0)
+    {
+        return luaL_error(L, LUA_QL("package.path") " must be a string");
+    }
+    if(not search_path(L, name, path))
+    {
+        return 1;       // the list of places tried
+    }
+    const char* filename = lua_tostring(L, -1);
+    if(LuaBytecodeCache::load_file(L, filename) != LUA_OK)
+    {
+        return luaL_error(L, "error loading module " LUA_QS " from file " LUA_QS ":\n\t%s",
+                          name, filename, lua_tostring(L, -1));
+    }
+    lua_pushstring(L, filename);
+    return 2;
+}
+
+void LuaBytecodeCache::install_searcher(lua_State* L)
+{
+    lua_getfield(L, LUA_REGISTRYINDEX, "_LOADED");
+    lua_getfield(L, -1, "package");
+    if(lua_istable(L, -1))
+    {
+        lua_getfield(L, -1, "searchers");
+        if(lua_istable(L, -1))
+        {
+            lua_pushvalue(L, -2);
+            lua_pushcclosure(L, cached_lua_searcher, 1);
+            lua_rawseti(L, -2, 2);
+        }
+        lua_pop(L, 1);
+    }
+    lua_pop(L, 2);
+}
+
+void LuaBytecodeCache::save_path_ready()
+{
+    cache_save_path_ready = true;
+}
+
+void LuaBytecodeCache::set_enabled(bool enabled)
+{
+    cache_enabled = enabled;
+}
+
+int LuaBytecodeCache::get_hits()
+{
+    return SDL_AtomicGet(&cache_hits);
+}
+
+int LuaBytecodeCache::get_compiles()
+{
+    return SDL_AtomicGet(&cache_compiles);
+}
+
+double LuaBytecodeCache::get_load_ms()
+{
+    return SDL_AtomicGet(&cache_load_us) / 1000.0;
+}
+
+int LuaBytecodeCache::stats(lua_State* L)
+{
+    lua_createtable(L, 0, 4);
+    lua_pushboolean(L, cache_enabled and cache_save_path_ready);
+    lua_setfield(L, -2, "active");
+    lua_pushinteger(L, get_hits());
+    lua_setfield(L, -2, "hits");
+    lua_pushinteger(L, get_compiles());
+    lua_setfield(L, -2, "compiles");
+    lua_pushnumber(L, get_load_ms());
+    lua_setfield(L, -2, "load_ms");
+    return 1;
+}
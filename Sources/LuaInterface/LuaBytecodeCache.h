@@ -0,0 +1,66 @@
+/*
+ * LuaBytecodeCache.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#ifndef LUABYTECODECACHE_H_
+#define LUABYTECODECACHE_H_
+
+#include "lua.h"
+
+// Caches compiled Lua scripts in the save data directory, so the parse and
+// compile is only done the first time a script is seen.
+//
+// Each script gets one cache file (named from a hash of its path), holding the
+// lua_dump() of the compiled chunk and a SHA256 of the source text, engine
+// version and Lua version. If any of those change the script is compiled from
+// source again and the cache file rewritten.
+//
+// Used by LuaMain::run_lua_file() and, via a replacement package searcher,
+// require().
+class LuaBytecodeCache {
+public:
+    // like luaL_loadfile(). Pushes the chunk, or an error message.
+    static int load_file(lua_State* L, const char* filename);
+
+    // put our loader in place of require's standard Lua file searcher
+    static void install_searcher(lua_State* L);
+
+    // SaveDataPath can't be used until conf.lua has set the app name, so
+    // scripts before then are always compiled from source.
+    static void save_path_ready();
+    static void set_enabled(bool enabled);          // on by default
+
+    static int get_hits();          // loaded from the cache
+    static int get_compiles();      // compiled from source (and cached if possible)
+    static double get_load_ms();    // total time spent in load_file()
+    static int stats(lua_State* L); // LuaBytecodeCache.stats() returns a table of the above
+};
+
+#endif /* LUABYTECODECACHE_H_ */
@@ -45,14 +45,30 @@
 #include "MySoundManager.h"
 #include "Utilities.h"
 #include "DrawList.h"
+#include "ParticleEmitter.h"
+#include "DisplayList.h"
 #include "Utilities.h"
 #include "PresentationMaze.h"
+#include "GridCollision.h"
 #include "Debug.h"
 #include "MapUtils.h"
 #include "GameToScreenMapping.h"
 #include "glyph_set_utilities.h"
 #include "MouseTarget.h"
 #include "LuaStateQueue.h"
+#include "LuaBroadcastChannel.h"
+#include "LuaJobSystem.h"
+#include "LuaSharedTable.h"
+#include "LuaBytecodeCache.h"
+#include "LuaProfiler.h"
+#include "LuaFastCall.h"
+#include "Trace.h"
+#include "AllocationTracker.h"
+#include "VirtualFileSystem.h"
+#include "MetricsServer.h"
+#include "GlyphArray.h"
+#include "DrawStyle.h"
+#include "TextLayoutCache.h"
 #include "md5.h"
 #include "sha224.hpp"
 #include "sha256.hpp"
@@ -125,18 +141,28 @@
 const std::string master_table_name = "gulp";
 
 
+// LuaThreads still running their function, for the metrics
+static SDL_atomic_t running_lua_threads = { 0 };
+
+int running_lua_thread_count()
+{
+    return SDL_AtomicGet(&running_lua_threads);
+}
+
 // thin wrapper for SDL Thread
 class LuaThread {
 public:
     // no parameters into Lua allowed?
     LuaThread(LuaMain* lua, const char* lua_function, const char* name)
-    :lua_function_name(lua_function), l(lua), running(true)
+    :lua_function_name(lua_function), thread_name(name ? name : "LuaThread"), l(lua), running(true)
     {
+        SDL_AtomicIncRef(&running_lua_threads);
         thread = SDL_CreateThread(run_thread_function, name, (void*)this);
         // throw an except from a constructor on failure?
         if(not thread)
         {
             running = false;
+            SDL_AtomicDecRef(&running_lua_threads);
             //lua_function = SDL_GetError();
             if(thread==0) Utilities::fatalErrorSDL("Failed to create thread");
         }
@@ -193,6 +219,7 @@ public:
 private:
     SDL_Thread* thread;
     std::string lua_function_name;
+    std::string thread_name;        // for the trace, the thread can start before 'thread' is set
     LuaMain* l;
     bool running;           // is the thread running code (or potentially running code)
     
@@ -203,7 +230,10 @@ private:
         if(obj)
         {
             LuaMain& L = *obj->l;
+            FF_TRACE_THREAD_NAME(obj->thread_name.c_str());
+            TraceZone zone(Trace::intern(obj->lua_function_name));
             int error = run_gulp_function_if_exists(obj->l, obj->lua_function_name.c_str(), 0, 1);
+            zone.end();
             if(error == LUA_OK)
             {
                 return_value = (int)lua_tonumber(L, -1);
@@ -220,6 +250,7 @@ private:
         }
         
         obj->running = false;
+        SDL_AtomicDecRef(&running_lua_threads);
         return return_value;
     }
 };
@@ -402,6 +433,16 @@ static void LuaMain_push_queue(LuaMain *L, LuaStateQueue* q)
     luabridge::push(L->get_internal_state(), q);
 }
 
+static void LuaMain_push_channel(LuaMain *L, LuaBroadcastChannel* c)
+{
+    luabridge::push(L->get_internal_state(), c);
+}
+
+static void LuaMain_push_shared_table(LuaMain *L, LuaSharedTable* t)
+{
+    luabridge::push(L->get_internal_state(), t);
+}
+
 class RendererInfo {
 //private:
     SDL_RendererInfo info;
@@ -810,7 +851,35 @@ static void set_up_basic_ff_cpp_bindings(lua_State *L, std::string base_table_na
     .addFunction ("set_developer_mode", &SaveDataPathDeveloper::set_developer_mode)
     .endClass ()
     
+    // index of the save, app and archive files. Call written/removed after
+    // changing files in the save directory (from io.open, etc.), and rescan
+    // after changing SaveDataPath settings.
+    .beginClass <VirtualFileSystem> ("VirtualFileSystem")
+    .addStaticCFunction("resolve", &VirtualFileSystem::resolve)
+    .addStaticCFunction("exists", &VirtualFileSystem::exists)
+    .addStaticCFunction("stat", &VirtualFileSystem::stat)
+    .addStaticCFunction("list", &VirtualFileSystem::list)
+    .addStaticCFunction("read", &VirtualFileSystem::read)
+    .addStaticCFunction("written", &VirtualFileSystem::written)
+    .addStaticCFunction("removed", &VirtualFileSystem::removed)
+    .addStaticFunction("rescan", &VirtualFileSystem::rescan)
+    .endClass ()
     
+    
+
+    .beginClass <LightMap> ("LightMap")
+    .addFunction("set_enabled", &LightMap::set_enabled)
+    .addFunction("is_enabled", &LightMap::is_enabled)
+    .addFunction("set_ambient", &LightMap::set_ambient)
+    .addFunction("add_light", &LightMap::add_light)
+    .addFunction("move_light", &LightMap::move_light)
+    .addFunction("set_light", &LightMap::set_light)
+    .addFunction("remove_light", &LightMap::remove_light)
+    .addFunction("remove_all_lights", &LightMap::remove_all_lights)
+    .addFunction("get_light_count", &LightMap::get_light_count)
+    .addFunction("get_light_level", &LightMap::get_light_level)
+    .addFunction("recompute_all", &LightMap::recompute_all)
+    .endClass()
 
     .beginClass <PresentationMaze> ("PresentationMaze")
     .addConstructor <void (*) (double, double)> ()
@@ -822,6 +891,7 @@ static void set_up_basic_ff_cpp_bindings(lua_State *L, std::string base_table_na
     .addFunction("height", &PresentationMaze::height)
     //.addFunction("get_maze_draw_list", &PresentationMaze::get_maze_draw_list)
     //.addFunction("get_mobs_draw_list", &PresentationMaze::get_mobs_draw_list)
+    .addFunction("get_light_map", &PresentationMaze::get_light_map)
     //.addFunction("set_view_layer", &PresentationMaze::set_view_layer)
     .addFunction("get_glyph", &PresentationMaze::get_glyph)
     .addFunction("set_glyph", &PresentationMaze::set_glyph)
@@ -847,13 +917,129 @@ static void set_up_basic_ff_cpp_bindings(lua_State *L, std::string base_table_na
     //.addProperty("column", &MapUtils::MapFinder::column, &MapUtils::MapFinder::column)
     .endClass()
     
+    .beginClass <GridCollision>("GridCollision")
+    .addConstructor <void (*) (PresentationMaze*)> ()
+    .addFunction("set_box", &GridCollision::set_box)
+    .addFunction("set_circle", &GridCollision::set_circle)
+    .addFunction("set_solid_glyph", &GridCollision::set_solid_glyph)
+    .addFunction("set_solid_glyph_range", &GridCollision::set_solid_glyph_range)
+    .addFunction("clear_solid_glyphs", &GridCollision::clear_solid_glyphs)
+    .addFunction("set_use_transparency", &GridCollision::set_use_transparency)
+    .addFunction("is_solid", &GridCollision::is_solid)
+    .addCFunction("move", &GridCollision::move)
+    .addCFunction("move_all", &GridCollision::move_all)
+    .endClass()
+    
     .beginClass <LuaStateQueue>("LuaStateQueue")
     .addConstructor <void (*) (std::string)> ()
     .addFunction("send", &LuaStateQueue::send)
+    .addFunction("try_send", &LuaStateQueue::try_send)
     .addCFunction("read", &LuaStateQueue::read)
     .addCFunction("read_timeout", &LuaStateQueue::read_timeout)
     .addFunction("is_empty", &LuaStateQueue::is_empty)
     .addFunction("get_identifier", &LuaStateQueue::get_identifier)
+    .addFunction("get_capacity", &LuaStateQueue::get_capacity)
+    .addFunction("get_full_count", &LuaStateQueue::get_full_count)
+    .addStaticCFunction("select", &LuaStateQueue::select)
+    .addStaticCFunction("benchmark", &LuaStateQueue::benchmark)
+    .endClass()
+    
+    .beginClass <LuaBroadcastChannel>("LuaBroadcastChannel")
+    .addConstructor <void (*) (std::string, int)> ()
+    .addFunction("publish", &LuaBroadcastChannel::publish)
+    .addFunction("get_identifier", &LuaBroadcastChannel::get_identifier)
+    .addFunction("get_capacity", &LuaBroadcastChannel::get_capacity)
+    .addFunction("get_subscriber_count", &LuaBroadcastChannel::get_subscriber_count)
+    .addFunction("get_published_count", &LuaBroadcastChannel::get_published_count)
+    .endClass()
+    
+    .beginClass <LuaBroadcastSubscriber>("LuaBroadcastSubscriber")
+    .addConstructor <void (*) (LuaBroadcastChannel*)> ()
+    .addCFunction("read", &LuaBroadcastSubscriber::read)
+    .addCFunction("read_timeout", &LuaBroadcastSubscriber::read_timeout)
+    .addCFunction("read_latest", &LuaBroadcastSubscriber::read_latest)
+    .addFunction("skip_to_latest", &LuaBroadcastSubscriber::skip_to_latest)
+    .addFunction("get_pending", &LuaBroadcastSubscriber::get_pending)
+    .addFunction("get_missed", &LuaBroadcastSubscriber::get_missed)
+    .endClass()
+    
+    .beginClass <LuaJobSystem>("LuaJobSystem")
+    .addConstructor <void (*) (int, std::string)> ()
+    .addCFunction("submit", &LuaJobSystem::submit)
+    .addCFunction("poll", &LuaJobSystem::poll)
+    .addCFunction("result", &LuaJobSystem::result)
+    .addCFunction("wait", &LuaJobSystem::wait)
+    .addFunction("get_worker_count", &LuaJobSystem::get_worker_count)
+    .addFunction("get_pending", &LuaJobSystem::get_pending)
+    .addFunction("get_steal_count", &LuaJobSystem::get_steal_count)
+    .endClass()
+    
+    .beginClass <SharedSnapshotRef>("SharedSnapshot")
+    .addCFunction("get", &SharedSnapshotRef::get)
+    .addCFunction("to_table", &SharedSnapshotRef::to_table)
+    .addFunction("count", &SharedSnapshotRef::count)
+    .endClass()
+    
+    .beginClass <LuaSharedTable>("LuaSharedTable")
+    .addConstructor <void (*) (std::string, int)> ()
+    .addCFunction("get", &LuaSharedTable::get)
+    .addCFunction("set", &LuaSharedTable::set)
+    .addCFunction("compare_and_set", &LuaSharedTable::compare_and_set)
+    .addCFunction("increment", &LuaSharedTable::increment)
+    .addCFunction("get_version", &LuaSharedTable::get_version)
+    .addFunction("snapshot", &LuaSharedTable::snapshot)
+    .addFunction("get_identifier", &LuaSharedTable::get_identifier)
+    .addFunction("count", &LuaSharedTable::count)
+    .endClass()
+    
+    .beginClass <LuaAllocator>("LuaAllocator")
+    .addStaticCFunction("stats", &LuaAllocator::stats)
+    .addStaticCFunction("limit_memory", &LuaAllocator::limit_memory)
+    .addStaticCFunction("benchmark", &LuaAllocator::benchmark)
+    .endClass()
+    
+    .beginClass <LuaFastCall>("LuaFastCall")
+    .addStaticCFunction("benchmark", &LuaFastCall::benchmark)
+    .endClass()
+    
+    .beginClass <AllocationTracker>("AllocationTracker")
+    .addStaticCFunction("stats", &AllocationTracker::stats)
+    .endClass()
+    
+    .beginClass <MetricsServer>("MetricsServer")
+    .addStaticCFunction("start", &MetricsServer::lua_start)
+    .addStaticCFunction("stop", &MetricsServer::lua_stop)
+    .addStaticCFunction("listening", &MetricsServer::lua_listening)
+    .addStaticCFunction("gauge", &MetricsServer::lua_gauge)
+    .addStaticCFunction("counter", &MetricsServer::lua_counter)
+    .addStaticCFunction("remove", &MetricsServer::lua_remove)
+    .addStaticCFunction("snapshot", &MetricsServer::lua_snapshot)
+    .endClass()
+    
+    .beginClass <Trace>("Trace")
+    .addStaticCFunction("begin_zone", &Trace::lua_begin_zone)
+    .addStaticCFunction("end_zone", &Trace::lua_end_zone)
+    .addStaticCFunction("zone", &Trace::lua_zone)
+    .addStaticCFunction("enable", &Trace::lua_enable)
+    .addStaticCFunction("enabled", &Trace::lua_enabled)
+    .addStaticCFunction("set_thread_name", &Trace::lua_set_thread_name)
+    .addStaticCFunction("save", &Trace::lua_save)
+    .endClass()
+    
+    .beginClass <LuaProfiler>("LuaProfiler")
+    .addStaticCFunction("start", &LuaProfiler::lua_start)
+    .addStaticCFunction("stop", &LuaProfiler::lua_stop)
+    .addStaticCFunction("reset", &LuaProfiler::lua_reset)
+    .addStaticCFunction("running", &LuaProfiler::lua_running)
+    .addStaticCFunction("report", &LuaProfiler::lua_report)
+    .addStaticCFunction("print", &LuaProfiler::lua_print)
+    .addStaticCFunction("collapsed", &LuaProfiler::lua_collapsed)
+    .addStaticCFunction("save", &LuaProfiler::lua_save)
+    .endClass()
+    
+    .beginClass <LuaBytecodeCache>("LuaBytecodeCache")
+    .addStaticFunction("set_enabled", &LuaBytecodeCache::set_enabled)
+    .addStaticCFunction("stats", &LuaBytecodeCache::stats)
     .endClass()
     
     .beginClass <LuaMain> ("LuaMain")
@@ -869,6 +1055,8 @@ static void set_up_basic_ff_cpp_bindings(lua_State *L, std::string base_table_na
     .addFunction("run_method_in_gulp_object_if_exists", run_method_in_gulp_object_if_exists)
     .addFunction("LuaMain_push_number", LuaMain_push_number)
     .addFunction("LuaMain_push_queue", LuaMain_push_queue)
+    .addFunction("LuaMain_push_channel", LuaMain_push_channel)
+    .addFunction("LuaMain_push_shared_table", LuaMain_push_shared_table)
     
     .beginClass <LuaThread>("LuaThread")
     .addConstructor <void (*) (LuaMain*, const char*, const char*)> ()
@@ -1481,6 +1669,7 @@ static void set_up_ui_ff_cpp_bindings(lua_State *L, std::string base_table_name)
 
 		.beginClass <MyGraphics> ("MyGraphics")
 			.addFunction("go_to", &MyGraphics::go_to)
+			.addFunction("texture_bytes", &MyGraphics::texture_bytes)
 			.addFunction("set_fg_colour", &MyGraphics::set_fg_colour)
 			.addFunction("set_bg_colour", &MyGraphics::set_bg_colour)
 			.addFunction("set_fg_fullcolour", &MyGraphics::set_fg_fullcolour)
@@ -1495,8 +1684,10 @@ static void set_up_ui_ff_cpp_bindings(lua_State *L, std::string base_table_name)
 			.addFunction("get_line", &MyGraphics::get_line)
             //.addFunction("FillRectColour", &MyGraphics::FillRectColour)
             .addFunction("SetTextureAlphaMod", &MyGraphics::SetTextureAlphaMod)
-            //.addFunction("printEx", &MyGraphics::printEx)     // only 8 parameters are supported...
+            //.addFunction("printEx", &MyGraphics::printEx)     // only 8 parameters are supported... use print_styled
             .addFunction("printExT", &MyGraphics::printExT)
+            .addFunction("print_styled", &MyGraphics::print_styled)
+            .addCFunction("print_run", &MyGraphics::lua_print_run)
 			.addFunction("set_viewport", &MyGraphics::set_viewport)
 
 			.addFunction("DrawRect", &MyGraphics::DrawRect)
@@ -1510,6 +1701,7 @@ static void set_up_ui_ff_cpp_bindings(lua_State *L, std::string base_table_name)
             .addFunction("RenderCopy", &MyGraphics::RenderCopy)
             .addFunction("get_GameTexInfo", &MyGraphics::get_GameTexInfo)
             .addFunction("overwrite_GameTexInfo", &MyGraphics::overwrite_GameTexInfo)
+            .addFunction("text_layout_cache", &MyGraphics::get_text_layout_cache)
 		.endClass()
 
 		.addFunction("print_string", print_cstring)
@@ -1519,6 +1711,38 @@ static void set_up_ui_ff_cpp_bindings(lua_State *L, std::string base_table_name)
         .beginClass<GameTexInfo>("GameTexInfo")
         .endClass()
 
+        .beginClass<GlyphArray>("GlyphArray")
+            .addConstructor <void (*) (int)> ()
+            .addFunction("size", &GlyphArray::size)
+            .addFunction("resize", &GlyphArray::resize)
+            .addFunction("fill", &GlyphArray::fill)
+            .addCFunction("get", &GlyphArray::lua_get)
+            .addCFunction("set", &GlyphArray::lua_set)
+            .addCFunction("set_string", &GlyphArray::lua_set_string)
+            .addStaticCFunction("pack_colour", &GlyphArray::lua_pack_colour)
+        .endClass()
+
+        .beginClass<TextLayoutCache>("TextLayoutCache")
+            .addFunction("set_capacity", &TextLayoutCache::set_capacity)
+            .addFunction("clear", &TextLayoutCache::clear)
+            .addFunction("reset_stats", &TextLayoutCache::reset_stats)
+            .addCFunction("stats", &TextLayoutCache::stats)
+        .endClass()
+
+        .beginClass<DrawStyle>("DrawStyle")
+            .addConstructor <void (*) (luabridge::LuaRef)> ()
+            .addData("scale_x", &DrawStyle::scale_x)
+            .addData("scale_y", &DrawStyle::scale_y)
+            .addData("angle", &DrawStyle::angle)
+            .addData("rot_center_x", &DrawStyle::rot_center_x)
+            .addData("rot_center_y", &DrawStyle::rot_center_y)
+            .addData("flip", &DrawStyle::flip)
+            .addData("alpha", &DrawStyle::alpha)
+            .addFunction("set_colour", &DrawStyle::set_colour)
+            .addFunction("set_fullcolour", &DrawStyle::set_fullcolour)
+            .addFunction("clear_colour", &DrawStyle::clear_colour)
+        .endClass()
+
 		.deriveClass <MyGraphics_render, MyGraphics> ("MyGraphics_render")
 			.addFunction("load_textures_from_glyph_set", &MyGraphics_render::load_textures_from_glyph_set)
 			.addFunction("create_texture_set", &MyGraphics_render::create_texture_set)
@@ -1541,6 +1765,7 @@ static void set_up_ui_ff_cpp_bindings(lua_State *L, std::string base_table_name)
             .addFunction("add_mouse_target", &GameApplication::add_mouse_target)
             .addFunction("run_mouse_target", &GameApplication::run_mouse_target)
             .addFunction("fps_test", &GameApplication::fps_test)
+            .addFunction("set_engine_gc", &GameApplication::set_engine_gc)
 		    //.addFunction("render", &GameApplication::render)
 		.endClass()
 
@@ -1643,6 +1868,81 @@ static void set_up_ui_ff_cpp_bindings(lua_State *L, std::string base_table_name)
 			.addFunction("get_draw_list", &DrawListElement::get_draw_list)
 			.addFunction("set_angle", &DrawListElement::set_angle)
 			.addFunction("get_angle", &DrawListElement::get_angle)
+			.addFunction("set_alpha", &DrawListElement::set_alpha)
+			.addFunction("get_alpha", &DrawListElement::get_alpha)
+			.addFunction("tween", &DrawListElement::tween)
+			.addFunction("tween_after", &DrawListElement::tween_after)
+			.addFunction("set_tween_callback", &DrawListElement::set_tween_callback)
+			.addFunction("stop_tweens", &DrawListElement::stop_tweens)
+			.addFunction("is_tweening", &DrawListElement::is_tweening)
+			.addFunction("animate_glyphs", &DrawListElement::animate_glyphs)
+			.addFunction("stop_glyph_animation", &DrawListElement::stop_glyph_animation)
+		.endClass()
+
+		.beginClass <ParticleEmitter> ("ParticleEmitter")
+			.addConstructor <void (*) (DrawList*, int)> ()
+			.addFunction("show", &ParticleEmitter::show)
+			.addFunction("hide", &ParticleEmitter::hide)
+			.addFunction("is_visible", &ParticleEmitter::is_visible)
+			.addFunction("set_position", &ParticleEmitter::set_position)
+			.addFunction("set_area", &ParticleEmitter::set_area)
+			.addFunction("get_line", &ParticleEmitter::get_line)
+			.addFunction("get_column", &ParticleEmitter::get_column)
+			.addFunction("set_layer", &ParticleEmitter::set_layer)
+			.addFunction("get_layer", &ParticleEmitter::get_layer)
+			.addFunction("set_rate", &ParticleEmitter::set_rate)
+			.addFunction("set_lifetime", &ParticleEmitter::set_lifetime)
+			.addFunction("set_speed", &ParticleEmitter::set_speed)
+			.addFunction("set_direction", &ParticleEmitter::set_direction)
+			.addFunction("set_gravity", &ParticleEmitter::set_gravity)
+			.addFunction("set_drag", &ParticleEmitter::set_drag)
+			.addFunction("set_glyph", &ParticleEmitter::set_glyph)
+			.addFunction("set_glyphs", &ParticleEmitter::set_glyphs)
+			.addFunction("set_colours", &ParticleEmitter::set_colours)
+			.addFunction("set_fade", &ParticleEmitter::set_fade)
+			.addFunction("set_size_ratio", &ParticleEmitter::set_size_ratio)
+			.addFunction("burst", &ParticleEmitter::burst)
+			.addFunction("start", &ParticleEmitter::start)
+			.addFunction("stop", &ParticleEmitter::stop)
+			.addFunction("is_running", &ParticleEmitter::is_running)
+			.addFunction("clear", &ParticleEmitter::clear)
+			.addFunction("get_count", &ParticleEmitter::get_count)
+		.endClass()
+
+		.beginClass <DisplayList> ("DisplayList")
+			.addConstructor <void (*) (DrawList*)> ()
+			.addFunction("clear", &DisplayList::clear)
+			.addFunction("invalidate", &DisplayList::invalidate)
+			.addFunction("is_valid", &DisplayList::is_valid)
+			.addFunction("get_op_count", &DisplayList::get_op_count)
+			.addFunction("go_to", &DisplayList::go_to)
+			.addFunction("print_glyph", &DisplayList::print_glyph)
+			.addFunction("print_at", &DisplayList::print_at)
+			.addFunction("print_string", &DisplayList::print_string)
+			.addFunction("print_styled", &DisplayList::print_styled)
+			.addCFunction("print_run", &DisplayList::lua_print_run)
+			.addFunction("set_fg_colour", &DisplayList::set_fg_colour)
+			.addFunction("set_fg_fullcolour", &DisplayList::set_fg_fullcolour)
+			.addFunction("set_bg_colour", &DisplayList::set_bg_colour)
+			.addFunction("set_bg_fullcolour", &DisplayList::set_bg_fullcolour)
+			.addFunction("set_bg_transparent", &DisplayList::set_bg_transparent)
+			.addFunction("set_bg_opaque", &DisplayList::set_bg_opaque)
+			.addFunction("set_dim_alpha", &DisplayList::set_dim_alpha)
+			.addFunction("set_full_alpha", &DisplayList::set_full_alpha)
+			.addFunction("set_alpha", &DisplayList::set_alpha)
+			.addFunction("wrap", &DisplayList::wrap)
+			.addFunction("set_wrap_limits", &DisplayList::set_wrap_limits)
+			.addFunction("DrawRect", &DisplayList::DrawRect)
+			.addFunction("DrawLine", &DisplayList::DrawLine)
+			.addFunction("DrawPoint", &DisplayList::DrawPoint)
+			.addFunction("FillRect", &DisplayList::FillRect)
+			.addFunction("set_viewport", &DisplayList::set_viewport)
+			.addFunction("replay", &DisplayList::replay)
+			.addFunction("show", &DisplayList::show)
+			.addFunction("hide", &DisplayList::hide)
+			.addFunction("is_visible", &DisplayList::is_visible)
+			.addFunction("set_layer", &DisplayList::set_layer)
+			.addFunction("get_layer", &DisplayList::get_layer)
 		.endClass()
 
 		.beginClass <MazeDrawList> ("MazeDrawList")
@@ -1666,6 +1966,15 @@ static void set_up_ui_ff_cpp_bindings(lua_State *L, std::string base_table_name)
 		.beginClass <Debug>("Debug")
 			.addFunction("set_lua_info_string", &Debug::set_lua_info_string)
             .addFunction("info_toggle", &Debug::info_toggle)
+            .addFunction("hitches", &Debug::hitches)
+		.endClass()
+
+		.beginClass <HitchDetector>("HitchDetector")
+			.addFunction("set_budget", &HitchDetector::set_budget)
+			.addFunction("get_budget", &HitchDetector::get_budget)
+			.addFunction("set_capture", &HitchDetector::set_capture)
+			.addCFunction("stats", &HitchDetector::stats)
+			.addCFunction("last_hitch", &HitchDetector::last_hitch)
 		.endClass()
     
         /*
@@ -1746,6 +2055,15 @@ static void set_up_ui_ff_cpp_bindings(lua_State *L, std::string base_table_name)
         .endClass()
 
 	.endNamespace();
+
+	// per element, per frame calls skip LuaBridge's generic dispatch
+	LUA_FAST_METHOD(L, DrawListElement, set_line);
+	LUA_FAST_METHOD(L, DrawListElement, set_column);
+	LUA_FAST_METHOD(L, DrawListElement, get_line);
+	LUA_FAST_METHOD(L, DrawListElement, get_column);
+	LUA_FAST_METHOD(L, DrawListElement, set_glyph);
+	LUA_FAST_METHOD(L, PresentationMaze, get_glyph);
+	LUA_FAST_METHOD(L, MyGraphics, go_to);
 }
 
 
@@ -55,6 +55,9 @@ int run_method_in_gulp_object_if_exists(LuaMain* l, const char* gulp_subtable, c
 
 #define LUA_FUNCTION_NOT_CALLED -12345
 
+// how many LuaThreads are still running their function
+int running_lua_thread_count();
+
 // for glyph editor
 //void create_and_return_glyph_table(lua_State *L, unsigned int* glyph, int glyph_size);
 //void decode_and_drop_glyph_table(lua_State *L, unsigned int* glyph, int glyph_size);
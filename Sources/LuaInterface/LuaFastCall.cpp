@@ -0,0 +1,134 @@
+/*
+ * LuaFastCall.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#include "LuaFastCall.h"
+#include "BasicTypes.h"
+#include "SDL.h"
+#include "lualib.h"
+#ifdef _MSC_VER
+#include <ciso646>   // Visual Studio is not C++ standards complaint...
+#endif
+
+
+//
+// Benchmark
+//
+namespace {
+
+    // shaped like DrawListElement and PresentationMaze
+    class BenchmarkElement
+    {
+    public:
+        BenchmarkElement() : line(0), column(0) { }
+        void set_line(pos_t l) { line = l; }
+        void set_column(pos_t c) { column = c; }
+        pos_t get_line() { return line; }
+        int get_glyph(int l, int c) { return l * 32 + c; }
+    private:
+        pos_t line;
+        pos_t column;
+    };
+
+    const int calls_per_iteration = 4;
+
+    const char* benchmark_script =
+        "local n = ...\n"
+        "local e = BenchmarkElement()\n"
+        "for i = 1, n do\n"
+        "    e:set_line(i)\n"
+        "    e:set_column(e:get_line() + 1)\n"
+        "    local g = e:get_glyph(i % 24, i % 32)\n"
+        "end\n";
+
+    // returns seconds taken, or 0 if the script failed
+    double run_benchmark(bool fast, int iterations)
+    {
+        lua_State* L = luaL_newstate();
+        if(L == 0) return 0;
+        luaL_requiref(L, "_G", luaopen_base, 1);   // LuaBridge wants _G
+        lua_pop(L, 1);
+        luabridge::getGlobalNamespace(L)
+            .beginClass<BenchmarkElement>("BenchmarkElement")
+                .addConstructor<void (*) ()>()
+                .addFunction("set_line", &BenchmarkElement::set_line)
+                .addFunction("set_column", &BenchmarkElement::set_column)
+                .addFunction("get_line", &BenchmarkElement::get_line)
+                .addFunction("get_glyph", &BenchmarkElement::get_glyph)
+            .endClass();
+        if(fast)
+        {
+            LUA_FAST_METHOD(L, BenchmarkElement, set_line);
+            LUA_FAST_METHOD(L, BenchmarkElement, set_column);
+            LUA_FAST_METHOD(L, BenchmarkElement, get_line);
+            LUA_FAST_METHOD(L, BenchmarkElement, get_glyph);
+        }
+
+        int status = luaL_loadstring(L, benchmark_script);
+        Uint64 start = SDL_GetPerformanceCounter();
+        if(status == LUA_OK)
+        {
+            lua_pushinteger(L, iterations);
+            status = lua_pcall(L, 1, 0, 0);
+        }
+        Uint64 end = SDL_GetPerformanceCounter();
+        if(status != LUA_OK)
+        {
+            Utilities::debugMessage("LuaFastCall benchmark failed: %s", lua_tostring(L, -1));
+        }
+        lua_close(L);
+
+        if(status != LUA_OK) return 0;
+        return double(end - start) / SDL_GetPerformanceFrequency();
+    }
+
+}
+
+int LuaFastCall::benchmark(lua_State* L)
+{
+    int iterations = static_cast<int>(luaL_optinteger(L, 1, 1000000));
+    if(iterations < 1) iterations = 1;
+
+    double luabridge_time = run_benchmark(false, iterations);
+    double fast_time = run_benchmark(true, iterations);
+    double calls = double(iterations) * calls_per_iteration;
+    double luabridge_rate = luabridge_time > 0 ? calls / luabridge_time : 0;
+    double fast_rate = fast_time > 0 ? calls / fast_time : 0;
+
+    Utilities::debugMessage("LuaFastCall benchmark: LuaBridge %.0f calls/s, fast %.0f calls/s",
+                            luabridge_rate, fast_rate);
+
+    lua_createtable(L, 0, 2);
+    lua_pushnumber(L, luabridge_rate);
+    lua_setfield(L, -2, "luabridge");
+    lua_pushnumber(L, fast_rate);
+    lua_setfield(L, -2, "fast");
+    return 1;
+}
@@ -0,0 +1,160 @@
+/*
+ * LuaFastCall.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#ifndef LUAFASTCALL_H_
+#define LUAFASTCALL_H_
+
+#include "lua.h"
+#include "lauxlib.h"
+#include "LuaBridge.h"
+#include "Utilities.h"
+#ifdef _MSC_VER
+#include <ciso646>   // Visual Studio is not C++ standards complaint...
+#endif
+
+// Faster Lua calls for a few hot LuaBridge methods (the ones called for
+// every element, every frame).
+//
+// A LuaBridge method call finds the member function pointer in an upvalue,
+// then checks the object's type by looking up the class keys in the registry,
+// checking for __const and walking the __parent chain. Here the member
+// function is a template argument, so each method gets its own
+// lua_CFunction, and the class metatable is kept in an upvalue when the
+// thunk is registered. If the object's metatable is that one we already
+// know what it is. Anything else - derived classes, const objects, nil,
+// the wrong type - goes the normal LuaBridge way, errors and all.
+//
+// Register the class with LuaBridge as normal, then replace methods with
+//
+//      LUA_FAST_METHOD(L, DrawListElement, set_line);
+//
+// Arguments and return values still use luabridge::Stack, so they behave
+// exactly as before.
+class LuaFastCall
+{
+public:
+    // LuaFastCall.benchmark([iterations]) times the same calls through
+    // LuaBridge and through these thunks, in a state of its own.
+    // Returns { luabridge = calls/s, fast = calls/s }
+    static int benchmark(lua_State* L);
+
+    template <class MemFn, MemFn fn>
+    static void replace(lua_State* L, const char* name)
+    {
+        typedef typename luabridge::FuncTraits<MemFn>::ClassType T;
+        bool is_const = luabridge::FuncTraits<MemFn>::isConstMemberFunction;
+
+        lua_rawgetp(L, LUA_REGISTRYINDEX, luabridge::ClassInfo<T>::getClassKey());
+        if(not lua_istable(L, -1))
+        {
+            Utilities::fatalError("LuaFastCall: class isn't registered for %s", name);
+        }
+        luabridge::rawgetfield(L, -1, name);
+        bool bound = not lua_isnil(L, -1);
+        lua_pop(L, 1);
+        if(not bound)
+        {
+            Utilities::fatalError("LuaFastCall: %s isn't bound", name);
+        }
+
+        lua_pushvalue(L, -1);
+        lua_pushcclosure(L, &Thunk<MemFn, fn>::f, 1);
+        if(is_const)
+        {
+            lua_rawgetp(L, LUA_REGISTRYINDEX, luabridge::ClassInfo<T>::getConstKey());
+            lua_pushvalue(L, -2);
+            luabridge::rawsetfield(L, -2, name);    // const table
+            lua_pop(L, 1);
+        }
+        luabridge::rawsetfield(L, -2, name);        // class table
+        lua_pop(L, 1);
+    }
+
+private:
+    // Userdata::m_p is protected, but a pointer to it can be had from a
+    // derived class
+    struct UserdataPointer : public luabridge::Userdata
+    {
+        static void* luabridge::Userdata::* member() { return &UserdataPointer::m_p; }
+    };
+
+    // argument 1 as a T*, quickly if it has the metatable in upvalue 1
+    template <class T>
+    static T* self(lua_State* L, bool can_be_const)
+    {
+        if(lua_type(L, 1) == LUA_TUSERDATA and lua_getmetatable(L, 1))
+        {
+            bool same = lua_rawequal(L, -1, lua_upvalueindex(1));
+            lua_pop(L, 1);
+            if(same)
+            {
+                luabridge::Userdata* ud = static_cast<luabridge::Userdata*>(lua_touserdata(L, 1));
+                return static_cast<T*>(ud->*UserdataPointer::member());
+            }
+        }
+        return luabridge::Userdata::get<T>(L, 1, can_be_const);
+    }
+
+    template <class MemFn, MemFn fn,
+              class R = typename luabridge::FuncTraits<MemFn>::ReturnType>
+    struct Thunk
+    {
+        typedef typename luabridge::FuncTraits<MemFn>::ClassType T;
+        typedef typename luabridge::FuncTraits<MemFn>::Params Params;
+
+        static int f(lua_State* L)
+        {
+            T* t = self<T>(L, luabridge::FuncTraits<MemFn>::isConstMemberFunction);
+            luabridge::ArgList<Params, 2> args(L);
+            luabridge::Stack<R>::push(L, luabridge::FuncTraits<MemFn>::call(t, fn, args));
+            return 1;
+        }
+    };
+
+    template <class MemFn, MemFn fn>
+    struct Thunk<MemFn, fn, void>
+    {
+        typedef typename luabridge::FuncTraits<MemFn>::ClassType T;
+        typedef typename luabridge::FuncTraits<MemFn>::Params Params;
+
+        static int f(lua_State* L)
+        {
+            T* t = self<T>(L, luabridge::FuncTraits<MemFn>::isConstMemberFunction);
+            luabridge::ArgList<Params, 2> args(L);
+            luabridge::FuncTraits<MemFn>::call(t, fn, args);
+            return 0;
+        }
+    };
+};
+
+#define LUA_FAST_METHOD(L, cls, method) LuaFastCall::replace<decltype(&cls::method), &cls::method>(L, #method)
+
+#endif /* LUAFASTCALL_H_ */
@@ -0,0 +1,498 @@
+/*
+ * LuaJobSystem.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#include "LuaJobSystem.h"
+#include "LuaMain.h"
+#include "LuaMessage.h"
+#include "LuaCppInterface.h"
+#include "Utilities.h"
+#include "Trace.h"
+#include <cstdio>
+#include <algorithm>
+#ifdef _MSC_VER
+#include <ciso646>   // Visual Studio is not C++ standards complaint...
+#endif
+
+// a worker that's missed a wake up still looks for work this often
+static const Uint32 worker_idle_check_ms = 100;
+
+static SDL_SpinLock list_lock = 0;
+static std::vector<LuaJobSystem*>& job_system_list()
+{
+    static std::vector<LuaJobSystem*>* list = new std::vector<LuaJobSystem*>;     // never deleted, states can outlive statics
+    return *list;
+}
+
+static void LJS_abort(const char* s)
+{
+    Utilities::fatalError("LuaJobSystem failed to %s (SDL Error %s)",  s, SDL_GetError());
+}
+
+
+LuaJobSystem::LuaJobSystem(int worker_count, std::string init_file)
+: next_id(1)
+, next_worker(0)
+{
+    if(worker_count <= 0)
+    {
+        worker_count = SDL_GetCPUCount() - 1;
+        if(worker_count < 1) worker_count = 1;
+    }
+
+    SDL_AtomicSet(&stopping, 0);
+    SDL_AtomicSet(&pending, 0);
+    SDL_AtomicSet(&steals, 0);
+    work_available = SDL_CreateSemaphore(0); if(work_available == 0) { LJS_abort("create semaphore"); }
+    finished_mutex = SDL_CreateMutex(); if(finished_mutex == 0) { LJS_abort("create mutex"); }
+    finished_cond = SDL_CreateCond(); if(finished_cond == 0) { LJS_abort("create condition"); }
+
+    // states are set up here, on the creating thread, so any errors in the
+    // init file show up straight away
+    for(int i = 0; i < worker_count; i++)
+    {
+        Worker* w = new Worker;
+        w->system = this;
+        w->index = i;
+        w->lock = 0;
+        w->thread = 0;
+        w->lua = new LuaMain;
+        w->lua->library_init();
+        set_up_basic_ff_libraries(w->lua);
+        if(not init_file.empty())
+        {
+            load_main_file(w->lua, init_file.c_str());
+        }
+        workers.push_back(w);
+    }
+
+    for(size_t i = 0; i < workers.size(); i++)
+    {
+        workers[i]->thread = SDL_CreateThread(worker_thread, "LuaJob", workers[i]);
+        if(workers[i]->thread == 0) { LJS_abort("create worker thread"); }
+    }
+
+    lock_list();
+    job_system_list().push_back(this);
+    unlock_list();
+}
+
+LuaJobSystem::~LuaJobSystem()
+{
+    lock_list();
+    std::vector<LuaJobSystem*>& list = job_system_list();
+    list.erase(std::remove(list.begin(), list.end(), this), list.end());
+    unlock_list();
+
+    SDL_AtomicSet(&stopping, 1);
+    for(size_t i = 0; i < workers.size(); i++)
+    {
+        SDL_SemPost(work_available);
+    }
+    for(size_t i = 0; i < workers.size(); i++)
+    {
+        Worker* w = workers[i];
+        SDL_WaitThread(w->thread, 0);
+        for(size_t j = 0; j < w->jobs.size(); j++)
+        {
+            free_job(w->jobs[j]);
+        }
+        delete w->lua;
+        delete w;
+    }
+    for(size_t i = 0; i < finished.size(); i++)
+    {
+        free_job(finished[i]);
+    }
+    for(std::map<int, Job*>::iterator it = done.begin(); it != done.end(); ++it)
+    {
+        free_job(it->second);
+    }
+    SDL_DestroySemaphore(work_available);
+    SDL_DestroyMutex(finished_mutex);
+    SDL_DestroyCond(finished_cond);
+}
+
+void LuaJobSystem::free_job(Job* job)
+{
+    if(job->args) job->args->release();
+    if(job->results) job->results->release();
+    delete job;
+}
+
+
+//
+// Worker side
+//
+int LuaJobSystem::worker_thread(void* data)
+{
+    Worker* w = static_cast<Worker*>(data);
+    LuaJobSystem* system = w->system;
+    char name[32];
+    snprintf(name, sizeof(name), "LuaJob %d", w->index);
+    FF_TRACE_THREAD_NAME(name);
+
+    while(not SDL_AtomicGet(&system->stopping))
+    {
+        Job* job = system->take_job(*w);
+        if(job)
+        {
+            FF_TRACE_ZONE("job");
+            system->run_job(*w, job);
+        }
+        else
+        {
+            FF_TRACE_ZONE("job idle");
+            SDL_SemWaitTimeout(system->work_available, worker_idle_check_ms);
+        }
+    }
+    return 0;
+}
+
+LuaJobSystem::Job* LuaJobSystem::take_job(Worker& w)
+{
+    Job* job = 0;
+
+    // our own newest job first...
+    SDL_AtomicLock(&w.lock);
+    if(not w.jobs.empty())
+    {
+        job = w.jobs.back();
+        w.jobs.pop_back();
+    }
+    SDL_AtomicUnlock(&w.lock);
+    if(job) return job;
+
+    // ... otherwise steal someone else's oldest
+    size_t count = workers.size();
+    for(size_t i = 1; i < count and not job; i++)
+    {
+        Worker& victim = *workers[(w.index + i) % count];
+        SDL_AtomicLock(&victim.lock);
+        if(not victim.jobs.empty())
+        {
+            job = victim.jobs.front();
+            victim.jobs.pop_front();
+        }
+        SDL_AtomicUnlock(&victim.lock);
+    }
+    if(job) SDL_AtomicAdd(&steals, 1);
+    return job;
+}
+
+void LuaJobSystem::run_job(Worker& w, Job* job)
+{
+    lua_State* L = w.lua->get_internal_state();
+    int base = lua_gettop(L);
+
+    // module[function]
+    lua_getglobal(L, "require");
+    lua_pushlstring(L, job->module.c_str(), job->module.length());
+    int status = LuaMain::docall(L, 1, 1);
+    if(status == LUA_OK)
+    {
+        if(lua_istable(L, -1))
+        {
+            lua_getfield(L, -1, job->function.c_str());
+            lua_remove(L, -2);      // the module
+        }
+        else
+        {
+            lua_pop(L, 1);
+            lua_pushnil(L);
+        }
+        if(not lua_isfunction(L, -1))
+        {
+            lua_pop(L, 1);
+            lua_pushfstring(L, "job function %s.%s not found", job->module.c_str(), job->function.c_str());
+            status = LUA_ERRRUN;
+        }
+    }
+
+    if(status == LUA_OK)
+    {
+        // arguments
+        int nargs = 0;
+        if(job->args)
+        {
+            job->args->decode(L);
+            if(lua_istable(L, -1))
+            {
+                nargs = static_cast<int>(lua_rawlen(L, -1));
+                luaL_checkstack(L, nargs, "too many job arguments");
+                for(int i = 1; i <= nargs; i++)
+                {
+                    lua_rawgeti(L, base + 2, i);
+                }
+            }
+            lua_remove(L, base + 2);    // the args table
+        }
+        status = LuaMain::docall(L, nargs, LUA_MULTRET);
+    }
+
+    job->ok = (status == LUA_OK);
+    job->results = LuaMessage::acquire();
+    if(job->ok)
+    {
+        // pack the results into a table
+        int nresults = lua_gettop(L) - base;
+        lua_createtable(L, nresults, 1);
+        for(int i = 1; i <= nresults; i++)
+        {
+            lua_pushvalue(L, base + i);
+            lua_rawseti(L, -2, i);
+        }
+        lua_pushinteger(L, nresults);
+        lua_setfield(L, -2, "n");
+        if(not job->results->encode(L, -1))
+        {
+            job->ok = false;
+            job->error = "job results nested too deeply";
+        }
+    }
+    else
+    {
+        const char* msg = lua_tostring(L, -1);
+        job->error = msg ? msg : "(no error message)";
+    }
+    lua_settop(L, base);
+
+    job_finished(job);
+}
+
+void LuaJobSystem::job_finished(Job* job)
+{
+    if(SDL_LockMutex(finished_mutex) != 0) { LJS_abort("lock mutex in job_finished"); }
+    finished.push_back(job);
+    if(SDL_CondBroadcast(finished_cond) != 0) { LJS_abort("signal"); }
+    if(SDL_UnlockMutex(finished_mutex) != 0) { LJS_abort("unlock mutex in job_finished"); }
+    SDL_AtomicAdd(&pending, -1);
+}
+
+
+//
+// Owner side
+//
+int LuaJobSystem::submit(lua_State* L)
+{
+    const char* module = luaL_checkstring(L, 2);
+    const char* function = luaL_checkstring(L, 3);
+
+    Job* job = new Job;
+    job->id = next_id++;
+    job->module = module;
+    job->function = function;
+    job->args = 0;
+    job->results = 0;
+    job->ok = false;
+
+    if(lua_istable(L, 4))
+    {
+        job->args = LuaMessage::acquire();
+        if(not job->args->encode(L, 4))
+        {
+            free_job(job);
+            return luaL_error(L, "LuaJobSystem: job arguments nested too deeply");
+        }
+    }
+    if(lua_isfunction(L, 5))
+    {
+        lua_pushvalue(L, 5);
+        luabridge::LuaRef callback = luabridge::LuaRef::fromStack(L, lua_gettop(L));
+        lua_pop(L, 1);
+        // poll() might be called from another coroutine after this one has gone
+        callback.force_to_main_state();
+        callbacks.insert(std::make_pair(job->id, callback));
+    }
+
+    outstanding.insert(job->id);
+    SDL_AtomicAdd(&pending, 1);
+    Worker& w = *workers[next_worker++ % workers.size()];
+    SDL_AtomicLock(&w.lock);
+    w.jobs.push_back(job);
+    SDL_AtomicUnlock(&w.lock);
+    SDL_SemPost(work_available);
+
+    lua_pushinteger(L, job->id);
+    return 1;
+}
+
+void LuaJobSystem::collect(lua_State* L, bool run_callbacks)
+{
+    std::vector<Job*> newly_finished;
+    if(SDL_LockMutex(finished_mutex) != 0) { LJS_abort("lock mutex in collect"); }
+    newly_finished.swap(finished);
+    if(SDL_UnlockMutex(finished_mutex) != 0) { LJS_abort("unlock mutex in collect"); }
+
+    for(size_t i = 0; i < newly_finished.size(); i++)
+    {
+        done.insert(std::make_pair(newly_finished[i]->id, newly_finished[i]));
+    }
+
+    if(not run_callbacks)
+    {
+        return;
+    }
+
+    // copy the ids, callbacks might submit more jobs
+    std::vector<int> ready;
+    for(std::map<int, luabridge::LuaRef>::iterator it = callbacks.begin(); it != callbacks.end(); ++it)
+    {
+        if(done.count(it->first)) ready.push_back(it->first);
+    }
+    for(size_t i = 0; i < ready.size(); i++)
+    {
+        std::map<int, luabridge::LuaRef>::iterator cb = callbacks.find(ready[i]);
+        std::map<int, Job*>::iterator job = done.find(ready[i]);
+        cb->second.push(L);
+        int nargs = push_results(L, job->second);
+        free_job(job->second);
+        done.erase(job);
+        callbacks.erase(cb);
+        outstanding.erase(ready[i]);
+        if(LuaMain::docall(L, nargs, 0) != LUA_OK)
+        {
+            Utilities::debugMessage("LuaJobSystem callback failed: %s", lua_tostring(L, -1));
+            lua_pop(L, 1);
+        }
+    }
+}
+
+// ok, results... or false, error
+int LuaJobSystem::push_results(lua_State* L, Job* job)
+{
+    lua_pushboolean(L, job->ok);
+    if(not job->ok)
+    {
+        lua_pushlstring(L, job->error.c_str(), job->error.length());
+        return 2;
+    }
+    job->results->decode(L);
+    lua_getfield(L, -1, "n");
+    int n = static_cast<int>(lua_tointeger(L, -1));
+    lua_pop(L, 1);
+    luaL_checkstack(L, n, "too many job results");
+    int table = lua_gettop(L);
+    for(int i = 1; i <= n; i++)
+    {
+        lua_rawgeti(L, table, i);
+    }
+    lua_remove(L, table);
+    return n + 1;
+}
+
+int LuaJobSystem::poll(lua_State* L)
+{
+    size_t before = callbacks.size();
+    collect(L, true);
+    lua_pushinteger(L, static_cast<lua_Integer>(before - callbacks.size()));
+    return 1;
+}
+
+int LuaJobSystem::result(lua_State* L)
+{
+    int id = luaL_checkint(L, 2);
+    collect(L, false);
+    std::map<int, Job*>::iterator job = done.find(id);
+    if(job == done.end() or callbacks.count(id))
+    {
+        lua_pushnil(L);
+        return 1;
+    }
+    int n = push_results(L, job->second);
+    free_job(job->second);
+    done.erase(job);
+    outstanding.erase(id);
+    return n;
+}
+
+int LuaJobSystem::wait(lua_State* L)
+{
+    int id = luaL_checkint(L, 2);
+    Uint32 ms = lua_isnoneornil(L, 3) ? SDL_MUTEX_MAXWAIT : static_cast<Uint32>(luaL_checknumber(L, 3));
+    if(id <= 0 or id >= next_id)
+    {
+        return luaL_error(L, "LuaJobSystem: no such job %d", id);
+    }
+    if(not outstanding.count(id))
+    {
+        // it would never turn up in done again, so we'd wait forever
+        return luaL_error(L, "LuaJobSystem: job %d has already been collected", id);
+    }
+    if(callbacks.count(id))
+    {
+        return luaL_error(L, "LuaJobSystem: job %d has a callback, use poll()", id);
+    }
+
+    Uint32 start = SDL_GetTicks();
+    for(;;)
+    {
+        collect(L, false);
+        if(done.count(id))
+        {
+            lua_settop(L, 2);
+            return result(L);
+        }
+
+        Uint32 remaining = ms;
+        if(ms != SDL_MUTEX_MAXWAIT)
+        {
+            Uint32 elapsed = SDL_GetTicks() - start;
+            if(elapsed >= ms)
+            {
+                lua_pushnil(L);
+                return 1;
+            }
+            remaining = ms - elapsed;
+        }
+        if(SDL_LockMutex(finished_mutex) != 0) { LJS_abort("lock mutex in wait"); }
+        if(finished.empty())
+        {
+            FF_TRACE_ZONE("job wait");
+            SDL_CondWaitTimeout(finished_cond, finished_mutex, remaining);
+        }
+        if(SDL_UnlockMutex(finished_mutex) != 0) { LJS_abort("unlock mutex in wait"); }
+    }
+}
+
+void LuaJobSystem::lock_list()
+{
+    SDL_AtomicLock(&list_lock);
+}
+
+void LuaJobSystem::unlock_list()
+{
+    SDL_AtomicUnlock(&list_lock);
+}
+
+const std::vector<LuaJobSystem*>& LuaJobSystem::get_list()
+{
+    return job_system_list();
+}
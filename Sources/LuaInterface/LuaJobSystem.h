@@ -0,0 +1,143 @@
+/*
+ * LuaJobSystem.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#ifndef LUAJOBSYSTEM_H_
+#define LUAJOBSYSTEM_H_
+
+#include "SDL.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <set>
+#include "lua.h"
+#include "lauxlib.h"
+#include "LuaBridge.h"
+
+class LuaMain;
+class LuaMessage;
+
+// A fixed pool of worker threads, each with its own ready-made Lua state, that
+// run Lua functions in parallel.
+//
+// Jobs are named by module and function - the worker does require(module) and
+// calls module[function](args...). Arguments and results are copied between
+// states as LuaMessages, so they follow the same rules as LuaStateQueue.
+//
+// Each worker has its own deque of jobs. New jobs are dealt out to the workers
+// in turn; a worker takes its newest job first, and when it runs out it steals
+// the oldest job from another worker.
+//
+// Results come back to the state that owns the LuaJobSystem. Either poll() it
+// regularly to run completion callbacks, or use result()/wait() on the job id.
+class LuaJobSystem {
+public:
+    // workers=0 means one per CPU core, less one for the main thread.
+    // init_file (if not empty) is run in each worker state before any jobs.
+    LuaJobSystem(int workers, std::string init_file);
+    ~LuaJobSystem();
+
+    // submit(module, function, [args_table], [callback]) returns the job id
+    // callback(ok, results...) is called from poll(), ok is false on error and
+    // the next value is the error message.
+    int submit(lua_State* L);
+    // runs callbacks for finished jobs, returns how many finished
+    int poll(lua_State* L);
+    // result(id) returns nil if not finished, otherwise ok, results...
+    int result(lua_State* L);
+    // wait(id, [timeout_ms]) like result() but waits for it to finish. It's an
+    // error to wait for a job whose results have already been collected.
+    int wait(lua_State* L);
+
+    int get_worker_count() { return static_cast<int>(workers.size()); }
+    int get_pending() { return SDL_AtomicGet(&pending); }
+    int get_steal_count() { return SDL_AtomicGet(&steals); }
+
+    // every job system currently alive, for the metrics. Hold the lock while
+    // looking at the list.
+    static void lock_list();
+    static void unlock_list();
+    static const std::vector<LuaJobSystem*>& get_list();
+
+private:
+    // lets not have these copy constructed or assigned
+    LuaJobSystem(const LuaJobSystem&);
+    LuaJobSystem& operator=(const LuaJobSystem&);
+
+    struct Job {
+        int id;
+        std::string module;
+        std::string function;
+        LuaMessage* args;
+        LuaMessage* results;
+        bool ok;
+        std::string error;
+    };
+
+    struct Worker {
+        LuaJobSystem* system;
+        int index;
+        LuaMain* lua;
+        SDL_Thread* thread;
+        SDL_SpinLock lock;
+        std::deque<Job*> jobs;
+    };
+
+    static int worker_thread(void* data);
+    Job* take_job(Worker& w);
+    void run_job(Worker& w, Job* job);
+    void job_finished(Job* job);
+
+    // move finished jobs from the workers to our side
+    void collect(lua_State* L, bool run_callbacks);
+    int push_results(lua_State* L, Job* job);
+    void free_job(Job* job);
+
+    std::vector<Worker*> workers;
+    SDL_sem* work_available;
+    SDL_atomic_t stopping;
+    SDL_atomic_t pending;
+    SDL_atomic_t steals;
+    int next_id;
+    unsigned int next_worker;
+
+    // finished jobs, from the workers
+    SDL_mutex* finished_mutex;
+    SDL_cond* finished_cond;
+    std::vector<Job*> finished;
+
+    // only touched by the owning state
+    std::map<int, Job*> done;
+    std::map<int, luabridge::LuaRef> callbacks;
+    std::set<int> outstanding;      // submitted, results not handed back yet
+};
+
+#endif /* LUAJOBSYSTEM_H_ */
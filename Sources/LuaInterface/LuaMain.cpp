@@ -37,6 +37,8 @@
 #include "lauxlib.h"
 #include "lualib.h"
 #include "Utilities.h"
+#include "LuaBytecodeCache.h"
+#include "VirtualFileSystem.h"
 #include <iostream>
 #include "luasocket.h"
 #include "mime.h"
@@ -82,7 +84,8 @@ void stackDump (lua_State *L)
 LuaMain::LuaMain()
 : L(0)
 {
-	L = luaL_newstate();  /* create state */
+	// our allocator rather than luaL_newstate's realloc, for pooling and memory counts
+	L = lua_newstate(&LuaAllocator::alloc, &allocator);  /* create state */
 	if (L == NULL) {
 		// Should this be a fatal error? or what?
 		Utilities::fatalError("Forlorn Fox cannot create state: not enough memory");
@@ -90,6 +93,9 @@ LuaMain::LuaMain()
 		//return EXIT_FAILURE;
 	}
 
+	lua_atpanic(L, &panic);
+	profiler.attach(L);		// off until LuaProfiler.start()
+
 	//effectively option '-E'?
 	lua_pushboolean(L, 1);  /* signal for libraries to ignore env. vars. */
 	lua_setfield(L, LUA_REGISTRYINDEX, "LUA_NOENV");
@@ -101,6 +107,13 @@ LuaMain::LuaMain()
 
 }
 
+// same as the one luaL_newstate sets
+int LuaMain::panic(lua_State *L)
+{
+	Utilities::fatalError("PANIC: unprotected error in call to Lua API (%s)", lua_tostring(L, -1));
+	return 0;  /* return to Lua to abort */
+}
+
 LuaMain::~LuaMain()
 {
 	delete LuaCLI;
@@ -172,6 +185,12 @@ int LuaMain::set_up_standard_libraries(lua_State *L)
 	luaL_openlibs(L);  /* open libraries */
 	lua_gc(L, LUA_GCRESTART, 0);
 
+	// require() gets Lua modules through the bytecode cache as well
+	LuaBytecodeCache::install_searcher(L);
+
+	// scripts writing save files keep the file index up to date
+	VirtualFileSystem::wrap_lua_io(L);
+
 	// we don't call the init file (as per the normal interpreter)
 
 	return 0; // no Lua results
@@ -215,7 +234,9 @@ int LuaMain::docall (lua_State *L, int narg, int nres) {
 	lua_insert(L, base);  /* put it under chunk and args */
 	//	globalL = L;  /* to be available to 'laction' */
 	//	signal(SIGINT, laction);
+	LuaProfiler::enter(L);
 	status = lua_pcall(L, narg, nres, base);
+	LuaProfiler::leave(L);
 	//	signal(SIGINT, SIG_DFL);
 	//stackDump(L);
 	lua_remove(L, base);  /* remove traceback function */
@@ -275,7 +296,8 @@ int LuaMain::run_lua_file(const char* filename, bool print_errors, bool ignore_f
 	// It returns false if there are no errors or true in case of errors.
 	//return luaL_dofile(L, filename);
 
-	int err = luaL_loadfile(L, filename);
+	// compiled chunks come from the cache when the source hasn't changed
+	int err = LuaBytecodeCache::load_file(L, filename);
 	if(err == LUA_OK)
 	{
 		//Utilities::debugMessage("Loaded lua file okay %s", filename);
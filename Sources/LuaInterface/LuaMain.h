@@ -43,6 +43,8 @@
 #include <string>
 #include "StdinThread.h"
 #include "LuaCommandLineInterpreter.h"
+#include "LuaAllocator.h"
+#include "LuaProfiler.h"
 
 class GameApplication;
 
@@ -75,6 +77,9 @@ public:
 	operator lua_State*() { return L; }
     lua_State* get_internal_state() { return L; }
     LuaCommandLineInterpreter* get_CLI();
+    LuaAllocator& get_allocator() { return allocator; }
+    void set_memory_limit(size_t bytes) { allocator.set_limit(bytes); }     // 0 = no limit
+    LuaProfiler& get_profiler() { return profiler; }
     void fatal_if_lua_errror(int status, std::string additional_text);
 private:
 	// disable copy and assignment constructors for the moment
@@ -90,9 +95,12 @@ private:
 	void print_decode_lua_error(int error_code, std::string doing_what);
 
 	static int traceback(lua_State *L);
+	static int panic(lua_State *L);
 
 	// data
+	LuaAllocator allocator;		// must outlive L
 	lua_State *L;
+	LuaProfiler profiler;
 
 	// error stuff
 	std::string last_error_str;
@@ -0,0 +1,279 @@
+/*
+ * LuaMessage.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#include "LuaMessage.h"
+#include "lauxlib.h"
+#include "Utilities.h"
+#include <cstring>
+#ifdef _MSC_VER
+#include <ciso646>   // Visual Studio is not C++ standards complaint...
+#endif
+
+// Encoding, one tag byte per value:
+//   'n'              nil (or something we can't send)
+//   'f' / 't'        false / true
+//   'd' <double>     number
+//   's' <u32> bytes  string
+//   '{' (key value)* '}'  table
+//
+// Numbers and lengths are in native byte order - messages never leave the process.
+
+namespace {
+
+	const int max_nesting = 64;
+
+	// don't keep hold of huge buffers, or too many of them
+	const size_t max_pooled_buffer = 64 * 1024;
+	const size_t max_pooled_messages = 1024;
+
+	SDL_SpinLock pool_lock = 0;
+	std::vector<LuaMessage*>* pool_free = 0;
+	SDL_atomic_t pool_allocated;
+
+}
+
+LuaMessage::LuaMessage()
+{
+	SDL_AtomicSet(&refcount, 0);
+}
+
+LuaMessage::~LuaMessage()
+{
+}
+
+LuaMessage* LuaMessage::acquire()
+{
+	LuaMessage* m = 0;
+	SDL_AtomicLock(&pool_lock);
+	if(pool_free and not pool_free->empty())
+	{
+		m = pool_free->back();
+		pool_free->pop_back();
+	}
+	SDL_AtomicUnlock(&pool_lock);
+
+	if(not m)
+	{
+		m = new LuaMessage;
+		SDL_AtomicAdd(&pool_allocated, 1);
+	}
+	m->data.clear();		// keeps the capacity
+	SDL_AtomicSet(&m->refcount, 1);
+	return m;
+}
+
+void LuaMessage::add_ref()
+{
+	SDL_AtomicIncRef(&refcount);
+}
+
+void LuaMessage::release()
+{
+	if(not SDL_AtomicDecRef(&refcount))
+	{
+		return;
+	}
+
+	if(data.capacity() <= max_pooled_buffer)
+	{
+		SDL_AtomicLock(&pool_lock);
+		if(not pool_free)
+		{
+			pool_free = new std::vector<LuaMessage*>;	// never freed, messages can be released during shutdown
+		}
+		if(pool_free->size() < max_pooled_messages)
+		{
+			pool_free->push_back(this);
+			SDL_AtomicUnlock(&pool_lock);
+			return;
+		}
+		SDL_AtomicUnlock(&pool_lock);
+	}
+	SDL_AtomicAdd(&pool_allocated, -1);
+	delete this;
+}
+
+int LuaMessage::get_pool_free()
+{
+	SDL_AtomicLock(&pool_lock);
+	int n = pool_free ? static_cast<int>(pool_free->size()) : 0;
+	SDL_AtomicUnlock(&pool_lock);
+	return n;
+}
+
+int LuaMessage::get_pool_allocated()
+{
+	return SDL_AtomicGet(&pool_allocated);
+}
+
+bool LuaMessage::encode(lua_State* L, int index)
+{
+	data.clear();
+	index = lua_absindex(L, index);
+	if(not encode_value(L, index, 0))
+	{
+		data.clear();
+		return false;
+	}
+	return true;
+}
+
+bool LuaMessage::encode_value(lua_State* L, int index, int depth)
+{
+	switch(lua_type(L, index))
+	{
+		case LUA_TBOOLEAN:
+			data.push_back(lua_toboolean(L, index) ? 't' : 'f');
+			break;
+		case LUA_TNUMBER:
+		{
+			lua_Number n = lua_tonumber(L, index);
+			size_t at = data.size();
+			data.resize(at + 1 + sizeof(n));
+			data[at] = 'd';
+			std::memcpy(&data[at+1], &n, sizeof(n));
+			break;
+		}
+		case LUA_TSTRING:
+		{
+			size_t len;
+			const char* s = lua_tolstring(L, index, &len);
+			Uint32 len32 = static_cast<Uint32>(len);
+			size_t at = data.size();
+			data.resize(at + 1 + sizeof(len32) + len);
+			data[at] = 's';
+			std::memcpy(&data[at+1], &len32, sizeof(len32));
+			if(len) std::memcpy(&data[at+1+sizeof(len32)], s, len);
+			break;
+		}
+		case LUA_TTABLE:
+		{
+			if(depth >= max_nesting)
+			{
+				return false;
+			}
+			lua_checkstack(L, 3);
+			data.push_back('{');
+			lua_pushnil(L);  /* first key */
+			while(lua_next(L, index) != 0)
+			{
+				// only allow specific key types
+				int ktype = lua_type(L, -2);
+				if(ktype == LUA_TBOOLEAN or ktype == LUA_TNUMBER or ktype == LUA_TSTRING)
+				{
+					// encode the key from a copy, lua_tolstring on a number key would confuse lua_next
+					lua_pushvalue(L, -2);
+					encode_value(L, lua_gettop(L), depth+1);
+					lua_pop(L, 1);
+					if(not encode_value(L, lua_gettop(L), depth+1))
+					{
+						lua_pop(L, 2);
+						return false;
+					}
+				}
+				/* removes 'value'; keeps 'key' for next iteration */
+				lua_pop(L, 1);
+			}
+			data.push_back('}');
+			break;
+		}
+		default:
+			// nil, or something we don't know how to send
+			data.push_back('n');
+			break;
+	}
+	return true;
+}
+
+int LuaMessage::decode(lua_State* L) const
+{
+	if(data.empty())
+	{
+		lua_pushnil(L);
+		return 1;
+	}
+	const unsigned char* end = decode_value(L, &data[0]);
+	if(end != &data[0] + data.size())
+	{
+		Utilities::fatalError("LuaMessage decode didn't use the whole message");
+	}
+	return 1;
+}
+
+const unsigned char* LuaMessage::decode_value(lua_State* L, const unsigned char* p) const
+{
+	switch(*p++)
+	{
+		case 'n':
+			lua_pushnil(L);
+			break;
+		case 'f':
+			lua_pushboolean(L, 0);
+			break;
+		case 't':
+			lua_pushboolean(L, 1);
+			break;
+		case 'd':
+		{
+			lua_Number n;
+			std::memcpy(&n, p, sizeof(n));
+			p += sizeof(n);
+			lua_pushnumber(L, n);
+			break;
+		}
+		case 's':
+		{
+			Uint32 len;
+			std::memcpy(&len, p, sizeof(len));
+			p += sizeof(len);
+			lua_pushlstring(L, reinterpret_cast<const char*>(p), len);
+			p += len;
+			break;
+		}
+		case '{':
+		{
+			lua_checkstack(L, 3);
+			lua_newtable(L);
+			while(*p != '}')
+			{
+				p = decode_value(L, p);		// key
+				p = decode_value(L, p);		// value
+				lua_rawset(L, -3);
+			}
+			p++;
+			break;
+		}
+		default:
+			Utilities::fatalError("Unknown type in LuaMessage::decode()");
+			break;
+	}
+	return p;
+}
@@ -0,0 +1,85 @@
+/*
+ * LuaMessage.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#ifndef LUAMESSAGE_H_
+#define LUAMESSAGE_H_
+
+#include "SDL.h"
+#include <vector>
+#include "lua.h"
+
+// A Lua value (nil, boolean, number, string or table of those) serialized into
+// one contiguous buffer, so it can be passed between Lua states on different
+// threads.
+//
+// Messages come from a recycled pool, so in steady state sending doesn't touch
+// the heap at all. They are reference counted - acquire() gives you one reference,
+// add_ref() adds more (for sending the same message to several places) and the
+// last release() returns it to the pool. Once shared, a message must not be
+// changed.
+//
+// Table keys can be booleans, numbers or strings. Functions, userdata and
+// threads are sent as nil, as with the previous LuaStateQueue implementation.
+class LuaMessage
+{
+public:
+	static LuaMessage* acquire();
+	void add_ref();
+	void release();
+
+	// serialize the value at index. Returns false if the value is nested too
+	// deeply (probably a table that contains itself), in which case the message
+	// is empty.
+	bool encode(lua_State* L, int index);
+	// push the value onto the stack. Returns the number of values pushed (1).
+	int decode(lua_State* L) const;
+
+	size_t size() const { return data.size(); }
+
+	// pool statistics
+	static int get_pool_free();
+	static int get_pool_allocated();
+
+private:
+	LuaMessage();
+	~LuaMessage();
+	// lets not have these copy constructed or assigned
+	LuaMessage(const LuaMessage&);
+	LuaMessage& operator=(const LuaMessage&);
+
+	bool encode_value(lua_State* L, int index, int depth);
+	const unsigned char* decode_value(lua_State* L, const unsigned char* p) const;
+
+	std::vector<unsigned char> data;
+	SDL_atomic_t refcount;
+};
+
+#endif /* LUAMESSAGE_H_ */
@@ -0,0 +1,462 @@
+/*
+ * LuaProfiler.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#include "LuaProfiler.h"
+#include "LuaAllocator.h"
+#include "SaveDataPath.h"
+#include "VirtualFileSystem.h"
+#include "Utilities.h"
+#include "lauxlib.h"
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#ifdef _MSC_VER
+#include <ciso646>   // Visual Studio is not C++ standards complaint...
+#endif
+
+namespace {
+
+    char registry_key;              // address is the key for the profiler in the registry
+    const int max_stack_depth = 128;
+
+    // collapsed stack format uses ';' between frames and a space before the count
+    void clean_name(std::string& s)
+    {
+        std::replace(s.begin(), s.end(), ';', ':');
+        std::replace(s.begin(), s.end(), '\n', ' ');
+    }
+
+    double ticks_to_ms(Uint64 ticks)
+    {
+        return double(ticks) * 1000.0 / double(SDL_GetPerformanceFrequency());
+    }
+}
+
+LuaProfiler::LuaProfiler()
+: main_state(0)
+, running(false)
+, hook_instructions(200)
+, interval_ticks(0)
+, call_depth(0)
+, clock_running(false)
+, last_hook(0)
+, pending(0)
+, outside_ticks(0)
+, dropped_samples(0)
+{
+    current_stack.reserve(max_stack_depth);
+}
+
+LuaProfiler::~LuaProfiler()
+{
+}
+
+size_t LuaProfiler::FunctionKeyHash::operator()(const FunctionKey& k) const
+{
+    size_t h = reinterpret_cast<size_t>(k.source);
+    h = h * 31 + reinterpret_cast<size_t>(k.name);
+    h = h * 31 + static_cast<size_t>(k.line);
+    return h;
+}
+
+size_t LuaProfiler::StackHash::operator()(const std::vector<int>& s) const
+{
+    // FNV-1a over the ids
+    size_t h = 2166136261u;
+    for(size_t i = 0; i < s.size(); i++)
+    {
+        h = (h ^ static_cast<size_t>(s[i])) * 16777619u;
+    }
+    return h;
+}
+
+void LuaProfiler::attach(lua_State* L)
+{
+    main_state = L;
+    lua_pushlightuserdata(L, this);
+    lua_rawsetp(L, LUA_REGISTRYINDEX, &registry_key);
+}
+
+LuaProfiler* LuaProfiler::of(lua_State* L)
+{
+    lua_rawgetp(L, LUA_REGISTRYINDEX, &registry_key);
+    LuaProfiler* p = static_cast<LuaProfiler*>(lua_touserdata(L, -1));
+    lua_pop(L, 1);
+    return p;
+}
+
+void LuaProfiler::start(double interval_ms, int instructions)
+{
+    if(main_state == 0) return;
+    if(interval_ms < 0.05) interval_ms = 0.05;
+    if(instructions < 1) instructions = 1;
+
+    interval_ticks = static_cast<Uint64>(interval_ms * SDL_GetPerformanceFrequency() / 1000.0);
+    hook_instructions = instructions;
+    last_hook = SDL_GetPerformanceCounter();
+    clock_running = call_depth > 0;     // if started from Lua, we're in it
+    pending = 0;
+    running = true;
+    lua_sethook(main_state, &hook, LUA_MASKCOUNT, hook_instructions);
+}
+
+void LuaProfiler::stop()
+{
+    if(not running) return;
+    running = false;
+    lua_sethook(main_state, 0, 0, 0);   // coroutines remove their own next time they get called
+}
+
+void LuaProfiler::reset()
+{
+    stacks.clear();
+    function_ids.clear();
+    name_ids.clear();
+    function_names.clear();
+    outside_ticks = 0;
+    dropped_samples = 0;
+    pending = 0;
+}
+
+void LuaProfiler::enter(lua_State* L)
+{
+    LuaProfiler* p = of(L);
+    if(p == 0 or p->call_depth++ > 0) return;
+    if(p->running)
+    {
+        Uint64 now = SDL_GetPerformanceCounter();
+        p->outside_ticks += now - p->last_hook;
+        p->last_hook = now;
+        p->pending = 0;
+    }
+    p->clock_running = true;
+}
+
+void LuaProfiler::leave(lua_State* L)
+{
+    LuaProfiler* p = of(L);
+    if(p == 0 or p->call_depth == 0 or --p->call_depth > 0) return;
+    if(p->running)
+    {
+        p->last_hook = SDL_GetPerformanceCounter();
+        p->pending = 0;         // can't walk a stack that's gone
+    }
+    p->clock_running = false;
+}
+
+void LuaProfiler::hook(lua_State* L, lua_Debug* ar)
+{
+    (void)ar;
+    LuaProfiler* p = of(L);
+    if(p == 0 or not p->running)
+    {
+        lua_sethook(L, 0, 0, 0);
+        return;
+    }
+
+    Uint64 now = SDL_GetPerformanceCounter();
+    Uint64 gap = now - p->last_hook;
+    p->last_hook = now;
+    if(not p->clock_running)
+    {
+        // Lua was entered without enter(), so we don't know when
+        p->outside_ticks += gap;
+        p->clock_running = true;
+        return;
+    }
+
+    p->pending += gap;
+    if(p->pending >= p->interval_ticks)
+    {
+        p->sample(L, p->pending);
+        p->pending = 0;
+    }
+}
+
+void LuaProfiler::sample(lua_State* L, Uint64 weight)
+{
+    current_stack.clear();
+    lua_Debug frame;
+    for(int level = 0; level < max_stack_depth and lua_getstack(L, level, &frame); level++)
+    {
+        current_stack.push_back(function_id(L, frame));
+    }
+    if(current_stack.empty())
+    {
+        dropped_samples++;
+        return;
+    }
+    std::reverse(current_stack.begin(), current_stack.end());     // root first
+
+    StackTimes& t = stacks[current_stack];
+    t.ticks += weight;
+    t.samples++;
+}
+
+int LuaProfiler::function_id(lua_State* L, lua_Debug& ar)
+{
+    lua_getinfo(L, "Sn", &ar);
+
+    // These pointers are only valid while the strings are alive. A string
+    // that is collected and replaced at the same address would get the old
+    // name - a small risk for a profile.
+    FunctionKey key = { ar.source, ar.name, ar.linedefined };
+    std::unordered_map<FunctionKey, int, FunctionKeyHash>::const_iterator it = function_ids.find(key);
+    if(it != function_ids.end())
+    {
+        return it->second;
+    }
+
+    char buffer[LUA_IDSIZE + 128];
+    if(*ar.what == 'C')
+    {
+        snprintf(buffer, sizeof(buffer), "[C] %s", ar.name ? ar.name : "?");
+    }
+    else if(*ar.what == 'm')
+    {
+        snprintf(buffer, sizeof(buffer), "main chunk (%s)", ar.short_src);
+    }
+    else
+    {
+        snprintf(buffer, sizeof(buffer), "%s (%s:%d)", ar.name ? ar.name : "?", ar.short_src, ar.linedefined);
+    }
+    std::string name = buffer;
+    clean_name(name);
+
+    int id;
+    std::unordered_map<std::string, int>::const_iterator n = name_ids.find(name);
+    if(n != name_ids.end())
+    {
+        id = n->second;
+    }
+    else
+    {
+        id = static_cast<int>(function_names.size());
+        function_names.push_back(name);
+        name_ids[name] = id;
+    }
+    function_ids[key] = id;
+    return id;
+}
+
+std::string LuaProfiler::collapsed(bool sample_counts)
+{
+    std::vector<std::string> lines;
+    lines.reserve(stacks.size());
+    for(std::unordered_map<std::vector<int>, StackTimes, StackHash>::const_iterator it = stacks.begin(); it != stacks.end(); ++it)
+    {
+        std::string line;
+        for(size_t i = 0; i < it->first.size(); i++)
+        {
+            if(i) line += ';';
+            line += function_names[it->first[i]];
+        }
+        char count[32];
+        if(sample_counts)
+        {
+            snprintf(count, sizeof(count), " %u\n", it->second.samples);
+        }
+        else
+        {
+            snprintf(count, sizeof(count), " %.0f\n", ticks_to_ms(it->second.ticks) * 1000.0);
+        }
+        line += count;
+        lines.push_back(line);
+    }
+    std::sort(lines.begin(), lines.end());
+
+    std::string result;
+    for(size_t i = 0; i < lines.size(); i++)
+    {
+        result += lines[i];
+    }
+    return result;
+}
+
+void LuaProfiler::function_times(std::vector<FunctionTimes>& result)
+{
+    size_t n = function_names.size();
+    std::vector<Uint64> self_ticks(n, 0), total_ticks(n, 0);
+    std::vector<Uint32> samples(n, 0);
+    std::vector<size_t> seen(n, 0);        // stack number we last counted total for (recursion)
+
+    size_t stack_number = 0;
+    for(std::unordered_map<std::vector<int>, StackTimes, StackHash>::const_iterator it = stacks.begin(); it != stacks.end(); ++it)
+    {
+        stack_number++;
+        const std::vector<int>& s = it->first;
+        for(size_t i = 0; i < s.size(); i++)
+        {
+            if(seen[s[i]] != stack_number)
+            {
+                seen[s[i]] = stack_number;
+                total_ticks[s[i]] += it->second.ticks;
+                samples[s[i]] += it->second.samples;
+            }
+        }
+        self_ticks[s.back()] += it->second.ticks;
+    }
+
+    result.clear();
+    for(size_t i = 0; i < n; i++)
+    {
+        if(total_ticks[i] == 0 and samples[i] == 0) continue;
+        FunctionTimes f;
+        f.name = function_names[i];
+        f.self_ms = ticks_to_ms(self_ticks[i]);
+        f.total_ms = ticks_to_ms(total_ticks[i]);
+        f.samples = samples[i];
+        result.push_back(f);
+    }
+    struct most_self {
+        bool operator()(const FunctionTimes& a, const FunctionTimes& b) const
+        {
+            return a.self_ms > b.self_ms or (a.self_ms == b.self_ms and a.total_ms > b.total_ms);
+        }
+    };
+    std::sort(result.begin(), result.end(), most_self());
+}
+
+
+//
+// Lua interface
+//
+static LuaProfiler* check_profiler(lua_State* L)
+{
+    LuaProfiler* p = LuaProfiler::of(L);
+    if(p == 0)
+    {
+        luaL_error(L, "LuaProfiler - this Lua state doesn't have a profiler");
+    }
+    return p;
+}
+
+int LuaProfiler::lua_start(lua_State* L)
+{
+    LuaProfiler* p = check_profiler(L);
+    p->start(luaL_optnumber(L, 1, 1), static_cast<int>(luaL_optinteger(L, 2, 200)));
+    if(L != p->main_state)
+    {
+        // started from a coroutine, include it
+        lua_sethook(L, &hook, LUA_MASKCOUNT, p->hook_instructions);
+    }
+    return 0;
+}
+
+int LuaProfiler::lua_stop(lua_State* L)
+{
+    check_profiler(L)->stop();
+    return 0;
+}
+
+int LuaProfiler::lua_reset(lua_State* L)
+{
+    check_profiler(L)->reset();
+    return 0;
+}
+
+int LuaProfiler::lua_running(lua_State* L)
+{
+    lua_pushboolean(L, check_profiler(L)->is_running());
+    return 1;
+}
+
+int LuaProfiler::lua_report(lua_State* L)
+{
+    std::vector<FunctionTimes> times;
+    check_profiler(L)->function_times(times);
+    lua_createtable(L, static_cast<int>(times.size()), 0);
+    for(size_t i = 0; i < times.size(); i++)
+    {
+        lua_createtable(L, 0, 4);
+        lua_pushstring(L, times[i].name.c_str()); lua_setfield(L, -2, "name");
+        lua_pushnumber(L, times[i].self_ms); lua_setfield(L, -2, "self_ms");
+        lua_pushnumber(L, times[i].total_ms); lua_setfield(L, -2, "total_ms");
+        lua_pushnumber(L, times[i].samples); lua_setfield(L, -2, "samples");
+        lua_rawseti(L, -2, static_cast<int>(i + 1));
+    }
+    return 1;
+}
+
+int LuaProfiler::lua_print(lua_State* L)
+{
+    LuaProfiler* p = check_profiler(L);
+    size_t lines = static_cast<size_t>(luaL_optinteger(L, 1, 20));
+    std::vector<FunctionTimes> times;
+    p->function_times(times);
+
+    Uint64 in_lua = 0;
+    Uint32 samples = 0;
+    for(std::unordered_map<std::vector<int>, StackTimes, StackHash>::const_iterator it = p->stacks.begin(); it != p->stacks.end(); ++it)
+    {
+        in_lua += it->second.ticks;
+        samples += it->second.samples;
+    }
+    LuaAllocator* a = LuaAllocator::of(L);
+    Utilities::debugMessage("Lua profile %s: %u samples, %.1fms in Lua, %.1fms outside",
+                            a ? a->get_name().c_str() : "", samples, ticks_to_ms(in_lua), ticks_to_ms(p->outside_ticks));
+    Utilities::debugMessage("  self ms  total ms  samples  function");
+    for(size_t i = 0; i < times.size() and i < lines; i++)
+    {
+        Utilities::debugMessage("%9.2f %9.2f %8u  %s", times[i].self_ms, times[i].total_ms, times[i].samples, times[i].name.c_str());
+    }
+    return 0;
+}
+
+int LuaProfiler::lua_collapsed(lua_State* L)
+{
+    std::string s = check_profiler(L)->collapsed(lua_toboolean(L, 1) != 0);
+    lua_pushlstring(L, s.data(), s.size());
+    return 1;
+}
+
+int LuaProfiler::lua_save(lua_State* L)
+{
+    const char* filename = luaL_checkstring(L, 1);
+    std::string s = check_profiler(L)->collapsed(lua_toboolean(L, 2) != 0);
+
+    SaveDataPath path(filename);
+    if(path.c_str() == 0)
+    {
+        return luaL_error(L, "LuaProfiler.save - no save data directory");
+    }
+    FILE* f = fopen(path.c_str(), "w");
+    if(f == 0)
+    {
+        return luaL_error(L, "LuaProfiler.save - couldn't write %s", path.c_str());
+    }
+    fwrite(s.data(), 1, s.size(), f);
+    fclose(f);
+    VirtualFileSystem::notify_written(filename);
+
+    lua_pushstring(L, path.c_str());
+    return 1;
+}
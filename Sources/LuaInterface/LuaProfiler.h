@@ -0,0 +1,154 @@
+/*
+ * LuaProfiler.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#ifndef LUAPROFILER_H_
+#define LUAPROFILER_H_
+
+#include "SDL.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "lua.h"
+
+// Sampling profiler for one Lua state (every LuaMain has one, off by default).
+//
+// A count hook runs every few hundred VM instructions. Each hook call adds the
+// time since the previous one to the running total, and once that's more
+// than the sample interval, the current Lua stack gets the time. Stacks are
+// kept as lists of interned function ids in a hash table, so a sample is a
+// stack walk and a hash lookup - no strings are built until export.
+//
+// LuaMain::docall() tells the profiler when C++ calls into Lua and when it
+// gets back (enter() and leave()), and the time in between calls is counted
+// as outside Lua (e.g. the engine rendering between update and draw). Inside
+// a call every gap between hooks is Lua's, so a long C function called from
+// Lua goes to the Lua stack that called it. The bit after the last hook of
+// a call isn't given to any stack. Lua entered some other way (e.g. a
+// LuaRef callback) isn't marked, so its first gap is counted as outside.
+//
+// Coroutines created after start() are profiled. Coroutines that already
+// exist are not (hooks are per Lua thread).
+//
+// From Lua (or the console), all on the calling state:
+//		LuaProfiler.start([interval_ms=1], [instructions=200])
+//		LuaProfiler.stop()
+//		LuaProfiler.reset()
+//		LuaProfiler.running()
+//		LuaProfiler.report() -> array of { name, self_ms, total_ms, samples } sorted by self time
+//		LuaProfiler.print([n=20]) - report() to the debug log
+//		LuaProfiler.collapsed([samples]) -> "a;b;c 1234" lines, weight in microseconds (or sample counts)
+//		LuaProfiler.save(filename) - collapsed() to a file in the save data directory,
+//			ready for flamegraph.pl or speedscope
+class LuaProfiler {
+public:
+    LuaProfiler();
+    ~LuaProfiler();
+
+    void attach(lua_State* L);      // once, when the state is created
+    void start(double interval_ms = 1, int instructions = 200);
+    void stop();
+    void reset();
+    bool is_running() { return running; }
+
+    std::string collapsed(bool sample_counts = false);
+
+    struct FunctionTimes {
+        std::string name;
+        double self_ms;
+        double total_ms;
+        Uint32 samples;
+    };
+    void function_times(std::vector<FunctionTimes>& result);      // sorted, most self time first
+
+    // the profiler of the state (or 0 if it doesn't have one)
+    static LuaProfiler* of(lua_State* L);
+
+    // around calls from C++ into the state, nested calls are fine
+    static void enter(lua_State* L);
+    static void leave(lua_State* L);
+
+    // for Lua
+    static int lua_start(lua_State* L);
+    static int lua_stop(lua_State* L);
+    static int lua_reset(lua_State* L);
+    static int lua_running(lua_State* L);
+    static int lua_report(lua_State* L);
+    static int lua_print(lua_State* L);
+    static int lua_collapsed(lua_State* L);
+    static int lua_save(lua_State* L);
+
+private:
+    // lets not have these copy constructed or assigned
+    LuaProfiler(const LuaProfiler&);
+    LuaProfiler& operator=(const LuaProfiler&);
+
+    static void hook(lua_State* L, lua_Debug* ar);
+    void sample(lua_State* L, Uint64 weight);
+    int function_id(lua_State* L, lua_Debug& ar);
+
+    // functions are identified by where they were defined and what they were called
+    struct FunctionKey {
+        const char* source;     // Lua's own (interned) strings, so pointers are enough
+        const char* name;
+        int line;
+        bool operator==(const FunctionKey& o) const { return source == o.source and name == o.name and line == o.line; }
+    };
+    struct FunctionKeyHash {
+        size_t operator()(const FunctionKey& k) const;
+    };
+    struct StackHash {
+        size_t operator()(const std::vector<int>& s) const;
+    };
+    struct StackTimes {
+        StackTimes() : ticks(0), samples(0) {}
+        Uint64 ticks;
+        Uint32 samples;
+    };
+
+    lua_State* main_state;
+    bool running;
+    int hook_instructions;
+    Uint64 interval_ticks;
+    int call_depth;                 // of enter() without leave()
+    bool clock_running;             // last_hook was inside Lua
+    Uint64 last_hook;
+    Uint64 pending;
+    Uint64 outside_ticks;
+    Uint32 dropped_samples;
+
+    std::unordered_map<FunctionKey, int, FunctionKeyHash> function_ids;
+    std::unordered_map<std::string, int> name_ids;  // so the same function seen via different keys gets one id
+    std::vector<std::string> function_names;       // by id
+    std::unordered_map<std::vector<int>, StackTimes, StackHash> stacks;
+    std::vector<int> current_stack;                 // reused, to avoid allocating in the hook
+};
+
+#endif /* LUAPROFILER_H_ */
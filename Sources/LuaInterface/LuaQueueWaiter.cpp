@@ -0,0 +1,144 @@
+/*
+ * LuaQueueWaiter.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#include "LuaQueueWaiter.h"
+#include "Utilities.h"
+#ifdef _MSC_VER
+#include <ciso646>   // Visual Studio is not C++ standards complaint...
+#endif
+
+namespace {
+
+    SDL_SpinLock waiter_lock = 0;
+    SDL_TLSID waiter_tls = 0;
+    LuaQueueWaiter* free_waiters = 0;
+
+}
+
+static void LQW_abort(const char* s)
+{
+    Utilities::fatalError("LuaQueueWaiter failed to %s (SDL Error %s)",  s, SDL_GetError());
+}
+
+LuaQueueWaiter::LuaQueueWaiter()
+: rotate(0)
+, next_free(0)
+{
+    SDL_AtomicSet(&signalled, 0);
+    mutex = SDL_CreateMutex(); if(mutex == 0) {  LQW_abort("create mutex"); }
+    cond = SDL_CreateCond(); if(cond == 0) { LQW_abort("create condition"); }
+}
+
+LuaQueueWaiter::~LuaQueueWaiter()
+{
+    // never actually called, see header
+    SDL_DestroyMutex(mutex);
+    SDL_DestroyCond(cond);
+}
+
+LuaQueueWaiter* LuaQueueWaiter::for_this_thread()
+{
+    SDL_AtomicLock(&waiter_lock);
+    if(waiter_tls == 0)
+    {
+        waiter_tls = SDL_TLSCreate();
+        if(waiter_tls == 0) { SDL_AtomicUnlock(&waiter_lock); LQW_abort("create thread local storage"); }
+    }
+    SDL_TLSID tls = waiter_tls;
+    SDL_AtomicUnlock(&waiter_lock);
+
+    LuaQueueWaiter* w = static_cast<LuaQueueWaiter*>(SDL_TLSGet(tls));
+    if(w)
+    {
+        return w;
+    }
+
+    SDL_AtomicLock(&waiter_lock);
+    w = free_waiters;
+    if(w)
+    {
+        free_waiters = w->next_free;
+        w->next_free = 0;
+    }
+    SDL_AtomicUnlock(&waiter_lock);
+
+    if(not w)
+    {
+        w = new LuaQueueWaiter;
+    }
+    if(SDL_TLSSet(tls, w, thread_finished) != 0) { LQW_abort("set thread local storage"); }
+    return w;
+}
+
+void LuaQueueWaiter::thread_finished(void* waiter)
+{
+    LuaQueueWaiter* w = static_cast<LuaQueueWaiter*>(waiter);
+    SDL_AtomicLock(&waiter_lock);
+    w->next_free = free_waiters;
+    free_waiters = w;
+    SDL_AtomicUnlock(&waiter_lock);
+}
+
+void LuaQueueWaiter::signal()
+{
+    // only the first signal since the last wake up needs the mutex
+    if(SDL_AtomicSet(&signalled, 1) == 0)
+    {
+        if(SDL_LockMutex(mutex) != 0) { LQW_abort("lock mutex in signal"); }
+        if(SDL_CondSignal(cond) != 0) { LQW_abort("signal"); }
+        if(SDL_UnlockMutex(mutex) != 0) { LQW_abort("unlock mutex in signal"); }
+    }
+}
+
+bool LuaQueueWaiter::wait(Uint32 ms)
+{
+    bool woken = true;
+    Uint32 start = SDL_GetTicks();
+    if(SDL_LockMutex(mutex) != 0) { LQW_abort("lock mutex in wait"); }
+    while(SDL_AtomicGet(&signalled) == 0)
+    {
+        Uint32 remaining = ms;
+        if(ms != SDL_MUTEX_MAXWAIT)
+        {
+            Uint32 elapsed = SDL_GetTicks() - start;
+            if(elapsed >= ms)
+            {
+                woken = false;
+                break;
+            }
+            remaining = ms - elapsed;
+        }
+        if(SDL_CondWaitTimeout(cond, mutex, remaining) < 0) { LQW_abort("wait on signal"); }
+    }
+    SDL_AtomicSet(&signalled, 0);
+    if(SDL_UnlockMutex(mutex) != 0) { LQW_abort("unlock mutex in wait"); }
+    return woken;
+}
@@ -0,0 +1,74 @@
+/*
+ * LuaQueueWaiter.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#ifndef LUAQUEUEWAITER_H_
+#define LUAQUEUEWAITER_H_
+
+#include "SDL.h"
+
+// Something for a thread to sleep on while it waits for one or more queues.
+//
+// Each thread has exactly one (see for_this_thread()), and a reader registers
+// it with every queue it's waiting on. A sender only has to signal whatever
+// waiter is registered with its queue - so one thread can wait on lots of
+// queues without each queue needing its own condition variable.
+//
+// Waiters are recycled, never deleted, so a sender that signals a waiter just
+// as the owning thread finishes only causes a spurious wake up somewhere.
+class LuaQueueWaiter {
+public:
+    static LuaQueueWaiter* for_this_thread();
+
+    // wake the thread, if it's sleeping or about to sleep
+    void signal();
+    // sleep until signalled or out of time. Returns false if it timed out.
+    bool wait(Uint32 ms);
+
+    // used by select() to start scanning at a different queue each time
+    unsigned int next_start() { return rotate++; }
+
+private:
+    LuaQueueWaiter();
+    ~LuaQueueWaiter();
+    // lets not have these copy constructed or assigned
+    LuaQueueWaiter(const LuaQueueWaiter&);
+    LuaQueueWaiter& operator=(const LuaQueueWaiter&);
+
+    static void thread_finished(void* waiter);
+
+    SDL_atomic_t signalled;
+    SDL_mutex* mutex;
+    SDL_cond* cond;
+    unsigned int rotate;
+    LuaQueueWaiter* next_free;
+};
+
+#endif /* LUAQUEUEWAITER_H_ */
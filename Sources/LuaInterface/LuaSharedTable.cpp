@@ -0,0 +1,672 @@
+/*
+ * LuaSharedTable.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#include "LuaSharedTable.h"
+#include "LuaBridge.h"
+#include "Utilities.h"
+#include <cstring>
+#ifdef _MSC_VER
+#include <ciso646>   // Visual Studio is not C++ standards complaint...
+#endif
+
+// nested tables deeper than this are probably tables that contain themselves
+static const int max_shared_nesting = 64;
+
+
+//
+// Epoch based reclamation
+//
+// Readers announce the global epoch they started in. Something unlinked at
+// epoch N can't be seen by a reader that started in epoch N+1 or later, and the
+// global epoch only moves on when every active reader has caught up with it - so
+// once it reaches N+2 nobody can still be looking at the thing.
+//
+// http://www.cl.cam.ac.uk/techreports/UCAM-CL-TR-579.pdf (Fraser, section 5.2.3)
+//
+namespace {
+
+    struct EpochThread {
+        SDL_atomic_t epoch;         // 0 if not reading
+        SDL_atomic_t in_use;
+        int nesting;
+        EpochThread* next;
+    };
+
+    struct Retired {
+        void (*free_fn)(void*);
+        void* ptr;
+        int epoch;
+    };
+
+    SDL_atomic_t global_epoch = { 1 };
+    void* epoch_threads = 0;        // EpochThread*, append only, never freed
+    SDL_SpinLock epoch_lock = 0;
+    SDL_TLSID epoch_tls = 0;
+    std::vector<Retired>* retired = 0;
+
+    void epoch_thread_finished(void* data)
+    {
+        EpochThread* t = static_cast<EpochThread*>(data);
+        SDL_AtomicSet(&t->epoch, 0);
+        t->nesting = 0;
+        SDL_AtomicSet(&t->in_use, 0);     // someone else can have it
+    }
+
+    EpochThread* epoch_this_thread()
+    {
+        SDL_AtomicLock(&epoch_lock);
+        if(epoch_tls == 0)
+        {
+            epoch_tls = SDL_TLSCreate();
+        }
+        SDL_TLSID tls = epoch_tls;
+        SDL_AtomicUnlock(&epoch_lock);
+        if(tls == 0) { Utilities::fatalError("LuaSharedTable couldn't create thread local storage (SDL Error %s)", SDL_GetError()); }
+
+        EpochThread* t = static_cast<EpochThread*>(SDL_TLSGet(tls));
+        if(t) return t;
+
+        // reuse one from a finished thread...
+        for(t = static_cast<EpochThread*>(SDL_AtomicGetPtr(&epoch_threads)); t; t = t->next)
+        {
+            if(SDL_AtomicCAS(&t->in_use, 0, 1)) break;
+        }
+        // ... or add a new one
+        if(not t)
+        {
+            t = new EpochThread;
+            SDL_AtomicSet(&t->epoch, 0);
+            SDL_AtomicSet(&t->in_use, 1);
+            t->nesting = 0;
+            do {
+                t->next = static_cast<EpochThread*>(SDL_AtomicGetPtr(&epoch_threads));
+            } while(not SDL_AtomicCASPtr(&epoch_threads, t->next, t));
+        }
+        SDL_TLSSet(tls, t, epoch_thread_finished);
+        return t;
+    }
+
+    // A read section. Nothing that can raise a Lua error goes inside one:
+    // with Lua built as C an error is a longjmp, which skips the destructor
+    // and would pin the epoch forever. Copy out, close the section, then push.
+    class EpochReader {
+    public:
+        EpochReader() : t(epoch_this_thread())
+        {
+            if(t->nesting++) return;
+            // announce, then check the epoch didn't move while we did
+            int e = SDL_AtomicGet(&global_epoch);
+            for(;;)
+            {
+                SDL_AtomicSet(&t->epoch, e);
+                int now = SDL_AtomicGet(&global_epoch);
+                if(now == e) break;
+                e = now;
+            }
+        }
+        ~EpochReader()
+        {
+            if(--t->nesting == 0)
+            {
+                SDL_AtomicSet(&t->epoch, 0);
+            }
+        }
+    private:
+        EpochThread* t;
+    };
+
+    void try_advance_epoch()
+    {
+        int e = SDL_AtomicGet(&global_epoch);
+        for(EpochThread* t = static_cast<EpochThread*>(SDL_AtomicGetPtr(&epoch_threads)); t; t = t->next)
+        {
+            int te = SDL_AtomicGet(&t->epoch);
+            if(te != 0 and te != e) return;     // someone is still behind
+        }
+        SDL_AtomicCAS(&global_epoch, e, e + 1);
+    }
+
+    // free ptr once no reader can still see it. It must already be unreachable.
+    void retire(void* ptr, void (*free_fn)(void*))
+    {
+        std::vector<Retired> to_free;
+
+        SDL_AtomicLock(&epoch_lock);
+        if(not retired) retired = new std::vector<Retired>;     // never freed
+        Retired r = { free_fn, ptr, SDL_AtomicGet(&global_epoch) };
+        retired->push_back(r);
+
+        try_advance_epoch();
+        int e = SDL_AtomicGet(&global_epoch);
+        size_t keep = 0;
+        for(size_t i = 0; i < retired->size(); i++)
+        {
+            if((*retired)[i].epoch + 2 <= e)
+            {
+                to_free.push_back((*retired)[i]);
+            }
+            else
+            {
+                (*retired)[keep++] = (*retired)[i];
+            }
+        }
+        retired->resize(keep);
+        SDL_AtomicUnlock(&epoch_lock);
+
+        // outside the lock, freeing can release snapshots
+        for(size_t i = 0; i < to_free.size(); i++)
+        {
+            to_free[i].free_fn(to_free[i].ptr);
+        }
+    }
+
+    // FNV-1a
+    unsigned int hash_key(const std::string& key)
+    {
+        unsigned int h = 2166136261u;
+        for(size_t i = 0; i < key.size(); i++)
+        {
+            h ^= static_cast<unsigned char>(key[i]);
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+}
+
+
+//
+// Converting to and from Lua
+//
+bool make_shared_key(lua_State* L, int index, std::string& key)
+{
+    switch(lua_type(L, index))
+    {
+        case LUA_TNUMBER:
+        {
+            lua_Number n = lua_tonumber(L, index);
+            if(n == 0) n = 0;       // -0 and 0 are the same key to Lua
+            key.assign(1, 'n');
+            key.append(reinterpret_cast<const char*>(&n), sizeof(n));
+            return true;
+        }
+        case LUA_TSTRING:
+        {
+            size_t len;
+            const char* s = lua_tolstring(L, index, &len);
+            key.assign(1, 's');
+            key.append(s, len);
+            return true;
+        }
+        case LUA_TBOOLEAN:
+            key.assign(1, 'b');
+            key.append(1, lua_toboolean(L, index) ? '1' : '0');
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void push_shared_key(lua_State* L, const std::string& key)
+{
+    switch(key[0])
+    {
+        case 'n':
+        {
+            lua_Number n;
+            std::memcpy(&n, key.data() + 1, sizeof(n));
+            lua_pushnumber(L, n);
+            break;
+        }
+        case 's':
+            lua_pushlstring(L, key.data() + 1, key.size() - 1);
+            break;
+        default:
+            lua_pushboolean(L, key[1] == '1');
+            break;
+    }
+}
+
+bool make_shared_item(lua_State* L, int index, SharedItem& item, int depth)
+{
+    index = lua_absindex(L, index);
+    item.type = lua_type(L, index);
+    switch(item.type)
+    {
+        case LUA_TNIL:
+            return true;
+        case LUA_TBOOLEAN:
+            item.number = lua_toboolean(L, index);
+            return true;
+        case LUA_TNUMBER:
+            item.number = lua_tonumber(L, index);
+            return true;
+        case LUA_TSTRING:
+        {
+            size_t len;
+            const char* s = lua_tolstring(L, index, &len);
+            item.str.assign(s, len);
+            return true;
+        }
+        case LUA_TTABLE:
+        {
+            if(depth >= max_shared_nesting) return false;
+            lua_checkstack(L, 3);
+            SharedSnapshot* snap = new SharedSnapshot;
+            lua_pushnil(L);
+            while(lua_next(L, index) != 0)
+            {
+                std::string key;
+                SharedItem value;
+                if(make_shared_key(L, -2, key))
+                {
+                    if(not make_shared_item(L, -1, value, depth+1))
+                    {
+                        lua_pop(L, 2);
+                        snap->release();
+                        return false;
+                    }
+                    snap->items[key] = value;
+                }
+                lua_pop(L, 1);
+            }
+            item.table = snap;
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+void push_shared_item(lua_State* L, const SharedItem& item)
+{
+    switch(item.type)
+    {
+        case LUA_TBOOLEAN:
+            lua_pushboolean(L, item.number != 0);
+            break;
+        case LUA_TNUMBER:
+            lua_pushnumber(L, item.number);
+            break;
+        case LUA_TSTRING:
+            lua_pushlstring(L, item.str.data(), item.str.size());
+            break;
+        case LUA_TTABLE:
+            luabridge::push(L, SharedSnapshotRef(item.table));
+            break;
+        default:
+            lua_pushnil(L);
+            break;
+    }
+}
+
+
+//
+// SharedSnapshot
+//
+SharedSnapshot::SharedSnapshot()
+{
+    SDL_AtomicSet(&refcount, 1);
+}
+
+SharedSnapshot::~SharedSnapshot()
+{
+    for(items_t::iterator it = items.begin(); it != items.end(); ++it)
+    {
+        if(it->second.table) it->second.table->release();
+    }
+}
+
+void SharedSnapshot::add_ref()
+{
+    SDL_AtomicIncRef(&refcount);
+}
+
+void SharedSnapshot::release()
+{
+    if(SDL_AtomicDecRef(&refcount))
+    {
+        delete this;
+    }
+}
+
+SharedSnapshotRef::SharedSnapshotRef(SharedSnapshot* s)
+: snapshot(s)
+{
+    snapshot->add_ref();
+}
+
+SharedSnapshotRef::SharedSnapshotRef(const SharedSnapshotRef& other)
+: snapshot(other.snapshot)
+{
+    snapshot->add_ref();
+}
+
+SharedSnapshotRef::~SharedSnapshotRef()
+{
+    snapshot->release();
+}
+
+int SharedSnapshotRef::get(lua_State* L)
+{
+    std::string key;
+    if(not make_shared_key(L, 2, key))
+    {
+        lua_pushnil(L);
+        return 1;
+    }
+    SharedSnapshot::items_t::const_iterator it = snapshot->items.find(key);
+    if(it == snapshot->items.end())
+    {
+        lua_pushnil(L);
+    }
+    else
+    {
+        push_shared_item(L, it->second);
+    }
+    return 1;
+}
+
+static void push_snapshot_as_table(lua_State* L, SharedSnapshot* s)
+{
+    lua_checkstack(L, 3);
+    lua_createtable(L, 0, static_cast<int>(s->items.size()));
+    for(SharedSnapshot::items_t::const_iterator it = s->items.begin(); it != s->items.end(); ++it)
+    {
+        push_shared_key(L, it->first);
+        if(it->second.type == LUA_TTABLE)
+        {
+            push_snapshot_as_table(L, it->second.table);
+        }
+        else
+        {
+            push_shared_item(L, it->second);
+        }
+        lua_rawset(L, -3);
+    }
+}
+
+int SharedSnapshotRef::to_table(lua_State* L)
+{
+    push_snapshot_as_table(L, snapshot);
+    return 1;
+}
+
+
+//
+// LuaSharedTable
+//
+LuaSharedTable::Value::~Value()
+{
+    if(item.table) item.table->release();
+}
+
+LuaSharedTable::LuaSharedTable(std::string identifier_name, int size_hint)
+: id(identifier_name)
+{
+    // power of two, roughly one entry per bucket
+    size_t n = 16;
+    while(n < static_cast<size_t>(size_hint) and n < (1u << 20)) n <<= 1;
+    buckets.resize(n);
+    for(size_t i = 0; i < n; i++)
+    {
+        buckets[i].head = 0;
+        buckets[i].lock = 0;
+    }
+    SDL_AtomicSet(&live_count, 0);
+}
+
+LuaSharedTable::~LuaSharedTable()
+{
+    // nobody should be reading us any more
+    for(size_t i = 0; i < buckets.size(); i++)
+    {
+        Entry* e = static_cast<Entry*>(buckets[i].head);
+        while(e)
+        {
+            Entry* next = e->next;
+            delete static_cast<Value*>(e->value);
+            delete e;
+            e = next;
+        }
+    }
+}
+
+LuaSharedTable::Bucket& LuaSharedTable::bucket_for(const std::string& key)
+{
+    return buckets[hash_key(key) & (buckets.size() - 1)];
+}
+
+LuaSharedTable::Entry* LuaSharedTable::find(Bucket& b, const std::string& key)
+{
+    for(Entry* e = static_cast<Entry*>(SDL_AtomicGetPtr(&b.head)); e; e = e->next)
+    {
+        if(e->key == key) return e;
+    }
+    return 0;
+}
+
+// bucket must be locked
+LuaSharedTable::Entry* LuaSharedTable::find_or_add(Bucket& b, const std::string& key)
+{
+    Entry* e = find(b, key);
+    if(e) return e;
+
+    // entries are never removed, a removed key just has no value
+    e = new Entry;
+    e->key = key;
+    e->value = 0;
+    e->next = static_cast<Entry*>(b.head);
+    SDL_AtomicSetPtr(&b.head, e);
+    return e;
+}
+
+namespace {
+    template<class T> void delete_later(void* p) { delete static_cast<T*>(p); }
+}
+
+static bool has_value(const LuaSharedTable::Value* v)
+{
+    return v and v->item.type != LUA_TNIL;
+}
+
+static int version_of(const LuaSharedTable::Value* v)
+{
+    return v ? v->version : 0;
+}
+
+// bucket must be locked. Gives v the next version and publishes both at once.
+void LuaSharedTable::replace(Entry* e, Value* v)
+{
+    Value* old = static_cast<Value*>(e->value);
+    v->version = version_of(old) + 1;
+    SDL_AtomicSetPtr(&e->value, v);
+    if(has_value(v) and not has_value(old)) SDL_AtomicAdd(&live_count, 1);
+    if(has_value(old) and not has_value(v)) SDL_AtomicAdd(&live_count, -1);
+    if(old) retire(old, delete_later<Value>);
+}
+
+int LuaSharedTable::get(lua_State* L)
+{
+    std::string key;
+    if(not make_shared_key(L, 2, key))
+    {
+        return luaL_error(L, "LuaSharedTable %s: keys must be numbers, strings or booleans", id.c_str());
+    }
+
+    SharedItem item;        // nil if missing
+    int version;
+    {
+        EpochReader reading;
+        Entry* e = find(bucket_for(key), key);
+        Value* v = e ? static_cast<Value*>(SDL_AtomicGetPtr(&e->value)) : 0;
+        version = version_of(v);
+        if(has_value(v))
+        {
+            item = v->item;
+            if(item.table) item.table->add_ref();   // v can go once we stop reading
+        }
+    }
+
+    push_shared_item(L, item);
+    if(item.table) item.table->release();       // the pushed SharedSnapshotRef has its own
+    lua_pushinteger(L, version);
+    return 2;
+}
+
+int LuaSharedTable::get_version(lua_State* L)
+{
+    std::string key;
+    if(not make_shared_key(L, 2, key))
+    {
+        return luaL_error(L, "LuaSharedTable %s: keys must be numbers, strings or booleans", id.c_str());
+    }
+    int version;
+    {
+        EpochReader reading;
+        Entry* e = find(bucket_for(key), key);
+        version = version_of(e ? static_cast<Value*>(SDL_AtomicGetPtr(&e->value)) : 0);
+    }
+    lua_pushinteger(L, version);
+    return 1;
+}
+
+// makes the Value for the Lua value at index, a nil item for nil
+static LuaSharedTable::Value* make_value_for(lua_State* L, int index, const std::string& id)
+{
+    SharedItem item;
+    if(not make_shared_item(L, index, item))
+    {
+        luaL_error(L, "LuaSharedTable %s: can only share numbers, booleans, strings and tables of those", id.c_str());
+    }
+    LuaSharedTable::Value* v = new LuaSharedTable::Value;
+    v->item = item;         // takes over the snapshot reference
+    return v;
+}
+
+int LuaSharedTable::set(lua_State* L)
+{
+    std::string key;
+    if(not make_shared_key(L, 2, key))
+    {
+        return luaL_error(L, "LuaSharedTable %s: keys must be numbers, strings or booleans", id.c_str());
+    }
+    Value* v = make_value_for(L, 3, id);
+
+    Bucket& b = bucket_for(key);
+    SDL_AtomicLock(&b.lock);
+    Entry* e = find_or_add(b, key);
+    replace(e, v);
+    int version = v->version;       // v might be replaced as soon as we unlock
+    SDL_AtomicUnlock(&b.lock);
+
+    lua_pushinteger(L, version);
+    return 1;
+}
+
+int LuaSharedTable::compare_and_set(lua_State* L)
+{
+    std::string key;
+    if(not make_shared_key(L, 2, key))
+    {
+        return luaL_error(L, "LuaSharedTable %s: keys must be numbers, strings or booleans", id.c_str());
+    }
+    int expected = luaL_checkint(L, 3);
+    Value* v = make_value_for(L, 4, id);
+
+    Bucket& b = bucket_for(key);
+    SDL_AtomicLock(&b.lock);
+    Entry* e = find_or_add(b, key);
+    int version = version_of(static_cast<Value*>(e->value));
+    bool ok = (version == expected);
+    if(ok)
+    {
+        replace(e, v);
+        version = v->version;
+    }
+    SDL_AtomicUnlock(&b.lock);
+
+    if(not ok) delete v;
+    lua_pushboolean(L, ok);
+    lua_pushinteger(L, version);
+    return 2;
+}
+
+int LuaSharedTable::increment(lua_State* L)
+{
+    std::string key;
+    if(not make_shared_key(L, 2, key))
+    {
+        return luaL_error(L, "LuaSharedTable %s: keys must be numbers, strings or booleans", id.c_str());
+    }
+    lua_Number delta = luaL_optnumber(L, 3, 1);
+
+    Value* v = new Value;
+    v->item.type = LUA_TNUMBER;
+
+    Bucket& b = bucket_for(key);
+    SDL_AtomicLock(&b.lock);
+    Entry* e = find_or_add(b, key);
+    Value* old = static_cast<Value*>(e->value);
+    v->item.number = ((old and old->item.type == LUA_TNUMBER) ? old->item.number : 0) + delta;
+    replace(e, v);
+    int version = v->version;
+    lua_Number result = v->item.number;     // v might be replaced as soon as we unlock
+    SDL_AtomicUnlock(&b.lock);
+
+    lua_pushnumber(L, result);
+    lua_pushinteger(L, version);
+    return 2;
+}
+
+SharedSnapshotRef LuaSharedTable::snapshot()
+{
+    SharedSnapshot* snap = new SharedSnapshot;
+
+    // hold every bucket so nothing changes while we copy
+    for(size_t i = 0; i < buckets.size(); i++) SDL_AtomicLock(&buckets[i].lock);
+    for(size_t i = 0; i < buckets.size(); i++)
+    {
+        for(Entry* e = static_cast<Entry*>(buckets[i].head); e; e = e->next)
+        {
+            Value* v = static_cast<Value*>(e->value);
+            if(not has_value(v)) continue;
+            SharedItem& item = snap->items[e->key];
+            item = v->item;
+            if(item.table) item.table->add_ref();
+        }
+    }
+    for(size_t i = buckets.size(); i > 0; i--) SDL_AtomicUnlock(&buckets[i-1].lock);
+
+    SharedSnapshotRef ref(snap);
+    snap->release();        // ref has it now
+    return ref;
+}
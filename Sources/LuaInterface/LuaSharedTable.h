@@ -0,0 +1,156 @@
+/*
+ * LuaSharedTable.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#ifndef LUASHAREDTABLE_H_
+#define LUASHAREDTABLE_H_
+
+#include "SDL.h"
+#include <string>
+#include <vector>
+#include <map>
+#include "lua.h"
+#include "lauxlib.h"
+
+class SharedSnapshot;
+
+// One value in a LuaSharedTable or SharedSnapshot
+struct SharedItem {
+    SharedItem() : type(LUA_TNIL), number(0), table(0) {}
+    int type;                   // LUA_TNIL, LUA_TBOOLEAN, LUA_TNUMBER, LUA_TSTRING or LUA_TTABLE
+    double number;              // numbers and booleans
+    std::string str;
+    SharedSnapshot* table;      // a reference is held
+};
+
+// An immutable table, shared between any number of Lua states without copying.
+// Reference counted.
+class SharedSnapshot {
+public:
+    SharedSnapshot();
+    void add_ref();
+    void release();
+
+    typedef std::map<std::string, SharedItem> items_t;     // key is from make_shared_key()
+    items_t items;
+
+private:
+    ~SharedSnapshot();
+    // lets not have these copy constructed or assigned
+    SharedSnapshot(const SharedSnapshot&);
+    SharedSnapshot& operator=(const SharedSnapshot&);
+    SDL_atomic_t refcount;
+};
+
+// What Lua sees of a SharedSnapshot - a value type, so each copy holds a reference
+class SharedSnapshotRef {
+public:
+    SharedSnapshotRef(SharedSnapshot* s);
+    SharedSnapshotRef(const SharedSnapshotRef& other);
+    ~SharedSnapshotRef();
+
+    int get(lua_State* L);          // get(key) returns the value or nil
+    int to_table(lua_State* L);     // deep copy into an ordinary Lua table
+    int count() { return static_cast<int>(snapshot->items.size()); }
+
+private:
+    SharedSnapshotRef& operator=(const SharedSnapshotRef&);
+    SharedSnapshot* snapshot;
+};
+
+
+// Key/value store shared by several Lua states (like LuaStateQueue, create it in
+// one and hand the pointer to the others).
+//
+// Values are numbers, booleans, strings and tables. Tables are stored as an
+// immutable SharedSnapshot, so reading one back doesn't copy it.
+//
+// Reads take no locks at all - they're protected by epoch based reclamation,
+// so a replaced value isn't freed until every reader that might have seen it
+// has finished. Writers lock just the bucket they're changing.
+//
+// Every key has a version number that goes up each time it's written, for
+// optimistic updates with compare_and_set().
+class LuaSharedTable {
+public:
+    LuaSharedTable(std::string identifier_name, int size_hint);
+    ~LuaSharedTable();
+
+    int get(lua_State* L);              // get(key) returns value, version (nil, 0 if missing)
+    int set(lua_State* L);              // set(key, value) returns the new version. nil removes.
+    int compare_and_set(lua_State* L);  // compare_and_set(key, expected_version, value) returns ok, version
+    int increment(lua_State* L);        // increment(key, [delta]) returns the new value, version
+    int get_version(lua_State* L);      // get_version(key)
+    SharedSnapshotRef snapshot();       // the whole table, at one instant
+
+    std::string get_identifier() { return id; }
+    int count() { return SDL_AtomicGet(&live_count); }
+
+    // Immutable once published. The version lives in here rather than in the
+    // Entry so a reader gets the value and its version from one pointer load.
+    // A removed key is a nil item, so it keeps counting versions.
+    struct Value {
+        Value() : version(0) {}
+        SharedItem item;
+        int version;
+        ~Value();
+    };
+
+private:
+    // lets not have these copy constructed or assigned
+    LuaSharedTable(const LuaSharedTable&);
+    LuaSharedTable& operator=(const LuaSharedTable&);
+
+    struct Entry {
+        std::string key;
+        void* value;            // Value*, 0 if never written
+        Entry* next;            // never changes once published
+    };
+    struct Bucket {
+        void* head;             // Entry*
+        SDL_SpinLock lock;      // writers only
+    };
+
+    Bucket& bucket_for(const std::string& key);
+    Entry* find(Bucket& b, const std::string& key);
+    Entry* find_or_add(Bucket& b, const std::string& key);
+    void replace(Entry* e, Value* v);
+
+    std::vector<Bucket> buckets;
+    std::string id;
+    SDL_atomic_t live_count;
+};
+
+// turn the Lua key/value at index into our form. Returns false if it can't be shared.
+bool make_shared_key(lua_State* L, int index, std::string& key);
+bool make_shared_item(lua_State* L, int index, SharedItem& item, int depth = 0);
+void push_shared_item(lua_State* L, const SharedItem& item);
+
+#endif /* LUASHAREDTABLE_H_ */
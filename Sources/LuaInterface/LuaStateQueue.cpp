@@ -30,286 +30,318 @@
 */
 
 #include "LuaStateQueue.h"
+#include "LuaMessage.h"
+#include "LuaQueueWaiter.h"
+#include "Trace.h"
 #include "lauxlib.h"
 #include "lualib.h"
 #include "LuaBridge.h"
 #include "Utilities.h"
-#include <memory>   // for unique_ptr ... can't stand the various rule-of-three/rule-of-5 junk required otherwise
+#include <algorithm>
+#ifdef _MSC_VER
+#include <ciso646>   // Visual Studio is not C++ standards complaint...
+#endif
 
 
-// Locking/signals based on: https://www.justsoftwaresolutions.co.uk/threading/implementing-a-thread-safe-queue-using-condition-variables.html
+// Originally this was a std::queue of trees of GenericLuaTypeStore under a mutex
+// and condition variable, based on:
+// https://www.justsoftwaresolutions.co.uk/threading/implementing-a-thread-safe-queue-using-condition-variables.html
+//
+// Now messages are flat LuaMessage buffers, passed through a lock free ring:
+// http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
 //
 // Other references
 // http://lazyfoo.net/tutorials/SDL/49_mutexes_and_conditions/index.php
 // https://wiki.libsdl.org/SDL_LockMutex
-// http://cboard.cprogramming.com/linux-programming/116184-best-solution-inter-thread-communication.html
-// also see StdinThread
+// https://wiki.libsdl.org/CategoryAtomic
 // http://fabiensanglard.net/doom3_bfg/threading.php
-// http://stackoverflow.com/questions/5592583/different-mutex-for-push-and-pop
 // https://en.wikipedia.org/wiki/Producer%E2%80%93consumer_problem
 
-// @todo: Make sure our mutex locking is exception safe by using RAII.
-
 // On MUTEX vs. Atomic locks
-// Most operations are short operations, hopefully. Could use atomic lock here
-// but we also signal to wake a thread that's waiting ... which needs a proper Mutex.
+// Sending and receiving are atomic operations only. The reader's LuaQueueWaiter
+// (mutex and condition variable) is only touched when the reader has run out of
+// messages and wants to sleep, since waking a thread needs a proper Mutex.
 
+// must be a power of two
+static const int queue_capacity = 4096;
 
+// most queues select() can wait on at once
+static const int max_select_queues = 64;
+
+// when full, how many times send() yields before it starts sleeping
+static const int full_yields_before_sleep = 100;
+// a sender that has waited this long says so (once), as the reader might be stuck
+static const Uint32 full_wait_report_ms = 10000;
 
-// We use the Lua types here:
-// LUA_TNIL, LUA_TNUMBER, LUA_TBOOLEAN, LUA_TSTRING, LUA_TTABLE, LUA_TFUNCTION, LUA_TUSERDATA, LUA_TTHREAD, and LUA_TLIGHTUSERDATA
-// not allowed anywhere: thread, function, userdata, lightuserdata
-// (and additionally table and nil not allowed as key in tables)
-//
-// For tables:
-// Allowed as key: number, bool, string
-// Allowed as value: nil, number, bool, string, table
-//
-// No int & float sub-type until Lua 5.3
 
-// this is more like an advanced struct than a class
-class GenericLuaTypeStore
+static SDL_SpinLock list_lock = 0;
+static std::vector<LuaStateQueue*>& queue_list()
 {
-public:
-    GenericLuaTypeStore();
-    ~GenericLuaTypeStore();
-    //
-    // data
-    //
-    // NOTICE: some of these we could union to save space. We don't worry about that, however.
-    int type;
-    double val;
-    std::string s;
-    
-    int key_type;
-    int key_val;
-    std::string key_s;
-
-    //std::unique_ptr<GenericLuaTypeStore> nested_into;   // points to a nested table
-    //std::unique_ptr<GenericLuaTypeStore> list_next;     // points to the next element in the same table
-    GenericLuaTypeStore* nested_into;   // points to a nested table
-    GenericLuaTypeStore* list_next;     // points to the next element in the same table
-private:
-    //GenericLuaTypeStore& operator=();
-    //GenericLuaTypeStore(GenericLuaTypeStore&);
-    
-};
-
-GenericLuaTypeStore::GenericLuaTypeStore()
-: type(-998), val(0), key_type(-999), key_val(0), nested_into(0), list_next(0)
+    static std::vector<LuaStateQueue*>* list = new std::vector<LuaStateQueue*>;     // never deleted, states can outlive statics
+    return *list;
+}
+
+
+static void LSQ_abort(const char* s)
 {
+    Utilities::fatalError("LuaStateQueue failed to %s (SDL Error %s)",  s, SDL_GetError());
 }
 
 
-GenericLuaTypeStore::~GenericLuaTypeStore()
+LuaStateQueue::LuaStateQueue(std::string identifier_name)
+: ring(queue_capacity)
+, mask(queue_capacity-1)
+, head(0)
+, id(identifier_name)
+, waiter(0)
 {
-    delete nested_into;
-    nested_into = 0;
-    delete list_next;
-    list_next = 0;
+    for(int i = 0; i < queue_capacity; i++)
+    {
+        SDL_AtomicSet(&ring[i].sequence, i);
+        ring[i].message = 0;
+    }
+    SDL_AtomicSet(&tail, 0);
+    SDL_AtomicSet(&full_count, 0);
+
+    lock_list();
+    queue_list().push_back(this);
+    unlock_list();
 }
 
+LuaStateQueue::~LuaStateQueue()
+{
+    lock_list();
+    std::vector<LuaStateQueue*>& list = queue_list();
+    list.erase(std::remove(list.begin(), list.end(), this), list.end());
+    unlock_list();
+
+    while(LuaMessage* m = pop())
+    {
+        m->release();
+    }
+}
 
-namespace  {
-    
 
-    void copy_object_from_lua_state(lua_State* L, GenericLuaTypeStore& obj)
+bool LuaStateQueue::push(LuaMessage* m)
+{
+    int pos = SDL_AtomicGet(&tail);
+    Slot* slot;
+    for(;;)
     {
-        int index = -1;
-        int ltype = lua_type(L, index);
-        
-        // initialise this object
-        obj.type = ltype;
-        
-        // create the value for this type
-        switch(ltype)
+        slot = &ring[pos & mask];
+        int seq = SDL_AtomicGet(&slot->sequence);
+        int diff = static_cast<int>(static_cast<unsigned>(seq) - static_cast<unsigned>(pos));
+        if(diff == 0)
         {
-            case LUA_TNIL:
-                break;
-            case LUA_TBOOLEAN:
-                obj.val = lua_toboolean(L, index);
-                break;
-            case LUA_TNUMBER:
-                obj.val = lua_tonumber(L, index);
-                break;
-            case LUA_TSTRING:
-            {
-                size_t len;
-                const char* c = lua_tolstring(L, index, &len);
-                obj.s = std::string(c, len);
-                break;
-            }
-            case LUA_TTABLE:
+            // slot is free on this lap, try and claim it
+            if(SDL_AtomicCAS(&tail, pos, static_cast<int>(static_cast<unsigned>(pos) + 1)))
             {
-                int t = -2;
-                GenericLuaTypeStore** link = &obj.nested_into;  // the top level object gets a nested pointer
-                
-                /* table is in the stack at index 't' */
-                lua_pushnil(L);  /* first key */
-                while (lua_next(L, t) != 0) {
-                    int ktype = lua_type(L, -2);
-                    // only allow specific key type
-                    if(ktype == LUA_TBOOLEAN or ktype == LUA_TNUMBER or ktype == LUA_TSTRING)
-                    {
-                        GenericLuaTypeStore* new_obj = new GenericLuaTypeStore;
-                        *link = new_obj;    // point to next object (either higher up, or previous in table)
-                        link = &new_obj->list_next;
-                        
-                        /* uses 'key' (at index -2) and 'value' (at index -1) */
-                        //printf("%s - %s\n",
-                        //       lua_typename(L, ktype),
-                        //       lua_typename(L, lua_type(L, -1)));
-                        
-                        // set up value
-                        copy_object_from_lua_state(L, *new_obj);
-                        
-                        // set up key
-                        new_obj->key_type = lua_type(L, -2);
-                        if(ktype == LUA_TBOOLEAN)
-                        {
-                            new_obj->key_val = lua_toboolean(L, -2);
-                        }
-                        else if(ktype == LUA_TNUMBER)
-                        {
-                            new_obj->key_val = lua_tonumber(L, -2);
-                        }
-                        else if(ktype == LUA_TSTRING)
-                        {
-                            size_t len;
-                            const char* c = lua_tolstring(L, -2, &len);
-                            new_obj->key_s = std::string(c, len);
-                        }
-                        else
-                        {
-                            Utilities::fatalError("Coding error in copy_object_from_lua_state");
-                        }
-
-                    }
-                    /* removes 'value'; keeps 'key' for next iteration */
-                    lua_pop(L, 1);
-                }
                 break;
             }
-            default:
-                // don't know what to do with this type
-                obj.type = LUA_TNIL;
-                break;
+            pos = SDL_AtomicGet(&tail);
         }
+        else if(diff < 0)
+        {
+            // consumer hasn't emptied this slot from the last lap
+            return false;
+        }
+        else
+        {
+            // another producer got here first
+            pos = SDL_AtomicGet(&tail);
+        }
+    }
+
+    slot->message = m;
+    // publish - SDL_AtomicSet is a full barrier
+    SDL_AtomicSet(&slot->sequence, static_cast<int>(static_cast<unsigned>(pos) + 1));
+
+    wake_consumer();
+    return true;
+}
+
+LuaMessage* LuaStateQueue::pop()
+{
+    Slot* slot = &ring[head & mask];
+    int seq = SDL_AtomicGet(&slot->sequence);
+    if(seq != static_cast<int>(static_cast<unsigned>(head) + 1))
+    {
+        return 0;
+    }
+    LuaMessage* m = slot->message;
+    slot->message = 0;
+    // hand the slot back to producers for the next lap
+    SDL_AtomicSet(&slot->sequence, static_cast<int>(static_cast<unsigned>(head) + mask + 1));
+    head = static_cast<int>(static_cast<unsigned>(head) + 1);
+    return m;
+}
+
+void LuaStateQueue::wake_consumer()
+{
+    // the reader registers its waiter before it checks the ring for the last
+    // time, so either it sees our message or we see its waiter.
+    LuaQueueWaiter* w = static_cast<LuaQueueWaiter*>(SDL_AtomicGetPtr(&waiter));
+    if(w)
+    {
+        w->signal();
     }
+}
+
+LuaMessage* LuaStateQueue::pop_wait(Uint32 ms)
+{
+    LuaMessage* m = pop();
+    if(m or ms == 0)
+    {
+        return m;
+    }
+    LuaStateQueue* self = this;
+    select(&self, 1, ms, m);
+    return m;
+}
 
-    int copy_object_to_lua_state(lua_State* L, GenericLuaTypeStore& obj)
+LuaStateQueue* LuaStateQueue::select(LuaStateQueue** queues, int count, Uint32 ms, LuaMessage*& m)
+{
+    m = 0;
+    if(count <= 0)
+    {
+        return 0;
+    }
+
+    // start somewhere different each time, so a busy queue can't starve the others
+    LuaQueueWaiter* w = LuaQueueWaiter::for_this_thread();
+    int first = static_cast<int>(w->next_start() % count);
+
+    // register with all of them, then check them, so a send can't slip in between
+    for(int i = 0; i < count; i++)
     {
-        switch(obj.type)
+        SDL_AtomicSetPtr(&queues[i]->waiter, w);
+    }
+
+    LuaStateQueue* ready = 0;
+    Uint32 start = SDL_GetTicks();
+    for(;;)
+    {
+        for(int i = 0; i < count and not ready; i++)
         {
-            case LUA_TNIL:
-                //printf("nil\n");
-                lua_pushnil(L);
-                break;
-            case LUA_TBOOLEAN:
-                //printf("boolean\n");
-                lua_pushboolean(L, obj.val);
-                break;
-            case LUA_TSTRING:
-                //printf("string %s\n", obj.s.c_str());
-                lua_pushlstring(L, obj.s.c_str(), obj.s.length());
-                break;
-            case LUA_TNUMBER:
-                //printf("number\n");
-                lua_pushnumber(L, obj.val);
-                break;
-            case LUA_TTABLE:
+            LuaStateQueue* q = queues[(first + i) % count];
+            m = q->pop();
+            if(m) ready = q;
+        }
+        if(ready or ms == 0)
+        {
+            break;
+        }
+
+        Uint32 remaining = ms;
+        if(ms != SDL_MUTEX_MAXWAIT)
+        {
+            Uint32 elapsed = SDL_GetTicks() - start;
+            if(elapsed >= ms)
             {
-                //printf("table\n");
-                GenericLuaTypeStore* current = obj.nested_into;
-                //GenericLuaTypeStore* current = obj.nested_into.get();       // @todo: get() is horrible, replace with nicer mechanism
-                // note: empty tables are valid!
-                lua_newtable(L);
-                while(current)
-                {
-                    switch(current->key_type)
-                    {
-                        case LUA_TBOOLEAN:
-                            //printf("k-bool %d\n", current->key_val);
-                            lua_pushboolean(L, current->key_val);
-                            break;
-                        case LUA_TSTRING:
-                            //printf("k-string %s\n", current->key_s.c_str());
-                            lua_pushlstring(L, current->key_s.c_str(), current->key_s.length());
-                            break;
-                        case LUA_TNUMBER:
-                            //printf("k-number %d\n", current->key_val);
-                            lua_pushnumber(L, current->key_val);
-                            break;
-                        default:
-                            Utilities::fatalError("Unknown key type in copy_object_to_lua_state()");
-                            break;
-                    }
-                    
-                    copy_object_to_lua_state(L, *current);
-                    // t[k] = v, where t is the value at the given index, v is the value at the top of the stack, and k is the value just below the top.
-                    // function pops key and value
-                    lua_rawset(L, -3);  // same as lua_settable()a
-                    current = current->list_next;
-                    //current = current->list_next.get();        // @todo: get() is horrible, replace with nicer mechanism
-                }
                 break;
             }
-            default:
-                Utilities::fatalError("Unknown type in copy_object_to_lua_state()");
-                break;
+            remaining = ms - elapsed;
         }
-        
-        return 1;
+        FF_TRACE_ZONE("queue wait");
+        w->wait(remaining);
     }
 
+    for(int i = 0; i < count; i++)
+    {
+        SDL_AtomicCASPtr(&queues[i]->waiter, w, 0);
+    }
+    return ready;
 }
 
-static void LSQ_abort(const char* s)
+int LuaStateQueue::select(lua_State *L)
 {
-    Utilities::fatalError("LuaStateQueue failed to %s (SDL Error %s)",  s, SDL_GetError());
-}
+    luaL_checktype(L, 1, LUA_TTABLE);
+    Uint32 ms = lua_isnoneornil(L, 2) ? SDL_MUTEX_MAXWAIT : static_cast<Uint32>(luaL_checknumber(L, 2));
 
+    LuaStateQueue* queues[max_select_queues];
+    int count = static_cast<int>(lua_rawlen(L, 1));
+    if(count == 0)
+    {
+        // nothing could ever arrive
+        return luaL_argerror(L, 1, "expected a table of LuaStateQueues, got an empty one");
+    }
+    if(count > max_select_queues)
+    {
+        return luaL_error(L, "LuaStateQueue.select can wait on at most %d queues", max_select_queues);
+    }
+    for(int i = 0; i < count; i++)
+    {
+        lua_rawgeti(L, 1, i+1);
+        queues[i] = lua_isnil(L, -1) ? 0 : luabridge::Stack<LuaStateQueue*>::get(L, lua_gettop(L));
+        lua_pop(L, 1);
+        if(queues[i] == 0)
+        {
+            return luaL_argerror(L, 1, "expected a table of LuaStateQueues");
+        }
+    }
 
-LuaStateQueue::LuaStateQueue(std::string identifier_name)
-:id(identifier_name)
-{
-#if THREADSAFE_LUASTATEQUEUE
-    q_protect = SDL_CreateMutex(); if(q_protect == 0) {  LSQ_abort("create mutex"); }
-    data_available_cond = SDL_CreateCond(); if(data_available_cond == 0) { LSQ_abort("create condition"); }
-#endif
+    LuaMessage* m;
+    LuaStateQueue* ready = select(queues, count, ms, m);
+    if(not ready)
+    {
+        lua_pushnil(L);
+        return 1;
+    }
+    lua_pushlstring(L, ready->id.c_str(), ready->id.length());
+    m->decode(L);
+    m->release();
+    return 2;
 }
 
-LuaStateQueue::~LuaStateQueue()
+
+// add something to the queue
+bool LuaStateQueue::try_send(lua_State* L)
 {
-#if THREADSAFE_LUASTATEQUEUE
-    SDL_DestroyMutex(q_protect);
-    SDL_DestroyCond(data_available_cond);
-#endif
+    LuaMessage* m = LuaMessage::acquire();
+    if(not m->encode(L, -1))
+    {
+        m->release();
+        luaL_error(L, "LuaStateQueue %s: message nested too deeply", id.c_str());
+    }
+    if(not push(m))
+    {
+        SDL_AtomicAdd(&full_count, 1);
+        m->release();
+        return false;
+    }
+    return true;
 }
 
-
-// add something to the queue
-void LuaStateQueue::send(lua_State* Lua_object)
+void LuaStateQueue::send(lua_State* L)
 {
-    //if(replyQ_source==0)
-    //{
-    //    Utilities::fatalError("replyQ_source cannot be NIL");
-    //}
-    
-    GenericLuaTypeStore* temp = new GenericLuaTypeStore;
-    copy_object_from_lua_state(Lua_object, *temp);
-    
-#if THREADSAFE_LUASTATEQUEUE
-    if(SDL_LockMutex(q_protect) != 0) { LSQ_abort("lock mutex in send"); }
-#endif
-    q.push(temp);           // simple pointer copy
-#if THREADSAFE_LUASTATEQUEUE
-    if(SDL_UnlockMutex(q_protect) != 0) { LSQ_abort("unlock mutex in send"); }
-    if(SDL_CondSignal(data_available_cond) != 0) { LSQ_abort("signal"); }
-#endif
-    // we could check if it's empty before signalling ... if there is only
-    // one reader to avoid unnessary signalling ... but "condition variable notify calls are pretty light-weight when there are no threads waiting."
-    // could have used SDL_CondBroadcast() if multiple readers were to be woken
+    LuaMessage* m = LuaMessage::acquire();
+    if(not m->encode(L, -1))
+    {
+        m->release();
+        luaL_error(L, "LuaStateQueue %s: message nested too deeply", id.c_str());
+    }
+    if(push(m))
+    {
+        return;
+    }
+
+    // full - wait for the consumer to catch up, however long that takes (it
+    // might be loading, or stopped in a debugger). try_send() doesn't wait.
+    SDL_AtomicAdd(&full_count, 1);
+    FF_TRACE_ZONE("queue full wait");
+    int tries = 0;
+    Uint32 start = SDL_GetTicks();
+    bool reported = false;
+    while(not push(m))
+    {
+        SDL_Delay(tries++ < full_yields_before_sleep ? 0 : 1);
+        if(not reported and SDL_GetTicks() - start > full_wait_report_ms)
+        {
+            // maybe sending to our own queue, or the reader has died
+            Utilities::debugMessage("LuaStateQueue %s has been full for %d seconds, still waiting", id.c_str(), full_wait_report_ms/1000);
+            reported = true;
+        }
+    }
 }
 
 // get something from the queue
@@ -323,57 +355,15 @@ int LuaStateQueue::read_timeout(lua_State *L)
 {
     Uint32 ms = lua_tonumber(L, -1);
     lua_pop(L, 1);
-    
-    int return_values = 0;
-#if THREADSAFE_LUASTATEQUEUE
-    // wait for something in queue?
-    if(SDL_LockMutex(q_protect) != 0) { LSQ_abort("lock mutex in read"); }
-    while(q.empty())
-    {
-        int result = SDL_CondWaitTimeout(data_available_cond, q_protect, ms);
-        if (result == SDL_MUTEX_TIMEDOUT)
-        {
-            lua_pushnil(L);
-            return 1;
-        }
-        else if(result != 0)
-        {
-            LSQ_abort("wait on signal");
-        }
-    }
-    // return item from queue
-#else
-    if(!q.empty())
-    {
-#endif
-        GenericLuaTypeStore* temp =  q.front();
-        q.pop();
-#if THREADSAFE_LUASTATEQUEUE
-        if(SDL_UnlockMutex(q_protect) != 0) { LSQ_abort("unlock mutex in read"); }
-#endif
-        
-        if(temp->list_next)
-        {
-            Utilities::fatalError("Why is temp.list_next on top level set?");
-        }
-        //temp.list_next = 0;     // make sure that next is not set for top level item. Shouldn't be ... but just in case
-        
-        return_values =  copy_object_to_lua_state(L, *temp);
-
-        // manual memory management ... replace with unique_ptr()
-        delete temp;
-        
-#if (THREADSAFE_LUASTATEQUEUE == 0)
-    }
-    else
+
+    LuaMessage* m = pop_wait(ms);
+    if(not m)
     {
-        // what should we do in this case?
-        // maybe we should suspend until the queue is empty?
-        //  or return nil immediately?
-        //  or wait for an amount of time specified by an option input parameter?
-        Utilities::fatalError("queue is empty - case not handled yet");
+        lua_pushnil(L);
+        return 1;
     }
-#endif
+    int return_values = m->decode(L);
+    m->release();
     return return_values;
 }
 
@@ -381,15 +371,8 @@ int LuaStateQueue::read_timeout(lua_State *L)
 // is anything in queue?
 bool LuaStateQueue::is_empty()
 {
-#if THREADSAFE_LUASTATEQUEUE
-    if(SDL_LockMutex(q_protect) != 0) { LSQ_abort("lock mutex in is_empty"); }
-#endif
-    bool result = q.empty();
-#if THREADSAFE_LUASTATEQUEUE
-    if(SDL_UnlockMutex(q_protect) != 0) { LSQ_abort("unlock mutex in is_empty"); }
-#endif
-
-    return result;
+    Slot* slot = &ring[head & mask];
+    return SDL_AtomicGet(&slot->sequence) != static_cast<int>(static_cast<unsigned>(head) + 1);
 }
 
 std::string LuaStateQueue::get_identifier()
@@ -397,4 +380,142 @@ std::string LuaStateQueue::get_identifier()
     return id;
 }
 
+int LuaStateQueue::get_full_count()
+{
+    return SDL_AtomicGet(&full_count);
+}
 
+// head belongs to the consumer, so rather than slow down pop() we count the
+// slots holding a message. A slot at index i is full when its sequence is
+// position+1 for some lap, and empty when it's position or position+capacity.
+int LuaStateQueue::get_depth()
+{
+    int depth = 0;
+    for(int i = 0; i <= mask; i++)
+    {
+        if((SDL_AtomicGet(&ring[i].sequence) & mask) == ((i + 1) & mask))
+        {
+            depth++;
+        }
+    }
+    return depth;
+}
+
+void LuaStateQueue::lock_list()
+{
+    SDL_AtomicLock(&list_lock);
+}
+
+void LuaStateQueue::unlock_list()
+{
+    SDL_AtomicUnlock(&list_lock);
+}
+
+const std::vector<LuaStateQueue*>& LuaStateQueue::get_list()
+{
+    return queue_list();
+}
+
+
+//
+// Benchmark
+//
+namespace {
+
+    struct BenchmarkProducer
+    {
+        LuaStateQueue* q;
+        int payload_size;
+        int messages;
+        int full;           // times push() found the queue full
+    };
+
+    int benchmark_producer(void* data)
+    {
+        BenchmarkProducer* p = static_cast<BenchmarkProducer*>(data);
+
+        // each producer gets its own state, like a real LuaThread
+        lua_State* L = luaL_newstate();
+        lua_newtable(L);
+        lua_pushinteger(L, 0);
+        lua_setfield(L, -2, "id");
+        std::string payload(p->payload_size, 'x');
+        lua_pushlstring(L, payload.c_str(), payload.size());
+        lua_setfield(L, -2, "data");
+
+        for(int i = 0; i < p->messages; i++)
+        {
+            lua_pushinteger(L, i);
+            lua_setfield(L, -2, "id");
+
+            LuaMessage* m = LuaMessage::acquire();
+            m->encode(L, -1);
+            int tries = 0;
+            while(not p->q->push(m))
+            {
+                if(tries == 0) p->full++;
+                SDL_Delay(tries++ < full_yields_before_sleep ? 0 : 1);
+            }
+        }
+        lua_close(L);
+        return 0;
+    }
+
+}
+
+int LuaStateQueue::benchmark(lua_State *L)
+{
+    int messages = static_cast<int>(luaL_optinteger(L, 1, 20000));
+    int producers = static_cast<int>(luaL_optinteger(L, 2, 2));
+    if(messages < 1) messages = 1;
+    if(producers < 1) producers = 1;
+
+    static const int payload_sizes[] = { 16, 256, 4096, 65536 };
+
+    lua_newtable(L);
+    int results = lua_gettop(L);
+    for(size_t s = 0; s < sizeof(payload_sizes)/sizeof(payload_sizes[0]); s++)
+    {
+        LuaStateQueue q("benchmark");
+        std::vector<BenchmarkProducer> params(producers);
+        std::vector<SDL_Thread*> threads(producers);
+
+        Uint64 start = SDL_GetPerformanceCounter();
+        for(int i = 0; i < producers; i++)
+        {
+            params[i].q = &q;
+            params[i].payload_size = payload_sizes[s];
+            params[i].messages = messages / producers;
+            params[i].full = 0;
+            threads[i] = SDL_CreateThread(benchmark_producer, "LSQ benchmark", &params[i]);
+            if(not threads[i]) { LSQ_abort("create benchmark thread"); }
+        }
+
+        // consume on this thread, into the calling state, like a real reader
+        int expected = (messages / producers) * producers;
+        for(int i = 0; i < expected; i++)
+        {
+            LuaMessage* m = q.pop_wait(SDL_MUTEX_MAXWAIT);
+            m->decode(L);
+            lua_pop(L, 1);
+            m->release();
+        }
+        Uint64 end = SDL_GetPerformanceCounter();
+
+        int full = 0;
+        for(int i = 0; i < producers; i++)
+        {
+            SDL_WaitThread(threads[i], 0);
+            full += params[i].full;
+        }
+
+        double seconds = double(end - start) / SDL_GetPerformanceFrequency();
+        double rate = seconds > 0 ? expected / seconds : 0;
+        Utilities::debugMessage("LuaStateQueue benchmark: %d byte payload, %d producers, %.0f messages/s (queue full %d times)",
+                                payload_sizes[s], producers, rate, full);
+
+        lua_pushnumber(L, rate);
+        lua_rawseti(L, results, payload_sizes[s]);
+    }
+    return 1;
+}
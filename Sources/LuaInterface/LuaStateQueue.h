@@ -33,63 +33,98 @@
 
 #include "SDL.h"
 #include <string>
-#include <queue>
+#include <vector>
 #include "lua.h"
 
-namespace luabridge
-{
-    class LuaRef;
-};
-
-class GenericLuaTypeStore;
-
-#define THREADSAFE_LUASTATEQUEUE 1
-
+class LuaMessage;
+class LuaQueueWaiter;
 
 // Single consumer, multiple producers
+//
+// Messages are serialized into a single LuaMessage buffer (from a recycled pool)
+// and passed through a bounded lock-free ring. Producers never take a lock unless
+// the consumer is asleep waiting for something to arrive.
+//
+// A reader sleeps on its thread's LuaQueueWaiter, which lets select() wait on
+// several queues at once.
+//
+// If the ring is full send() waits for space (backpressure), try_send() just
+// returns false.
 class LuaStateQueue {
 public:
     LuaStateQueue(std::string identifier_name);
     ~LuaStateQueue();
     void send(lua_State* Lua_object);
+    bool try_send(lua_State* Lua_object);
     
-    // Make it so any LuaState can read ... but only the owner should read.
-    // We can enforce it using the dervied class below, but we don't so that
-    // running everything from a single state is easier (for debugging).
+    // Only one reader at a time. head (the consumer's end of the ring) and
+    // the waiter pointer aren't safe with two threads reading, so don't
+    // read (or select() on) a queue from more than one thread at once - hand
+    // the queue to a single owner. Several LuaStates on the same thread are
+    // fine, which keeps running everything from a single thread easy (for
+    // debugging).
     
     // thread-version will block if queue is empty...
     int read(lua_State *L);
     int read_timeout(lua_State *L);
     
-    // this one will return nil if nothing is available
-    //int try_read(lua_State *L);
-    
     bool is_empty();
     std::string get_identifier();
+    int get_capacity() { return mask + 1; }
+    int get_full_count();      // number of times a sender found the queue full
+    int get_depth();           // messages waiting, approximate, any thread can ask
+
+    // select({queue1, queue2, ...}, [timeout_ms])
+    // waits for any of the queues to have a message, returns its identifier
+    // and the message, or nil if it timed out.
+    static int select(lua_State *L);
+
+    // native side of the queue
+    bool push(LuaMessage* m);               // false if full, caller still owns m
+    LuaMessage* pop();                      // 0 if empty
+    LuaMessage* pop_wait(Uint32 ms);        // 0 if timed out
+    // returns the queue that m came from, or 0 if it timed out
+    static LuaStateQueue* select(LuaStateQueue** queues, int count, Uint32 ms, LuaMessage*& m);
+
+    // benchmark(messages_per_size, producers)
+    // returns a table of payload size -> messages per second
+    static int benchmark(lua_State *L);
+
+    // every queue currently alive, for the metrics. Hold the lock while
+    // looking at the list.
+    static void lock_list();
+    static void unlock_list();
+    static const std::vector<LuaStateQueue*>& get_list();
     
 private:
-    std::queue<GenericLuaTypeStore*> q;
-    std::string id;
+    // lets not have these copy constructed or assigned
+    LuaStateQueue(const LuaStateQueue&);
+    LuaStateQueue& operator=(const LuaStateQueue&);
 
-#if THREADSAFE_LUASTATEQUEUE
-    SDL_mutex* q_protect;
-    SDL_cond* data_available_cond;
-#endif
+    void wake_consumer();
 
-    
-#if 0
-//protected:
-//    // functions for our Lua state
-//    void get(std::string destination, LuaRef Lua_object);   // should this be non-blocking?
-//    bool is_empty();
-//};
-//
-//class LuaStateQueueOwned : public LuaStateQueue {
-//public:
-//    void read();
-//    bool is_empty();
-#endif
+    // Bounded queue after Dmitry Vyukov's - each slot has a sequence number
+    // that says whether it's ready to be written or read on this lap.
+    struct Slot {
+        SDL_atomic_t sequence;
+        LuaMessage* message;
+    };
+    std::vector<Slot> ring;
+    int mask;
+
+    // keep the producer and consumer ends on different cache lines
+    char pad0[64];
+    SDL_atomic_t tail;          // next slot for producers
+    char pad1[64];
+    int head;                   // next slot for the consumer, only the consumer touches this
+    char pad2[64];
+
+    std::string id;
+
+    SDL_atomic_t full_count;
 
+    // the LuaQueueWaiter of a reader that's waiting on us, or 0
+    void* waiter;
 };
 
 
@@ -0,0 +1,64 @@
+/*
+ * LuaUserdata.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#ifndef LUAUSERDATA_H_
+#define LUAUSERDATA_H_
+
+#include "lua.h"
+#include "lauxlib.h"
+#include "LuaBridge.h"
+#ifdef _MSC_VER
+#include <ciso646>   // Visual Studio is not C++ standards complaint...
+#endif
+
+// The LuaBridge object of class T at index, or 0 if it's anything else.
+//
+// luabridge::Userdata::get raises a Lua error for the wrong type, which is no
+// good for arguments that can be one of several things (a string or a
+// GlyphArray, a table or a DrawStyle...). This only matches T exactly, not
+// derived classes.
+template <class T> T* luabridge_userdata_if(lua_State* L, int index)
+{
+    index = lua_absindex(L, index);     // Userdata::get only takes positive indexes
+    if(not lua_isuserdata(L, index) or not lua_getmetatable(L, index)) return 0;
+    lua_rawgetp(L, LUA_REGISTRYINDEX, luabridge::ClassInfo<T>::getClassKey());
+    bool match = lua_rawequal(L, -1, -2);
+    if(not match)
+    {
+        lua_pop(L, 1);
+        lua_rawgetp(L, LUA_REGISTRYINDEX, luabridge::ClassInfo<T>::getConstKey());
+        match = lua_rawequal(L, -1, -2);
+    }
+    lua_pop(L, 2);
+    return match ? luabridge::Userdata::get<T>(L, index, true) : 0;
+}
+
+#endif /* LUAUSERDATA_H_ */
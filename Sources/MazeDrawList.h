@@ -35,6 +35,7 @@
 #include "MyGraphics.h"
 #include <list>
 #include <vector>
+#include "ElementPool.h"
 
 // here and not in PresentationMaze.h to avoid circular includes
 // should really stick this in its own header file
@@ -47,7 +48,8 @@ enum render_option
 };
 
 class MazeDrawListElement;
-typedef std::list<MazeDrawListElement*>::iterator mdl_iterator;
+typedef std::list<MazeDrawListElement*, PoolAllocator<MazeDrawListElement*, md_pool_tag> > mdl_list_t;
+typedef mdl_list_t::iterator mdl_iterator;
 
 class MazeDrawList
 {
@@ -74,7 +76,7 @@ public:
 	void set_render_option(render_option ro);
 
 private:
-	std::list<MazeDrawListElement*> maze_draw_list;
+	mdl_list_t maze_draw_list;
 	bool _render_empty_draw_list_as_space;
 };
 
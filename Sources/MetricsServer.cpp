@@ -0,0 +1,705 @@
+/*
+ * MetricsServer.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#include "MetricsServer.h"
+#include "Debug.h"
+#include "HitchDetector.h"
+#include "MyGraphics.h"
+#include "TextLayoutCache.h"
+#include "AllocationTracker.h"
+#include "LuaAllocator.h"
+#include "LuaStateQueue.h"
+#include "LuaJobSystem.h"
+#include "LuaCppInterface.h"
+#include "lua.h"
+#include "lauxlib.h"
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#ifdef _WIN32
+	#include <winsock2.h>
+	#include <ws2tcpip.h>
+	#ifdef _MSC_VER
+		#pragma comment(lib, "Ws2_32.lib")
+	#endif
+#else
+	#include <sys/types.h>
+	#include <sys/socket.h>
+	#include <sys/stat.h>
+	#include <sys/un.h>
+	#include <netinet/in.h>
+	#include <arpa/inet.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <errno.h>
+#endif
+#ifdef _MSC_VER
+#include <ciso646>   // Visual Studio is not C++ standards complaint...
+#endif
+
+// scrapers that connect at the same time (more wait in the listen backlog)
+static const size_t max_connections = 8;
+// a request bigger than this isn't a scrape
+static const size_t max_request_bytes = 8192;
+// drop connections that haven't finished by now
+static const Uint32 connection_timeout_ms = 5000;
+
+#ifdef _WIN32
+typedef SOCKET socket_t;
+static const socket_t no_socket = INVALID_SOCKET;
+static void close_socket(socket_t s) { closesocket(s); }
+static bool would_block() { return WSAGetLastError() == WSAEWOULDBLOCK; }
+static bool set_non_blocking(socket_t s) { u_long on = 1; return ioctlsocket(s, FIONBIO, &on) == 0; }
+#else
+typedef int socket_t;
+static const socket_t no_socket = -1;
+static void close_socket(socket_t s) { close(s); }
+static bool would_block() { return errno == EAGAIN or errno == EWOULDBLOCK or errno == EINTR; }
+static bool set_non_blocking(socket_t s) { int flags = fcntl(s, F_GETFL, 0); return flags != -1 and fcntl(s, F_SETFL, flags | O_NONBLOCK) != -1; }
+#endif
+
+// a closed scraper shouldn't kill the game with SIGPIPE
+#if defined(MSG_NOSIGNAL)
+static const int send_flags = MSG_NOSIGNAL;
+#else
+static const int send_flags = 0;
+#endif
+
+static void no_sigpipe(socket_t s)
+{
+#ifdef SO_NOSIGPIPE
+	int on = 1;
+	setsockopt(s, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#else
+	(void)s;
+#endif
+}
+
+struct MetricsConnection
+{
+	socket_t fd;
+	std::string request;
+	std::string response;
+	size_t sent;
+	Uint32 opened;
+	bool responding;
+};
+
+struct UserMetric
+{
+	UserMetric() : counter(false), value(0) {}
+	bool counter;
+	double value;
+	std::string help;
+};
+
+static std::vector<MetricsConnection>& connections()
+{
+	static std::vector<MetricsConnection>* list = new std::vector<MetricsConnection>;
+	return *list;
+}
+
+// user metrics can come from any Lua state
+static SDL_SpinLock user_metrics_lock = 0;
+static std::map<std::string, UserMetric>& user_metrics()
+{
+	static std::map<std::string, UserMetric>* metrics = new std::map<std::string, UserMetric>;	// never deleted, states can outlive statics
+	return *metrics;
+}
+
+// what poll() was last given, for Lua's snapshot()
+static MyGraphics* last_graphics = 0;
+
+intptr_t MetricsServer::listener = -1;
+std::string MetricsServer::unix_path;
+
+
+//
+// Prometheus text format
+//
+
+static void format_value(std::string& out, double value)
+{
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%.15g", value);
+	out += buffer;
+}
+
+// HELP text escapes backslash and newline, label values also escape quotes
+static void append_escaped(std::string& out, const std::string& s, bool quotes)
+{
+	for(size_t i = 0; i < s.size(); i++)
+	{
+		char c = s[i];
+		if(c == '\\') out += "\\\\";
+		else if(c == '\n') out += "\\n";
+		else if(c == '"' and quotes) out += "\\\"";
+		else out += c;
+	}
+}
+
+static void family(std::string& out, const char* name, const char* type, const std::string& help)
+{
+	out += "# HELP ";
+	out += name;
+	out += ' ';
+	append_escaped(out, help, false);
+	out += "\n# TYPE ";
+	out += name;
+	out += ' ';
+	out += type;
+	out += '\n';
+}
+
+static void sample(std::string& out, const char* name, double value, const char* label = 0, const std::string& label_value = "")
+{
+	out += name;
+	if(label)
+	{
+		out += '{';
+		out += label;
+		out += "=\"";
+		append_escaped(out, label_value, true);
+		out += "\"}";
+	}
+	out += ' ';
+	format_value(out, value);
+	out += '\n';
+}
+
+static void single(std::string& out, const char* name, const char* type, const char* help, double value)
+{
+	family(out, name, type, help);
+	sample(out, name, value);
+}
+
+// two queues (say) can have the same name, but series must be unique
+static std::string unique_label(std::map<std::string, int>& seen, const std::string& name)
+{
+	int n = ++seen[name];
+	if(n == 1) return name;
+	char buffer[16];
+	snprintf(buffer, sizeof(buffer), "#%d", n);
+	return name + buffer;
+}
+
+std::string MetricsServer::snapshot(MyGraphics* graphics)
+{
+	std::string out;
+	out.reserve(4096);
+
+	single(out, "ff_uptime_seconds", "gauge", "Seconds since SDL started.", SDL_GetTicks() / 1000.0);
+
+	HitchDetector* hitches = debug.hitches();
+	single(out, "ff_frames_total", "counter", "Frames run.", hitches->get_frame_count());
+	family(out, "ff_frame_time_ms", "gauge", "Frame time percentiles over the last few seconds.");
+	sample(out, "ff_frame_time_ms", hitches->get_p50(), "quantile", "0.5");
+	sample(out, "ff_frame_time_ms", hitches->get_p95(), "quantile", "0.95");
+	sample(out, "ff_frame_time_ms", hitches->get_p99(), "quantile", "0.99");
+	single(out, "ff_frame_budget_ms", "gauge", "Frames longer than this are hitches.", hitches->get_budget());
+	single(out, "ff_hitches_total", "counter", "Frames over budget.", hitches->get_hitch_count());
+
+	if(graphics)
+	{
+		single(out, "ff_draw_calls_total", "counter", "SDL render calls.", static_cast<double>(graphics->draw_call_count()));
+		single(out, "ff_texture_bytes", "gauge", "Estimated glyph texture memory.", static_cast<double>(graphics->texture_bytes()));
+		TextLayoutCache* layouts = graphics->get_text_layout_cache();
+		single(out, "ff_text_layout_hits_total", "counter", "print_string layouts found in the cache.", static_cast<double>(layouts->get_hits()));
+		single(out, "ff_text_layout_misses_total", "counter", "print_string layouts worked out again.", static_cast<double>(layouts->get_misses()));
+		single(out, "ff_text_layout_entries", "gauge", "Layouts in the cache.", layouts->get_entry_count());
+	}
+	single(out, "ff_draw_list_elements", "gauge", "DrawListElements alive.", debug.get_dle_count());
+	single(out, "ff_maze_data", "gauge", "MazeData objects alive.", debug.get_md_count());
+	single(out, "ff_lua_threads", "gauge", "LuaThreads still running.", running_lua_thread_count());
+
+	{
+		std::map<std::string, int> seen;
+		std::string heap, peak, allocations;
+		family(heap, "ff_lua_heap_bytes", "gauge", "Lua heap per state.");
+		family(peak, "ff_lua_heap_peak_bytes", "gauge", "Largest Lua heap per state.");
+		family(allocations, "ff_lua_allocations_total", "counter", "Lua allocations per state.");
+		LuaAllocator::lock_list();
+		const std::vector<LuaAllocator*>& list = LuaAllocator::get_list();
+		for(size_t i = 0; i < list.size(); i++)
+		{
+			std::string state = unique_label(seen, list[i]->get_name());
+			sample(heap, "ff_lua_heap_bytes", static_cast<double>(list[i]->get_bytes()), "state", state);
+			sample(peak, "ff_lua_heap_peak_bytes", static_cast<double>(list[i]->get_peak_bytes()), "state", state);
+			sample(allocations, "ff_lua_allocations_total", static_cast<double>(list[i]->get_allocation_count()), "state", state);
+		}
+		LuaAllocator::unlock_list();
+		out += heap + peak + allocations;
+	}
+
+	{
+		std::map<std::string, int> seen;
+		std::string depth, capacity, full;
+		family(depth, "ff_queue_depth", "gauge", "Messages waiting in each LuaStateQueue.");
+		family(capacity, "ff_queue_capacity", "gauge", "Size of each LuaStateQueue.");
+		family(full, "ff_queue_full_total", "counter", "Times a sender found the queue full.");
+		LuaStateQueue::lock_list();
+		const std::vector<LuaStateQueue*>& list = LuaStateQueue::get_list();
+		for(size_t i = 0; i < list.size(); i++)
+		{
+			std::string queue = unique_label(seen, list[i]->get_identifier());
+			sample(depth, "ff_queue_depth", list[i]->get_depth(), "queue", queue);
+			sample(capacity, "ff_queue_capacity", list[i]->get_capacity(), "queue", queue);
+			sample(full, "ff_queue_full_total", list[i]->get_full_count(), "queue", queue);
+		}
+		LuaStateQueue::unlock_list();
+		out += depth + capacity + full;
+	}
+
+	{
+		std::string workers, pending, steals;
+		family(workers, "ff_job_workers", "gauge", "Worker threads per LuaJobSystem.");
+		family(pending, "ff_job_pending", "gauge", "Jobs submitted but not finished.");
+		family(steals, "ff_job_steals_total", "counter", "Jobs taken from another worker.");
+		LuaJobSystem::lock_list();
+		const std::vector<LuaJobSystem*>& list = LuaJobSystem::get_list();
+		for(size_t i = 0; i < list.size(); i++)
+		{
+			char system[16];
+			snprintf(system, sizeof(system), "%d", static_cast<int>(i));
+			sample(workers, "ff_job_workers", list[i]->get_worker_count(), "system", system);
+			sample(pending, "ff_job_pending", list[i]->get_pending(), "system", system);
+			sample(steals, "ff_job_steals_total", list[i]->get_steal_count(), "system", system);
+		}
+		LuaJobSystem::unlock_list();
+		out += workers + pending + steals;
+	}
+
+	if(AllocationTracker::active())
+	{
+		AllocationTracker::Totals t = AllocationTracker::totals();
+		AllocationTracker::Totals sdl = AllocationTracker::sdl_totals();
+		single(out, "ff_heap_allocations_total", "counter", "C++ heap allocations, all threads.", static_cast<double>(t.allocations));
+		single(out, "ff_heap_frees_total", "counter", "C++ heap frees, all threads.", static_cast<double>(t.frees));
+		single(out, "ff_heap_live_bytes", "gauge", "C++ heap in use.", static_cast<double>(t.bytes_allocated - t.bytes_freed));
+		single(out, "ff_sdl_heap_allocations_total", "counter", "SDL_malloc allocations.", static_cast<double>(sdl.allocations));
+		single(out, "ff_sdl_heap_live_bytes", "gauge", "SDL heap in use.", static_cast<double>(sdl.bytes_allocated - sdl.bytes_freed));
+		single(out, "ff_frame_allocations", "gauge", "C++ heap allocations in the last frame.", static_cast<double>(AllocationTracker::last_frame().allocations));
+	}
+
+	SDL_AtomicLock(&user_metrics_lock);
+	std::map<std::string, UserMetric>& metrics = user_metrics();
+	for(std::map<std::string, UserMetric>::const_iterator it = metrics.begin(); it != metrics.end(); ++it)
+	{
+		const UserMetric& m = it->second;
+		single(out, it->first.c_str(), m.counter ? "counter" : "gauge", m.help.empty() ? "From Lua." : m.help.c_str(), m.value);
+	}
+	SDL_AtomicUnlock(&user_metrics_lock);
+
+	return out;
+}
+
+
+//
+// User metrics
+//
+
+bool MetricsServer::valid_name(const std::string& name)
+{
+	if(name.empty()) return false;
+	for(size_t i = 0; i < name.size(); i++)
+	{
+		char c = name[i];
+		bool ok = (c >= 'a' and c <= 'z') or (c >= 'A' and c <= 'Z') or c == '_' or c == ':' or (i > 0 and c >= '0' and c <= '9');
+		if(not ok) return false;
+	}
+	return true;
+}
+
+void MetricsServer::set_gauge(const std::string& name, double value, const std::string& help)
+{
+	SDL_AtomicLock(&user_metrics_lock);
+	UserMetric& m = user_metrics()[name];
+	m.counter = false;
+	m.value = value;
+	if(not help.empty()) m.help = help;
+	SDL_AtomicUnlock(&user_metrics_lock);
+}
+
+double MetricsServer::add_counter(const std::string& name, double delta, const std::string& help)
+{
+	SDL_AtomicLock(&user_metrics_lock);
+	UserMetric& m = user_metrics()[name];
+	if(not m.counter)
+	{
+		// new, or was a gauge
+		m.counter = true;
+		m.value = 0;
+	}
+	m.value += delta;
+	if(not help.empty()) m.help = help;
+	double total = m.value;
+	SDL_AtomicUnlock(&user_metrics_lock);
+	return total;
+}
+
+void MetricsServer::remove(const std::string& name)
+{
+	SDL_AtomicLock(&user_metrics_lock);
+	user_metrics().erase(name);
+	SDL_AtomicUnlock(&user_metrics_lock);
+}
+
+
+//
+// Server
+//
+
+bool MetricsServer::listening()
+{
+	return listener != -1;
+}
+
+bool MetricsServer::start(const std::string& where, const std::string& address, std::string& error)
+{
+	stop();
+
+#ifdef _WIN32
+	WSADATA wsa;
+	if(WSAStartup(MAKEWORD(2, 2), &wsa) != 0)
+	{
+		error = "couldn't start Winsock";
+		return false;
+	}
+#endif
+
+	socket_t s = no_socket;
+	if(where.compare(0, 5, "unix:") == 0)
+	{
+#ifdef _WIN32
+		error = "Unix sockets aren't supported on Windows";
+#else
+		std::string path = where.substr(5);
+		sockaddr_un sa;
+		memset(&sa, 0, sizeof(sa));
+		sa.sun_family = AF_UNIX;
+		struct stat st;
+		if(path.empty() or path.size() >= sizeof(sa.sun_path))
+		{
+			error = "bad socket path " + path;
+		}
+		else if(lstat(path.c_str(), &st) == 0 and not S_ISSOCK(st.st_mode))
+		{
+			error = path + " already exists and isn't a socket";
+		}
+		else
+		{
+			strcpy(sa.sun_path, path.c_str());
+			unlink(path.c_str());	// a socket left over from last time (if anything)
+			s = socket(AF_UNIX, SOCK_STREAM, 0);
+			if(s == no_socket or bind(s, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) != 0)
+			{
+				error = "couldn't bind " + path;
+			}
+			else
+			{
+				unix_path = path;
+			}
+		}
+#endif
+	}
+	else
+	{
+		char* end = 0;
+		long port = strtol(where.c_str(), &end, 10);
+		sockaddr_in sa;
+		memset(&sa, 0, sizeof(sa));
+		sa.sin_family = AF_INET;
+		sa.sin_port = htons(static_cast<unsigned short>(port));
+		const char* ip = (address.empty() or address == "localhost") ? "127.0.0.1" : address.c_str();
+		if(where.empty() or *end != 0 or port <= 0 or port > 65535)
+		{
+			error = "bad port " + where;
+		}
+		else if(inet_pton(AF_INET, ip, &sa.sin_addr) != 1)
+		{
+			error = std::string("bad address ") + ip;
+		}
+		else if((ntohl(sa.sin_addr.s_addr) >> 24) != 127)
+		{
+			// there's no authentication, so this is not for the outside world
+			error = std::string("won't listen on ") + ip + " - only on loopback (127.x.x.x)";
+		}
+		else
+		{
+			s = socket(AF_INET, SOCK_STREAM, 0);
+			int on = 1;
+			if(s != no_socket)
+			{
+				setsockopt(s, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&on), sizeof(on));
+			}
+			if(s == no_socket or bind(s, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) != 0)
+			{
+				error = "couldn't bind " + std::string(ip) + ":" + where;
+			}
+		}
+	}
+
+	if(error.empty() and (listen(s, 16) != 0 or not set_non_blocking(s)))
+	{
+		error = "couldn't listen on " + where;
+	}
+	if(not error.empty())
+	{
+		if(s != no_socket) close_socket(s);
+		if(not unix_path.empty())
+		{
+#ifndef _WIN32
+			unlink(unix_path.c_str());
+#endif
+			unix_path.clear();
+		}
+#ifdef _WIN32
+		WSACleanup();
+#endif
+		return false;
+	}
+
+	listener = static_cast<intptr_t>(s);
+	return true;
+}
+
+void MetricsServer::close_all()
+{
+	std::vector<MetricsConnection>& list = connections();
+	for(size_t i = 0; i < list.size(); i++)
+	{
+		close_socket(list[i].fd);
+	}
+	list.clear();
+}
+
+void MetricsServer::stop()
+{
+	if(not listening()) return;
+
+	close_all();
+	close_socket(static_cast<socket_t>(listener));
+	listener = -1;
+#ifndef _WIN32
+	if(not unix_path.empty())
+	{
+		unlink(unix_path.c_str());
+	}
+#else
+	WSACleanup();
+#endif
+	unix_path.clear();
+}
+
+void MetricsServer::accept_connections()
+{
+	std::vector<MetricsConnection>& list = connections();
+	while(list.size() < max_connections)
+	{
+		socket_t s = accept(static_cast<socket_t>(listener), 0, 0);
+		if(s == no_socket) return;		// nothing waiting (or an error we'll see again next frame)
+		if(not set_non_blocking(s))
+		{
+			close_socket(s);
+			continue;
+		}
+		no_sigpipe(s);
+		MetricsConnection c;
+		c.fd = s;
+		c.sent = 0;
+		c.opened = SDL_GetTicks();
+		c.responding = false;
+		list.push_back(c);
+	}
+}
+
+static std::string respond(const std::string& request, MyGraphics* graphics)
+{
+	// only the request line matters, e.g. "GET /metrics HTTP/1.1"
+	std::string line = request.substr(0, request.find_first_of("\r\n"));
+	std::string status = "200 OK";
+	std::string body;
+	if(line.compare(0, 4, "GET ") != 0)
+	{
+		status = "405 Method Not Allowed";
+	}
+	else
+	{
+		std::string path = line.substr(4, line.find(' ', 4) - 4);
+		if(path == "/" or path == "/metrics")
+		{
+			body = MetricsServer::snapshot(graphics);
+		}
+		else
+		{
+			status = "404 Not Found";
+		}
+	}
+	char length[32];
+	snprintf(length, sizeof(length), "%d", static_cast<int>(body.size()));
+	return "HTTP/1.0 " + status + "\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\nContent-Length: " + length + "\r\nConnection: close\r\n\r\n" + body;
+}
+
+// false when it's finished with (sent, failed or timed out)
+static bool service(MetricsConnection& c, MyGraphics* graphics)
+{
+	if(SDL_GetTicks() - c.opened > connection_timeout_ms) return false;
+
+	if(not c.responding)
+	{
+		char buffer[1024];
+		for(;;)
+		{
+			int got = static_cast<int>(recv(c.fd, buffer, sizeof(buffer), 0));
+			if(got == 0) return false;					// they gave up
+			if(got < 0)
+			{
+				if(would_block()) break;
+				return false;
+			}
+			c.request.append(buffer, got);
+			if(c.request.size() > max_request_bytes) return false;
+		}
+		if(c.request.find("\r\n\r\n") == std::string::npos and c.request.find("\n\n") == std::string::npos)
+		{
+			return true;		// not all here yet
+		}
+		c.response = respond(c.request, graphics);
+		c.responding = true;
+	}
+
+	while(c.sent < c.response.size())
+	{
+		int sent = static_cast<int>(send(c.fd, c.response.data() + c.sent, static_cast<int>(c.response.size() - c.sent), send_flags));
+		if(sent < 0)
+		{
+			return would_block();
+		}
+		c.sent += sent;
+	}
+	return false;
+}
+
+void MetricsServer::poll(MyGraphics* graphics)
+{
+	if(listener == -1) return;
+
+	last_graphics = graphics;
+	accept_connections();
+
+	std::vector<MetricsConnection>& list = connections();
+	for(size_t i = 0; i < list.size(); )
+	{
+		if(service(list[i], graphics))
+		{
+			i++;
+		}
+		else
+		{
+			close_socket(list[i].fd);
+			list.erase(list.begin() + i);
+		}
+	}
+}
+
+
+//
+// Lua
+//
+
+int MetricsServer::lua_start(lua_State* L)
+{
+	std::string where = lua_type(L, 1) == LUA_TNUMBER ? std::string(lua_tostring(L, 1)) : std::string(luaL_checkstring(L, 1));
+	std::string address = luaL_optstring(L, 2, "127.0.0.1");
+	std::string error;
+	if(not start(where, address, error))
+	{
+		lua_pushnil(L);
+		lua_pushstring(L, error.c_str());
+		return 2;
+	}
+	lua_pushboolean(L, 1);
+	return 1;
+}
+
+int MetricsServer::lua_stop(lua_State* L)
+{
+	(void)L;
+	stop();
+	return 0;
+}
+
+int MetricsServer::lua_listening(lua_State* L)
+{
+	lua_pushboolean(L, listening());
+	return 1;
+}
+
+static std::string check_metric_name(lua_State* L, const char* function)
+{
+	std::string name = luaL_checkstring(L, 1);
+	if(not MetricsServer::valid_name(name))
+	{
+		luaL_error(L, "MetricsServer.%s - '%s' isn't a valid metric name", function, name.c_str());
+	}
+	return name;
+}
+
+int MetricsServer::lua_gauge(lua_State* L)
+{
+	std::string name = check_metric_name(L, "gauge");
+	set_gauge(name, luaL_checknumber(L, 2), luaL_optstring(L, 3, ""));
+	return 0;
+}
+
+int MetricsServer::lua_counter(lua_State* L)
+{
+	std::string name = check_metric_name(L, "counter");
+	double delta = luaL_optnumber(L, 2, 1);
+	if(delta < 0)
+	{
+		return luaL_error(L, "MetricsServer.counter - counters only go up");
+	}
+	lua_pushnumber(L, add_counter(name, delta, luaL_optstring(L, 3, "")));
+	return 1;
+}
+
+int MetricsServer::lua_remove(lua_State* L)
+{
+	remove(luaL_checkstring(L, 1));
+	return 0;
+}
+
+int MetricsServer::lua_snapshot(lua_State* L)
+{
+	lua_pushstring(L, snapshot(last_graphics).c_str());
+	return 1;
+}
@@ -0,0 +1,104 @@
+/*
+ * MetricsServer.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include "SDL.h"
+#include <string>
+#include <map>
+#include <vector>
+#ifdef _MSC_VER
+#include <ciso646>   // Visual Studio is not C++ standards complaint...
+#endif
+struct lua_State;
+class MyGraphics;
+
+// Serves the engine counters as Prometheus text (version 0.0.4) over HTTP, so
+// a soak test or a dashboard can watch a running game without the overlay.
+//
+// It's off until start() is called, and then listens on 127.0.0.1 (or
+// another loopback address - anything else is refused, as there's no
+// authentication) or on a Unix domain socket. All the socket work is
+// non-blocking and done from poll() in the main loop, so there's no thread,
+// and a stopped server costs one test per frame.
+//
+// Served: frames, frame time percentiles and hitches (HitchDetector), draw
+// calls, draw list elements and maze data, Lua heap per state, queue depths,
+// job system workers/pending/steals, running LuaThreads, heap allocations and
+// texture memory (AllocationTracker), plus anything Lua adds.
+//
+// From Lua:
+//		MetricsServer.start(9100, ["127.0.0.1"]) or start("unix:/tmp/game.sock")
+//			returns true, or nil and an error message
+//		MetricsServer.stop(), MetricsServer.listening()
+//		MetricsServer.gauge(name, value, [help])
+//		MetricsServer.counter(name, [delta=1], [help]) - returns the new total
+//		MetricsServer.remove(name)
+//		MetricsServer.snapshot() - the text a scrape would get
+// gauge/counter/remove can be called from any Lua state; start, stop and
+// snapshot are for the main thread.
+class MetricsServer
+{
+public:
+	static bool start(const std::string& where, const std::string& address, std::string& error);
+	static void stop();
+	static bool listening();
+
+	// from the main loop, every frame. graphics can be 0.
+	static void poll(MyGraphics* graphics);
+
+	static std::string snapshot(MyGraphics* graphics);
+
+	// metrics from Lua (or anywhere else)
+	static void set_gauge(const std::string& name, double value, const std::string& help);
+	static double add_counter(const std::string& name, double delta, const std::string& help);
+	static void remove(const std::string& name);
+	static bool valid_name(const std::string& name);
+
+	// for Lua
+	static int lua_start(lua_State* L);
+	static int lua_stop(lua_State* L);
+	static int lua_listening(lua_State* L);
+	static int lua_gauge(lua_State* L);
+	static int lua_counter(lua_State* L);
+	static int lua_remove(lua_State* L);
+	static int lua_snapshot(lua_State* L);
+
+private:
+	static void accept_connections();
+	static void close_all();
+
+	static intptr_t listener;		// a SOCKET on Windows, -1 when stopped
+	static std::string unix_path;	// to remove when we stop
+};
+
+#endif
@@ -33,6 +33,12 @@
 #include "GameToScreenMapping.h"
 #include <cstring>
 #include "Utilities.h"
+#include "GlyphArray.h"
+#include "LuaUserdata.h"
+#include <vector>
+#ifdef _MSC_VER
+#include <ciso646>   // Visual Studio is not C++ standards complaint...
+#endif
 
 using Utilities::utf8_to_int_helper;
 
@@ -76,25 +82,135 @@ void print_cstring(MyGraphics* gr, const char* string)
 	// check for invalid string
 	if(!string) { return; }
 
-	int c;
-	const unsigned char* ustr = (const unsigned char*)(string); // make unsigned
-	while((c = *ustr))
+	gr->print_text(string, std::strlen(string));
+}
+
+//
+// print_run from Lua
+//
+
+static SDL_Colour colour_from_lua(lua_State* L, int index, int arg)
+{
+	if(lua_type(L, index) == LUA_TNUMBER)
 	{
-		ustr ++;
-		
-		if(c >= 0x80)
+		int n = static_cast<int>(lua_tointeger(L, index));
+		if(n < 0 or n >= number_of_colours) { luaL_argerror(L, arg, "not a colour"); }
+		return get_rgb_from_simple_colour(simple_colour_t(n));
+	}
+	SDL_Colour* c = luabridge_userdata_if<SDL_Colour>(L, index);
+	if(not c) { luaL_argerror(L, arg, "expected a simple colour or SDL_Color"); }
+	return *c;
+}
+
+static void colours_from_lua(lua_State* L, int arg, std::vector<SDL_Colour>& out)
+{
+	out.clear();
+	if(lua_isnoneornil(L, arg)) return;
+
+	if(lua_istable(L, arg))
+	{
+		int n = static_cast<int>(lua_rawlen(L, arg));
+		for(int i = 1; i <= n; i++)
 		{
-			int len = utf8_to_int_helper(&c, ustr);
-			if(len <= 0)	// we don't process errors at all
-			{
-				gr->print('?');	// show error
-				break;	// get out, don't parse or print more (we could recover here, but we don't).
-			}
-			ustr += len;
+			lua_rawgeti(L, arg, i);
+			out.push_back(colour_from_lua(L, -1, arg));
+			lua_pop(L, 1);
+		}
+	}
+	else if(GlyphArray* a = luabridge_userdata_if<GlyphArray>(L, arg))
+	{
+		const Uint32* packed = a->data();
+		for(int i = 0; i < a->size(); i++)
+		{
+			out.push_back(GlyphArray::unpack_colour(packed[i]));
+		}
+	}
+	else
+	{
+		out.push_back(colour_from_lua(L, arg, arg));
+	}
+}
+
+static void attributes_from_lua(lua_State* L, int arg, std::vector<Uint8>& out)
+{
+	out.clear();
+	if(lua_isnoneornil(L, arg)) return;
+
+	if(lua_type(L, arg) == LUA_TNUMBER)
+	{
+		out.push_back(static_cast<Uint8>(lua_tointeger(L, arg)));
+	}
+	else if(lua_istable(L, arg))
+	{
+		int n = static_cast<int>(lua_rawlen(L, arg));
+		for(int i = 1; i <= n; i++)
+		{
+			lua_rawgeti(L, arg, i);
+			out.push_back(static_cast<Uint8>(lua_tointeger(L, -1)));
+			lua_pop(L, 1);
 		}
+	}
+	else if(GlyphArray* a = luabridge_userdata_if<GlyphArray>(L, arg))
+	{
+		const Uint32* values = a->data();
+		for(int i = 0; i < a->size(); i++)
+		{
+			out.push_back(static_cast<Uint8>(values[i]));
+		}
+	}
+	else
+	{
+		luaL_argerror(L, arg, "expected a number, table or GlyphArray");
+	}
+}
+
+void glyph_run_from_lua(lua_State* L, int first_arg, GlyphRun& run)
+{
+	// drawing is main thread only, so these can be reused between calls
+	static std::vector<Uint32> characters;
+	static std::vector<SDL_Colour> fg;
+	static std::vector<SDL_Colour> bg;
+	static std::vector<Uint8> attributes;
+
+	run = GlyphRun();
+	if(lua_type(L, first_arg) == LUA_TSTRING)
+	{
+		size_t length = 0;
+		const char* s = lua_tolstring(L, first_arg, &length);
+		characters.clear();
+		GlyphArray::decode_utf8(s, length, characters);
+		run.characters = characters.empty() ? 0 : &characters[0];
+		run.count = static_cast<int>(characters.size());
+	}
+	else if(GlyphArray* a = luabridge_userdata_if<GlyphArray>(L, first_arg))
+	{
+		run.characters = a->data();
+		run.count = a->size();
+	}
+	else
+	{
+		luaL_argerror(L, first_arg, "expected a string or GlyphArray");
+	}
 
-		gr->print(c);
+	colours_from_lua(L, first_arg+1, fg);
+	colours_from_lua(L, first_arg+2, bg);
+	attributes_from_lua(L, first_arg+3, attributes);
+	if(not fg.empty()) { run.fg = &fg[0]; run.fg_count = static_cast<int>(fg.size()); }
+	if(not bg.empty()) { run.bg = &bg[0]; run.bg_count = static_cast<int>(bg.size()); }
+	if(not attributes.empty()) { run.attributes = &attributes[0]; run.attribute_count = static_cast<int>(attributes.size()); }
+}
+
+// argument 1 is the MyGraphics, since it's called as a method
+int MyGraphics::lua_print_run(lua_State* L)
+{
+	GlyphRun run;
+	glyph_run_from_lua(L, 2, run);
+	if(run.count > 0)
+	{
+		print_run(run);
 	}
+	lua_pushinteger(L, run.count);
+	return 1;
 }
 
 void print_glyph(MyGraphics* gr, int glyph)
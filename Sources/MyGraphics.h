@@ -48,6 +48,33 @@
 
 // forward declaration
 struct GameTexInfo;
+class DrawStyle;
+class TextLayoutCache;
+
+// glyph attributes for print_run()
+enum glyph_attribute_t
+{
+	glyph_bg_transparent = 1,		// don't draw this glyph's background
+	glyph_dim = 2,					// as set_dim_alpha(), for this glyph
+	glyph_skip = 4,					// leave the cell alone, just move the cursor on
+};
+
+// A run of glyphs for print_run(). The colour and attribute arrays either
+// have one entry per glyph, or a single entry for the whole run, or are 0 to
+// use the current colours and no attributes. Glyphs past the end of a
+// shorter array get the current colours / no attributes too.
+struct GlyphRun
+{
+	GlyphRun() : characters(0), count(0), fg(0), fg_count(0), bg(0), bg_count(0), attributes(0), attribute_count(0) {}
+	const Uint32* characters;
+	int count;
+	const SDL_Colour* fg;
+	int fg_count;
+	const SDL_Colour* bg;
+	int bg_count;
+	const Uint8* attributes;
+	int attribute_count;
+};
 
 class MyGraphics {
 public:
@@ -63,8 +90,31 @@ public:
 	virtual void print(int character, double rotation_angle, double size_ratio, int cells_wide, int cells_high) = 0;
 
     virtual int printEx(pos_t line, pos_t column, simple_colour_t fg_colour, int character, double scale_x, double scale_y, double angle, double rot_center_x, double rot_center_y, const int flip) = 0;
+    // attrs is a table (see printExT in MyGraphics_render.cpp) or a DrawStyle
     virtual int printExT(pos_t line, pos_t column, simple_colour_t fg_colour, int character,
                  luabridge::LuaRef attrs, lua_State* L) = 0;
+    // printEx with everything from the style. Doesn't move the cursor either.
+    virtual int print_styled(pos_t line, pos_t column, int character, const DrawStyle& style) = 0;
+
+    // Print lots of single cell glyphs in one go (e.g. particles). Doesn't move the cursor,
+    // background is never drawn, and colours[i].a is used as the alpha for that glyph.
+    virtual void print_batch(const pos_t* lines, const pos_t* columns, const int* characters, const SDL_Colour* colours, int count, double size_ratio) = 0;
+
+    // Print a run of glyphs at the cursor, as if print() was called for each
+    // one - the cursor moves on and wraps the same way - but in one call.
+    virtual void print_run(const GlyphRun& run) = 0;
+
+    // Print UTF-8 text at the cursor, like print() for each character. The
+    // layout is cached (see TextLayoutCache), so text that's printed every
+    // frame is only decoded and wrapped once.
+    virtual void print_text(const char* text, size_t length) = 0;
+
+    // gr:print_run(glyphs, [fg], [bg], [attributes]) from Lua, returns the glyph count
+    //   glyphs - a UTF-8 string, or a GlyphArray of code points
+    //   fg, bg - nil for the current colour, a simple colour or SDL_Color for all of
+    //            them, or a table (of those) or GlyphArray (packed colours) per glyph
+    //   attributes - nil, a number for all of them, or a table or GlyphArray per glyph
+    int lua_print_run(lua_State* L);
 
 	virtual void set_fg_fullcolour(const SDL_Colour& colour) = 0;
 	virtual void set_fg_colour(simple_colour_t colour) = 0;
@@ -74,6 +124,7 @@ public:
 	virtual void set_bg_transparent() = 0;
 	virtual void set_dim_alpha() = 0;
 	virtual void set_full_alpha() = 0;
+	virtual void set_alpha(Uint8 alpha) = 0;		// 255 is normal
 
 	virtual void go_to(pos_t line, pos_t column) = 0;
 	virtual pos_t get_column() = 0;
@@ -106,6 +157,9 @@ public:
     virtual void set_viewport(Viewport& vp) = 0;
 
     virtual GameTexInfo* get_GameTexInfo(int character) = 0;
+    virtual size_t texture_bytes() = 0;     // all the glyph textures (shared ones once)
+    virtual Uint64 draw_call_count() = 0;   // SDL render calls since start
+    virtual TextLayoutCache* get_text_layout_cache() = 0;
     virtual void overwrite_GameTexInfo(int character, GameTexInfo* gti) = 0;
 
 private:
@@ -117,6 +171,10 @@ void print_glyph(MyGraphics* gr, int glyph);
 void print_glyph_ex(MyGraphics* gr, int glyph, double rotation, double size_ratio, int cell_width, int cell_height);
 
 void print_cstring(MyGraphics* gr, const char* string);
+
+// print_run's glyphs, fg, bg and attributes arguments, starting at first_arg.
+// The arrays are only good until the next call.
+void glyph_run_from_lua(lua_State* L, int first_arg, GlyphRun& run);
 //void print_string(MyGraphics& gr, const char* string);
 //void print_string(MyGraphics& gr, pos_t line, pos_t column, const char* string);
 void print_string(MyGraphics& gr, const std::string& string);
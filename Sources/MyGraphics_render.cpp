@@ -33,6 +33,8 @@
 #include "GameToScreenMapping.h"
 #include "Utilities.h"
 #include "image_loader.h"
+#include "DrawStyle.h"
+#include "LuaUserdata.h"
 #include <stdio.h>
 #ifdef _MSC_VER
 #include <ciso646>   // Visual Studio is not C++ standards complaint...
@@ -41,6 +43,7 @@
 #include "LoadPath.h"
 #include "glyph_set_utilities.h"
 #include <iostream>
+#include <set>
 
 using luabridge::LuaRef;
 
@@ -85,7 +88,9 @@ MyGraphics_render::MyGraphics_render(SDL_Renderer *created_renderer)
   wrap_column_start(0),
   wrap_column_end(32),
   bg_transparent(false),
-  dim(false)
+  dim(false),
+  alpha(255),
+  draw_calls(0)
 {
 	our_bg_colour.r = our_bg_colour.g = our_bg_colour.b = 255;
 	our_bg_colour.a = SDL_ALPHA_OPAQUE;
@@ -183,6 +188,23 @@ void MyGraphics_render::print(pos_t line, pos_t column, const SDL_Colour& fg_col
 SDL_Texture* MyGraphics_render::common_transform(int &x, int &y, int character,
 										const SDL_Colour& fg_colour,
                                         SDL_Rect &srcRect, int width, int height)
+{
+    SDL_Texture* tex = find_glyph_texture(character, srcRect, width, height);
+
+// @todo: Disable this
+#define WARNING_ABOUT_SDL_SETTEXTURECOLORMOD_ERROR 1
+    //SDL_Color c = get_rgb_from_simple_colour(fg_colour);
+#if WARNING_ABOUT_SDL_SETTEXTURECOLORMOD_ERROR
+    int error =
+#endif
+    SDL_SetTextureColorMod(tex, fg_colour.r, fg_colour.g, fg_colour.b);
+#if WARNING_ABOUT_SDL_SETTEXTURECOLORMOD_ERROR
+    if(error) { Utilities::fatalErrorSDL("SDL_SetTextureColorMod", error); }
+#endif
+    return tex;
+}
+
+SDL_Texture* MyGraphics_render::find_glyph_texture(int character, SDL_Rect &srcRect, int width, int height)
 {
     int original_character = character;
 
@@ -246,19 +268,7 @@ SDL_Texture* MyGraphics_render::common_transform(int &x, int &y, int character,
         cell_size_image*width, cell_size_image*height };
     srcRect = new_srcRect;
     
-    SDL_Texture* tex = gti->texture.get();
-
-// @todo: Disable this
-#define WARNING_ABOUT_SDL_SETTEXTURECOLORMOD_ERROR 1
-    //SDL_Color c = get_rgb_from_simple_colour(fg_colour);
-#if WARNING_ABOUT_SDL_SETTEXTURECOLORMOD_ERROR
-    int error =
-#endif
-    SDL_SetTextureColorMod(tex, fg_colour.r, fg_colour.g, fg_colour.b);
-#if WARNING_ABOUT_SDL_SETTEXTURECOLORMOD_ERROR
-    if(error) { Utilities::fatalErrorSDL("SDL_SetTextureColorMod", error); }
-#endif
-    return tex;
+    return gti->texture.get();
 }
 
 void MyGraphics_render::overwrite_GameTexInfo(int character, GameTexInfo* gti)
@@ -312,6 +322,39 @@ GameTexInfo* MyGraphics_render::get_GameTexInfo(int character)
     }
 }
 
+static void add_texture_bytes(const GameTexInfo& gti, std::set<SDL_Texture*>& seen, size_t& total)
+{
+    SDL_Texture* t = gti.texture.get();
+    if(t == 0 or not seen.insert(t).second) return;
+    Uint32 format = 0;
+    int w = 0, h = 0;
+    if(SDL_QueryTexture(t, &format, 0, &w, &h) == 0)
+    {
+        int bytes_per_pixel = SDL_BYTESPERPIXEL(format);
+        total += static_cast<size_t>(w) * h * (bytes_per_pixel ? bytes_per_pixel : 4);
+    }
+}
+
+// an estimate - the driver might pad, or keep another copy
+size_t MyGraphics_render::texture_bytes()
+{
+    std::set<SDL_Texture*> seen;
+    size_t total = 0;
+    for(int i = 0; i < number_of_low_value_sets; i++)
+    {
+        add_texture_bytes(low_textures[i], seen, total);
+    }
+    for(int i = 0; i < number_of_private_use_sets; i++)
+    {
+        add_texture_bytes(private_use_textures[i], seen, total);
+    }
+    for(std::map<int, GameTexInfo>::const_iterator it = other_texture_store.begin(); it != other_texture_store.end(); ++it)
+    {
+        add_texture_bytes(it->second, seen, total);
+    }
+    return total;
+}
+
 void MyGraphics_render::set_dim_alpha()
 {
 	dim = true;
@@ -322,13 +365,19 @@ void MyGraphics_render::set_full_alpha()
 	dim = false;
 }
 
+void MyGraphics_render::set_alpha(Uint8 a)
+{
+	alpha = a;
+}
+
 void MyGraphics_render::internal_printxy(int x, int y, const SDL_Colour& fg_colour, const SDL_Colour& bg_colour, int character, double rotation_angle, double size_ratio, int cells_wide, int cells_high)
 {
     SDL_Rect srcRect;
     SDL_Texture* tex = common_transform(x, y, character, fg_colour, srcRect, cells_wide, cells_high);
 
     // if necessary, dim the texture
-    if(dim) SDL_SetTextureAlphaMod(tex, 96);
+    bool alpha_changed = dim or alpha != 255;
+    if(alpha_changed) SDL_SetTextureAlphaMod(tex, dim ? (96*alpha)/255 : alpha);
 
     int w = (int)(size_ratio*viewport.cell_size*cells_wide);
     int h = (int)(size_ratio*viewport.cell_size*cells_high);
@@ -343,25 +392,196 @@ void MyGraphics_render::internal_printxy(int x, int y, const SDL_Colour& fg_colo
         // @todo: is this faster or slower than just calling the more complex function without a test?
         if(rotation_angle == 0.0)
         {
+            draw_calls++;
             SDL_RenderCopy(renderer, tex, &srcRect, &dstRect);
         }
         else
 #endif
         {
+            draw_calls++;
             SDL_RenderCopyEx(renderer, tex, &srcRect, &dstRect, rotation_angle, NULL, SDL_FLIP_NONE);
         }
     }
 
     // return the texture to full brightness
-    if(dim) SDL_SetTextureAlphaMod(tex, 255);
+    if(alpha_changed) SDL_SetTextureAlphaMod(tex, 255);
 
 }
 
 
+void MyGraphics_render::print_batch(const pos_t* lines, const pos_t* columns, const int* characters, const SDL_Colour* colours, int count, double size_ratio)
+{
+    int size = (int)(size_ratio*viewport.cell_size);
+    SDL_Texture* last_tex = 0;
+    SDL_Colour last_colour = { 0, 0, 0, 0 };
+
+    for(int i = 0; i < count; i++)
+    {
+        SDL_Rect srcRect;
+        SDL_Texture* tex = find_glyph_texture(characters[i], srcRect, 1, 1);
+        if(not tex) continue;
+
+        // only touch the texture state when it actually changes, particles
+        // mostly share a glyph set and colour
+        const SDL_Colour& c = colours[i];
+        if(tex != last_tex or c.r != last_colour.r or c.g != last_colour.g or c.b != last_colour.b)
+        {
+            SDL_SetTextureColorMod(tex, c.r, c.g, c.b);
+        }
+        if(tex != last_tex or c.a != last_colour.a)
+        {
+            if(last_tex and tex != last_tex) SDL_SetTextureAlphaMod(last_tex, 255);
+            SDL_SetTextureAlphaMod(tex, dim ? (c.a*96)/255 : c.a);
+        }
+        last_tex = tex;
+        last_colour = c;
+
+        SDL_Rect dstRect = { column_to_x(columns[i]), line_to_y(lines[i]), size, size };
+        draw_calls++;
+        SDL_RenderCopy(renderer, tex, &srcRect, &dstRect);
+    }
+
+    // return the texture to full brightness
+    if(last_tex) SDL_SetTextureAlphaMod(last_tex, 255);
+}
+
+// which entry of a print_run colour/attribute array glyph i uses, or -1 for the default
+static inline int run_index(int i, int array_count)
+{
+    if(array_count == 1) return 0;
+    return i < array_count ? i : -1;
+}
+
+void MyGraphics_render::print_run(const GlyphRun& run)
+{
+    run_cells.resize(run.count);
+    for(int i = 0; i < run.count; i++)
+    {
+        SDL_Point& cell = run_cells[i];
+        cell.x = column_to_x(current_column);
+        cell.y = line_to_y(current_line);
+        skip_1_forward();
+    }
+    draw_run(run);
+}
+
+void MyGraphics_render::print_text(const char* text, size_t length)
+{
+    TextWrap settings = { wrap_text, wrap_line_start, wrap_line_end, wrap_column_start, wrap_column_end };
+    const TextLayoutCache::Layout& layout = text_layouts.find(text, length, current_line, current_column, settings);
+    int count = static_cast<int>(layout.glyphs.size());
+    if(count == 0) return;
+
+    run_cells.resize(count);
+    for(int i = 0; i < count; i++)
+    {
+        run_cells[i].x = column_to_x(layout.columns[i]);
+        run_cells[i].y = line_to_y(layout.lines[i]);
+    }
+    current_line = layout.end_line;
+    current_column = layout.end_column;
+
+    GlyphRun run;
+    run.characters = &layout.glyphs[0];
+    run.count = count;
+    draw_run(run);
+}
+
+// draws a run at the pixel positions in run_cells
+void MyGraphics_render::draw_run(const GlyphRun& run)
+{
+    int size = viewport.cell_size;
+
+    // Backgrounds first, one rectangle for each stretch of the same colour
+    // along a line. Cells don't overlap, so drawing all the backgrounds before
+    // the glyphs looks the same as going glyph by glyph.
+    SDL_Rect pending = { 0, 0, 0, 0 };
+    SDL_Colour pending_colour = our_bg_colour;
+    for(int i = 0; i < run.count; i++)
+    {
+        const SDL_Point& cell = run_cells[i];
+
+        int a = run.attributes ? run_index(i, run.attribute_count) : -1;
+        Uint8 attributes = a >= 0 ? run.attributes[a] : 0;
+        if(bg_transparent or (attributes & (glyph_bg_transparent | glyph_skip))) continue;
+
+        int b = run.bg ? run_index(i, run.bg_count) : -1;
+        const SDL_Colour& colour = b >= 0 ? run.bg[b] : our_bg_colour;
+        if(pending.w and cell.y == pending.y and cell.x == pending.x + pending.w and
+           colour.r == pending_colour.r and colour.g == pending_colour.g and colour.b == pending_colour.b and colour.a == pending_colour.a)
+        {
+            pending.w += size;
+            continue;
+        }
+        if(pending.w) { drawBlank(pending.x, pending.y, pending.w, pending.h, pending_colour); }
+        pending.x = cell.x;
+        pending.y = cell.y;
+        pending.w = size;
+        pending.h = size;
+        pending_colour = colour;
+    }
+    if(pending.w) { drawBlank(pending.x, pending.y, pending.w, pending.h, pending_colour); }
+
+    // then the glyphs, only touching the texture state when it changes (like print_batch)
+    SDL_Texture* last_tex = 0;
+    SDL_Colour last_colour = { 0, 0, 0, 0 };
+    Uint8 last_alpha = 255;
+    for(int i = 0; i < run.count; i++)
+    {
+        int a = run.attributes ? run_index(i, run.attribute_count) : -1;
+        Uint8 attributes = a >= 0 ? run.attributes[a] : 0;
+        if(attributes & glyph_skip) continue;
+
+        SDL_Rect srcRect;
+        SDL_Texture* tex = find_glyph_texture(static_cast<int>(run.characters[i]), srcRect, 1, 1);
+        if(not tex) continue;
+
+        int f = run.fg ? run_index(i, run.fg_count) : -1;
+        const SDL_Colour& c = f >= 0 ? run.fg[f] : our_fg_colour;
+        if(tex != last_tex or c.r != last_colour.r or c.g != last_colour.g or c.b != last_colour.b)
+        {
+            SDL_SetTextureColorMod(tex, c.r, c.g, c.b);
+        }
+        Uint8 glyph_alpha = (dim or (attributes & glyph_dim)) ? (96*alpha)/255 : alpha;
+        if(tex != last_tex)
+        {
+            // textures are left at full alpha between prints
+            if(last_tex and last_alpha != 255) SDL_SetTextureAlphaMod(last_tex, 255);
+            if(glyph_alpha != 255) SDL_SetTextureAlphaMod(tex, glyph_alpha);
+        }
+        else if(glyph_alpha != last_alpha)
+        {
+            SDL_SetTextureAlphaMod(tex, glyph_alpha);
+        }
+        last_tex = tex;
+        last_colour = c;
+        last_alpha = glyph_alpha;
+
+        SDL_Rect dstRect = { run_cells[i].x, run_cells[i].y, size, size };
+        draw_calls++;
+        SDL_RenderCopy(renderer, tex, &srcRect, &dstRect);
+    }
+
+    // return the texture to full brightness
+    if(last_tex and last_alpha != 255) SDL_SetTextureAlphaMod(last_tex, 255);
+}
+
 int MyGraphics_render::printExT(pos_t line, pos_t column,
                                  simple_colour_t fg_colour, int character,
                                  LuaRef attrs, lua_State* L)
 {
+    // a DrawStyle has it all worked out already
+    if(attrs.isUserdata())
+    {
+        attrs.push(L);
+        DrawStyle* style = luabridge_userdata_if<DrawStyle>(L, -1);
+        lua_pop(L, 1);
+        if(style)
+        {
+            return print_styled(line, column, get_rgb_from_simple_colour(fg_colour), character, *style);
+        }
+    }
+
     // defaults
     double scale_x = 1.0;
     double scale_y = 1.0;
@@ -404,7 +624,22 @@ int MyGraphics_render::printEx(pos_t line, pos_t column, simple_colour_t fg_colo
                               scale_x, scale_y, angle, &center, (SDL_RendererFlip)flip);
 }
 
-int MyGraphics_render::internal_printxy_extended(int x, int y, const SDL_Colour& fg_colour, int character, double scale_x, double scale_y, double angle, const SDL_Point* center, /*double rot_center_x, double rot_center_y,*/ const SDL_RendererFlip flip)
+int MyGraphics_render::print_styled(pos_t line, pos_t column, int character, const DrawStyle& style)
+{
+    return print_styled(line, column, style.has_colour ? style.colour : our_fg_colour, character, style);
+}
+
+int MyGraphics_render::print_styled(pos_t line, pos_t column, const SDL_Colour& fg_colour, int character, const DrawStyle& style)
+{
+    int x = column_to_x(column);
+    int y = line_to_y(line);
+    SDL_Point center = { static_cast<int>(viewport.cell_size * style.rot_center_x), static_cast<int>(viewport.cell_size * style.rot_center_y) };
+    int a = style.alpha < 0 ? 0 : (style.alpha > 255 ? 255 : style.alpha);
+    return internal_printxy_extended(x, y, fg_colour, character, style.scale_x, style.scale_y, style.angle,
+                                     &center, (SDL_RendererFlip)style.flip, static_cast<Uint8>(a));
+}
+
+int MyGraphics_render::internal_printxy_extended(int x, int y, const SDL_Colour& fg_colour, int character, double scale_x, double scale_y, double angle, const SDL_Point* center, /*double rot_center_x, double rot_center_y,*/ const SDL_RendererFlip flip, Uint8 glyph_alpha)
 {
     SDL_Rect srcRect;
     SDL_Texture* tex = common_transform(x, y, character, fg_colour, srcRect, 1, 1);
@@ -413,7 +648,11 @@ int MyGraphics_render::internal_printxy_extended(int x, int y, const SDL_Colour&
         //SDL_Point center = { dstRect.w/2, dstRect.h/2 };
         
         SDL_Rect dstRect = { x, y, static_cast<int>(viewport.cell_size * scale_x), static_cast<int>(viewport.cell_size * scale_y) };
-        return SDL_RenderCopyEx(renderer, tex, &srcRect, &dstRect, angle, center, flip);
+        if(glyph_alpha != 255) SDL_SetTextureAlphaMod(tex, glyph_alpha);
+        draw_calls++;
+        int error = SDL_RenderCopyEx(renderer, tex, &srcRect, &dstRect, angle, center, flip);
+        if(glyph_alpha != 255) SDL_SetTextureAlphaMod(tex, 255);
+        return error;
     }
     return 0;
 }
@@ -460,6 +699,7 @@ void MyGraphics_render::drawBlank(int x, int y, int width, int height, const SDL
 {
     SDL_Rect rect = { x, y, width, height };
     SDL_SetRenderDrawColor(renderer, colour.r, colour.g, colour.b, colour.a);
+    draw_calls++;
     SDL_RenderFillRect(renderer, &rect);
 }
 
@@ -785,6 +1025,7 @@ void MyGraphics_render::clear_screen(const SDL_Colour& colour)
 	// don't paint a rectangle, clear the renderer properly...
 
     //SDL_RenderFillRect(renderer, NULL);
+	draw_calls++;
 	int error2 = SDL_RenderClear(renderer);
 	if(error2) { Utilities::fatalErrorSDL("MyGraphics_render::clear_screen SDL_RenderClear Error ="); }
 }
@@ -806,6 +1047,7 @@ void MyGraphics_render::set_viewport(Viewport& vp)
 
 void MyGraphics_render::FillRectSimple(const SDL_Rect& rect)
 {
+	draw_calls++;
 	SDL_RenderFillRect(renderer, &rect);
 }
 
@@ -853,6 +1095,7 @@ void MyGraphics_render::DrawRect(const SDL_Colour& colour,
     const SDL_Rect rect = { static_cast<int>(x1)  + viewport.rect.x + viewport.origin_x,
         static_cast<int>(y1)  + viewport.rect.y + viewport.origin_y,
         static_cast<int>(x2-x1), static_cast<int>(y2-y1) };
+    draw_calls++;
     SDL_RenderDrawRect(renderer, &rect);
 }
 
@@ -863,6 +1106,7 @@ void MyGraphics_render::DrawAbsoluteRect(const SDL_Colour& colour,
                            colour.a);
 
     const SDL_Rect rect = { x1,y1,x2-x1,y2-y1 };
+    draw_calls++;
     SDL_RenderDrawRect(renderer, &rect);
 }
 
@@ -884,6 +1128,7 @@ void MyGraphics_render::DrawLine(const SDL_Colour& colour,
     int X2 = static_cast<int>(x2);
     int Y2 = static_cast<int>(y2);
     const SDL_Rect srect = { X1, Y1, X2-X1, Y2-Y1 };
+    draw_calls++;
     SDL_RenderDrawLine(renderer, srect.x, srect.y, srect.x+srect.w, srect.y+srect.h);
 }
 
@@ -900,6 +1145,7 @@ void MyGraphics_render::DrawPoint(const SDL_Colour& colour,
     }
     int x1 = x  + viewport.rect.x + viewport.origin_x;
     int y1 = y  + viewport.rect.y + viewport.origin_y;
+    draw_calls++;
     SDL_RenderDrawPoint(renderer, x1, y1);
 }
 
@@ -919,10 +1165,12 @@ void MyGraphics_render::RenderCopy(SDL_Texture* texture, SDL_Rect* source, SDL_R
 	// dest is a copy, so we are safe to modify it
 	if(dest)
 	{
+		draw_calls++;
 		error = SDL_RenderCopy(renderer, texture, source, dest);
 	}
 	else
 	{
+		draw_calls++;
 		error = SDL_RenderCopy(renderer, texture, source, NULL);
 	}
 
@@ -33,10 +33,12 @@
 #define MYGRAPHICS_RENDER_H
 
 #include "MyGraphics.h"
+#include "TextLayoutCache.h"
 #include "LuaMain.h"
 #include "LuaBridge.h"
 #include "map"
 
+#include <vector>
 #include <memory>			// for shared_ptr
 
 struct GameTexInfo;
@@ -78,6 +80,10 @@ public:
     int printEx(pos_t line, pos_t column, simple_colour_t fg_colour, int character, double scale_x, double scale_y, double angle, double rot_center_x, double rot_center_y, const int flip);
     int printExT(pos_t line, pos_t column, simple_colour_t fg_colour, int character,
                                      luabridge::LuaRef attrs, lua_State* L);
+    int print_styled(pos_t line, pos_t column, int character, const DrawStyle& style);
+    void print_batch(const pos_t* lines, const pos_t* columns, const int* characters, const SDL_Colour* colours, int count, double size_ratio);
+    void print_run(const GlyphRun& run);
+    void print_text(const char* text, size_t length);
     
 	void print(pos_t line, pos_t column, simple_colour_t fg_colour, simple_colour_t bg_colour, int character, double rotation_angle = 0.0);
 	void print(pos_t line, pos_t column, int character, double rotation_angle = 0.0, int cell_width = 1, int cell_height = 1);
@@ -94,6 +100,7 @@ public:
 	void set_bg_transparent();
 	void set_dim_alpha();
 	void set_full_alpha();
+	void set_alpha(Uint8 alpha);
 	
 	void go_to(pos_t line, pos_t column);
 	pos_t get_column();
@@ -136,16 +143,22 @@ public:
     //virtual void set_glyph_size_in_pixels(int pixels);
     GameTexInfo* get_GameTexInfo(int character);
     void overwrite_GameTexInfo(int character, GameTexInfo* gti);
+    size_t texture_bytes();
+    Uint64 draw_call_count() { return draw_calls; }
+    TextLayoutCache* get_text_layout_cache() { return &text_layouts; }
     
 private:
 	// private functions
 	void drawBlank(int x, int y, int width, int height, const SDL_Colour& colour);
 //	void internal_printxy(int x, int y, simple_colour_t fg_colour, int character);
 	void internal_printxy(int x, int y, const SDL_Colour& fg_colour, const SDL_Colour& bg_colour, int character, double rotation_angle, double size_ratio, int width, int height);
-    int internal_printxy_extended(int x, int y, const SDL_Colour& fg_colour, int character, double scale_x, double scale_y, double angle, const SDL_Point* center, const SDL_RendererFlip flip);
+    int internal_printxy_extended(int x, int y, const SDL_Colour& fg_colour, int character, double scale_x, double scale_y, double angle, const SDL_Point* center, const SDL_RendererFlip flip, Uint8 glyph_alpha = 255);
+    int print_styled(pos_t line, pos_t column, const SDL_Colour& fg_colour, int character, const DrawStyle& style);
+    void draw_run(const GlyphRun& run);
     
     SDL_Texture* common_transform(int &x, int &y, int character, const SDL_Colour& fg_colour,
                          SDL_Rect &srcRect, int width, int height);
+    SDL_Texture* find_glyph_texture(int character, SDL_Rect &srcRect, int width, int height);
 	
     void set_GameTexInfo(int character, GameTexInfo& gti);
     
@@ -173,6 +186,10 @@ private:
     double wrap_column_end;
 	bool bg_transparent;
 	bool dim;
+	Uint8 alpha;
+	Uint64 draw_calls;
+	std::vector<SDL_Point> run_cells;     // print_run scratch, where each glyph goes
+	TextLayoutCache text_layouts;
 };
 
 #endif
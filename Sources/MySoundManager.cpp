@@ -33,6 +33,7 @@
 #include "Utilities.h"
 #include "GameConfig.h"
 #include "LoadPath.h"
+#include "AssetArchive.h"
 
 #ifdef _MSC_VER
 #include <ciso646>   // Visual Studio is not C++ standards complaint...
@@ -114,7 +115,10 @@ void MySoundManager::play_music(std::string filename, unsigned int volume_percen
 
     if(mMusic) Mix_FreeMusic(mMusic);
 
-    mMusic = Mix_LoadMUS(filename.c_str());
+    // from a packed archive if it's in one. The music streams from the
+    // SDL_RWops, which Mix_FreeMusic closes.
+    SDL_RWops* rw = AssetArchive::open_rw_path(filename.c_str());
+    mMusic = rw ? Mix_LoadMUS_RW(rw, 1) : Mix_LoadMUS(filename.c_str());
 
     if(mMusic)
     {
@@ -157,7 +161,8 @@ double MySoundManager::get_sample_frequency()
 
 sound_ref MySoundManager::load_sound(std::string filename)
 {
-    Mix_Chunk* chunk = Mix_LoadWAV(filename.c_str());
+    SDL_RWops* rw = AssetArchive::open_rw_path(filename.c_str());
+    Mix_Chunk* chunk = rw ? Mix_LoadWAV_RW(rw, 1) : Mix_LoadWAV(filename.c_str());
     mSounds.push_back(chunk);
     return mSounds.size() - 1;
 }
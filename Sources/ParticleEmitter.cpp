@@ -0,0 +1,380 @@
+/*
+ * ParticleEmitter.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#include "ParticleEmitter.h"
+#include "DrawList.h"
+#include "Utilities.h"
+#include <cmath>
+#include <algorithm>
+#include <stdint.h>
+#ifdef _MSC_VER
+#include <ciso646>   // Visual Studio is not C++ standards complaint...
+#endif
+
+// don't let a long pause (e.g. dragging the window, breakpoint) throw
+// every particle off the screen in one step
+static const double max_update_step = 0.1;
+// far more than will ever be drawn, but stops a bad argument allocating gigabytes
+static const int max_particle_limit = 100000;
+
+ParticleEmitter::ParticleEmitter(DrawList* dl, int max)
+: draw_list(dl)
+, listed(false)
+, line(0)
+, column(0)
+, area_lines(0)
+, area_columns(0)
+, layer(0)
+, rate(0)
+, lifetime_min(1.0f), lifetime_max(1.0f)
+, speed_min(0.0f), speed_max(0.0f)
+, direction(0.0f), spread(static_cast<float>(2*M_PI))
+, gravity_line(0.0f), gravity_column(0.0f)
+, drag(0.0f)
+, fade(true)
+, size_ratio(1.0)
+, running(false)
+, max_particles(max)
+, count(0)
+, spawn_accumulator(0.0)
+, last_update(0)
+, random_state(0)
+{
+	if(draw_list and draw_list->dl_magic != DL_MAGIC)
+	{
+		Utilities::fatalError("ParticleEmitter got something without correct magic. Aborting!");
+	}
+	if(max_particles < 0 or max_particles > max_particle_limit)
+	{
+		Utilities::fatalError("ParticleEmitter max particles %d out of range (0 to %d)", max_particles, max_particle_limit);
+	}
+	if(max_particles < 1) { max_particles = 1; }
+
+	glyph_choices.push_back('*');
+	SDL_Color white = { 255, 255, 255, 255 };
+	colour_start = white;
+	colour_end = white;
+
+	p_line.resize(max_particles);
+	p_column.resize(max_particles);
+	p_v_line.resize(max_particles);
+	p_v_column.resize(max_particles);
+	p_age.resize(max_particles);
+	p_inv_lifetime.resize(max_particles);
+	p_glyph.resize(max_particles);
+	draw_line.resize(max_particles);
+	draw_column.resize(max_particles);
+	draw_colour.resize(max_particles);
+
+	// xorshift can't start at zero
+	random_state = static_cast<Uint32>(SDL_GetPerformanceCounter() ^ reinterpret_cast<uintptr_t>(this));
+	if(random_state == 0) { random_state = 0x12345678; }
+}
+
+ParticleEmitter::~ParticleEmitter()
+{
+	hide();
+}
+
+void ParticleEmitter::show()
+{
+	if(draw_list and not listed)
+	{
+		draw_list->insert_emitter(this);
+		listed = true;
+		last_update = 0;
+	}
+}
+
+void ParticleEmitter::hide()
+{
+	if(listed and draw_list)
+	{
+		draw_list->remove_emitter(this);
+	}
+	listed = false;
+}
+
+void ParticleEmitter::list_died()
+{
+	draw_list = 0;
+	listed = false;
+}
+
+void ParticleEmitter::set_position(pos_t l, pos_t c)
+{
+	line = l;
+	column = c;
+}
+
+void ParticleEmitter::set_area(pos_t lines, pos_t columns)
+{
+	area_lines = lines;
+	area_columns = columns;
+}
+
+void ParticleEmitter::set_rate(double particles_per_second)
+{
+	rate = particles_per_second < 0 ? 0 : particles_per_second;
+}
+
+void ParticleEmitter::set_lifetime(double min_seconds, double max_seconds)
+{
+	// zero lifetime would give us a divide by zero
+	if(min_seconds < 0.001) min_seconds = 0.001;
+	if(max_seconds < min_seconds) max_seconds = min_seconds;
+	lifetime_min = static_cast<float>(min_seconds);
+	lifetime_max = static_cast<float>(max_seconds);
+}
+
+void ParticleEmitter::set_speed(double min_speed, double max_speed)
+{
+	speed_min = static_cast<float>(min_speed);
+	speed_max = static_cast<float>(max_speed);
+}
+
+void ParticleEmitter::set_direction(double angle, double spread_angle)
+{
+	direction = static_cast<float>(angle * M_PI / 180.0);
+	spread = static_cast<float>(spread_angle * M_PI / 180.0);
+}
+
+void ParticleEmitter::set_gravity(double line_acceleration, double column_acceleration)
+{
+	gravity_line = static_cast<float>(line_acceleration);
+	gravity_column = static_cast<float>(column_acceleration);
+}
+
+void ParticleEmitter::set_drag(double d)
+{
+	drag = d < 0 ? 0.0f : static_cast<float>(d);
+}
+
+void ParticleEmitter::set_glyph(int glyph)
+{
+	glyph_choices.clear();
+	glyph_choices.push_back(glyph);
+}
+
+void ParticleEmitter::set_glyphs(lua_State* L)
+{
+	// tests for parameter error, if so, raise error.
+	luaL_checktype(L, -1, LUA_TTABLE);
+
+	int number_of_glyphs = static_cast<int>(luaL_len(L, -1));
+	std::vector<int> new_glyphs;
+	for(int i = 1; i <= number_of_glyphs; i++)
+	{
+		lua_pushinteger(L, i);
+		lua_gettable(L, -2);		// replaces key with value
+		if(lua_isnumber(L, -1))
+		{
+			new_glyphs.push_back(static_cast<int>(lua_tointeger(L, -1)));
+		}
+		lua_pop(L, 1);
+	}
+
+	// leave the current glyphs alone if nothing useful was passed
+	if(not new_glyphs.empty())
+	{
+		glyph_choices.swap(new_glyphs);
+	}
+}
+
+void ParticleEmitter::set_colours(SDL_Color start, SDL_Color end)
+{
+	colour_start = start;
+	colour_end = end;
+}
+
+void ParticleEmitter::clear()
+{
+	count = 0;
+	spawn_accumulator = 0;
+}
+
+void ParticleEmitter::burst(int n)
+{
+	spawn(n);
+}
+
+float ParticleEmitter::random_float()
+{
+	// xorshift32 - we want fast rather than good here
+	Uint32 x = random_state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	random_state = x;
+	return (x >> 8) * (1.0f / 16777216.0f);
+}
+
+void ParticleEmitter::spawn(int n)
+{
+	if(n <= 0) return;
+	if(n > max_particles - count)
+	{
+		n = max_particles - count;
+	}
+
+	const int num_glyphs = static_cast<int>(glyph_choices.size());
+	for(int i = count; i < count + n; i++)
+	{
+		p_line[i] = line + random_float() * area_lines;
+		p_column[i] = column + random_float() * area_columns;
+
+		float a = direction + (random_float() - 0.5f) * spread;
+		float speed = random_range(speed_min, speed_max);
+		p_v_line[i] = std::sin(a) * speed;
+		p_v_column[i] = std::cos(a) * speed;
+
+		p_age[i] = 0.0f;
+		p_inv_lifetime[i] = 1.0f / random_range(lifetime_min, lifetime_max);
+		p_glyph[i] = glyph_choices[num_glyphs == 1 ? 0 : static_cast<int>(random_float() * num_glyphs) % num_glyphs];
+	}
+	count += n;
+}
+
+void ParticleEmitter::update_from_clock()
+{
+	Uint64 now = SDL_GetPerformanceCounter();
+	if(last_update == 0)
+	{
+		last_update = now;
+		return;
+	}
+	double dt = static_cast<double>(now - last_update) / SDL_GetPerformanceFrequency();
+	last_update = now;
+
+	if(dt > max_update_step) dt = max_update_step;
+	update(dt);
+}
+
+void ParticleEmitter::update(double dt)
+{
+	if(dt <= 0) return;
+	const float fdt = static_cast<float>(dt);
+
+	// integrate - kept as separate simple loops so they vectorise
+	const float damping = drag > 0 ? std::max(0.0f, 1.0f - drag * fdt) : 1.0f;
+	const float gl = gravity_line * fdt;
+	const float gc = gravity_column * fdt;
+	float* vl = &p_v_line[0];
+	float* vc = &p_v_column[0];
+	float* pl = &p_line[0];
+	float* pc = &p_column[0];
+	float* age = &p_age[0];
+	const float* inv_life = &p_inv_lifetime[0];
+	const int n = count;
+
+	for(int i = 0; i < n; i++) { vl[i] = vl[i] * damping + gl; }
+	for(int i = 0; i < n; i++) { vc[i] = vc[i] * damping + gc; }
+	for(int i = 0; i < n; i++) { pl[i] += vl[i] * fdt; }
+	for(int i = 0; i < n; i++) { pc[i] += vc[i] * fdt; }
+	for(int i = 0; i < n; i++) { age[i] += inv_life[i] * fdt; }
+
+	// remove dead particles by moving the last live one into the gap
+	for(int i = 0; i < count; )
+	{
+		if(age[i] >= 1.0f)
+		{
+			kill(i);
+		}
+		else
+		{
+			i++;
+		}
+	}
+
+	// emit new ones
+	if(running and rate > 0)
+	{
+		spawn_accumulator += rate * dt;
+		int new_particles = static_cast<int>(spawn_accumulator);
+		spawn_accumulator -= new_particles;
+		spawn(new_particles);
+	}
+}
+
+void ParticleEmitter::kill(int index)
+{
+	int last = count - 1;
+	if(index != last)
+	{
+		p_line[index] = p_line[last];
+		p_column[index] = p_column[last];
+		p_v_line[index] = p_v_line[last];
+		p_v_column[index] = p_v_column[last];
+		p_age[index] = p_age[last];
+		p_inv_lifetime[index] = p_inv_lifetime[last];
+		p_glyph[index] = p_glyph[last];
+	}
+	count--;
+}
+
+void ParticleEmitter::draw(MyGraphics& gr, pos_t line_offset, pos_t column_offset)
+{
+	if(count == 0) return;
+
+	const int n = count;
+	const float* age = &p_age[0];
+	const bool same_colour = colour_start.r == colour_end.r and colour_start.g == colour_end.g
+			and colour_start.b == colour_end.b and colour_start.a == colour_end.a;
+
+	for(int i = 0; i < n; i++)
+	{
+		draw_line[i] = p_line[i] - line_offset;
+		draw_column[i] = p_column[i] - column_offset;
+	}
+
+	for(int i = 0; i < n; i++)
+	{
+		SDL_Colour& c = draw_colour[i];
+		float t = age[i];
+		if(same_colour)
+		{
+			c = colour_start;
+		}
+		else
+		{
+			c.r = static_cast<Uint8>(colour_start.r + (colour_end.r - colour_start.r) * t);
+			c.g = static_cast<Uint8>(colour_start.g + (colour_end.g - colour_start.g) * t);
+			c.b = static_cast<Uint8>(colour_start.b + (colour_end.b - colour_start.b) * t);
+			c.a = static_cast<Uint8>(colour_start.a + (colour_end.a - colour_start.a) * t);
+		}
+		if(fade)
+		{
+			c.a = static_cast<Uint8>(c.a * (1.0f - t));
+		}
+	}
+
+	gr.print_batch(&draw_line[0], &draw_column[0], &p_glyph[0], &draw_colour[0], n, size_ratio);
+}
@@ -0,0 +1,146 @@
+/*
+ * ParticleEmitter.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#ifndef PARTICLEEMITTER_H_
+#define PARTICLEEMITTER_H_
+
+#include <vector>
+#include "MyGraphics.h"
+class DrawList;
+
+// A particle effect (explosion, rain, sparks) that lives in a DrawList and is
+// simulated and drawn entirely in C++. Lua just configures it, and then it costs
+// nothing per particle on the Lua side.
+//
+// The particle state is kept as separate arrays (struct-of-arrays) so the update
+// loops are simple straight runs over floats that the compiler can vectorise.
+//
+// Positions and velocities are in the draw list's units (cells or pixels,
+// depending on draw location mode), velocities are per second.
+class ParticleEmitter
+{
+public:
+	ParticleEmitter(DrawList* draw_list, int max_particles);
+	~ParticleEmitter();
+
+	// where new particles appear - a rectangle from line,column of lines x columns
+	void set_position(pos_t line, pos_t column);
+	void set_area(pos_t lines, pos_t columns);
+	pos_t get_line() { return line; }
+	pos_t get_column() { return column; }
+	void set_layer(int l) { layer = l; }
+	int get_layer() { return layer; }
+
+	void set_rate(double particles_per_second);
+	void set_lifetime(double min_seconds, double max_seconds);
+	void set_speed(double min_speed, double max_speed);
+	// angle in degrees, 0 is towards the right (increasing column), 90 is down (increasing line)
+	void set_direction(double angle, double spread);
+	void set_gravity(double line_acceleration, double column_acceleration);
+	void set_drag(double d);
+
+	void set_glyph(int glyph);
+	void set_glyphs(lua_State* L);		// table of glyphs, one picked at random per particle
+	void set_colours(SDL_Color start, SDL_Color end);
+	void set_fade(bool f) { fade = f; }
+	void set_size_ratio(double s) { size_ratio = s; }
+
+	void burst(int count);
+	void start() { running = true; }
+	void stop() { running = false; }
+	bool is_running() { return running; }
+	void clear();
+	int get_count() { return count; }
+
+	void show();
+	void hide();
+	bool is_visible() { return listed; }
+
+	// called by the owning draw list
+	void update(double dt);
+	void draw(MyGraphics& gr, pos_t line_offset, pos_t column_offset);
+	void list_died();
+	void update_from_clock();
+
+private:
+	// lets not have these copy constructed or assigned
+	ParticleEmitter(const ParticleEmitter&);
+	ParticleEmitter& operator=(const ParticleEmitter&);
+
+	void spawn(int n);
+	void kill(int index);
+	float random_float();			// 0.0 to 1.0
+	float random_range(float a, float b) { return a + (b-a) * random_float(); }
+
+	DrawList* draw_list;
+	bool listed;
+
+	// configuration
+	pos_t line;
+	pos_t column;
+	pos_t area_lines;
+	pos_t area_columns;
+	int layer;
+	double rate;
+	float lifetime_min, lifetime_max;
+	float speed_min, speed_max;
+	float direction, spread;		// radians
+	float gravity_line, gravity_column;
+	float drag;
+	std::vector<int> glyph_choices;
+	SDL_Color colour_start;
+	SDL_Color colour_end;
+	bool fade;
+	double size_ratio;
+	bool running;
+
+	// the particles themselves (struct-of-arrays), only the first 'count' are live
+	int max_particles;
+	int count;
+	std::vector<float> p_line;
+	std::vector<float> p_column;
+	std::vector<float> p_v_line;
+	std::vector<float> p_v_column;
+	std::vector<float> p_age;
+	std::vector<float> p_inv_lifetime;	// 1/lifetime, so age*inv_lifetime is 0..1
+	std::vector<int> p_glyph;
+
+	// scratch arrays for the batched draw
+	std::vector<pos_t> draw_line;
+	std::vector<pos_t> draw_column;
+	std::vector<SDL_Colour> draw_colour;
+
+	double spawn_accumulator;
+	Uint64 last_update;
+	Uint32 random_state;
+};
+
+#endif /* PARTICLEEMITTER_H_ */
@@ -56,7 +56,11 @@ const auto square_vertical_offset_ratio = 1.0;
 
 
 PresentationMaze::PresentationMaze(double min_glyphs_horizontally, double min_glyphs_vertically)
-: mobs_draw_list(this)
+: map_element_pool("map", sizeof(MazeDrawListAnimatedElement), 1024)
+, cmep_line_max(-1)
+, cmep_column_max(-1)
+, mobs_draw_list(this)
+, light_map(&transparency)
 , current_line_max(-1)
 , current_column_max(-1)
 , offset_line(0)
@@ -109,14 +113,39 @@ void PresentationMaze::delete_all_cmep()
 	// collection. We need to just delete the things that belong to
 	// us, and not the things that belong to lua, so we keep the things
 	// we created in a big array.
-	for(int line=0; line<MazeConstants::maze_height_max; line++)
+	//
+	// They all live in map_element_pool, so we only need to run the
+	// destructors (to unlink them from the maze draw lists) and then hand
+	// all the blocks back at once.
+	for(int line=0; line<=cmep_line_max; line++)
 	{
-		for(int column=0; column<MazeConstants::maze_height_max; column++)
+		for(int column=0; column<=cmep_column_max; column++)
 		{
-			delete current_maze_element_pointers[line][column];
-			current_maze_element_pointers[line][column] = 0;
+			MazeDrawListElement* element = current_maze_element_pointers[line][column];
+			if(element)
+			{
+				element->~MazeDrawListElement();
+				current_maze_element_pointers[line][column] = 0;
+			}
 		}
 	}
+	map_element_pool.release_all();
+	cmep_line_max = -1;
+	cmep_column_max = -1;
+}
+
+MazeDrawListElement* PresentationMaze::new_map_element(int line, int column, int glyph, int layer)
+{
+	if(line > cmep_line_max) { cmep_line_max = line; }
+	if(column > cmep_column_max) { cmep_column_max = column; }
+	return new (map_element_pool.allocate()) MazeDrawListElement(get_maze_draw_list(line, column), glyph, layer);
+}
+
+MazeDrawListAnimatedElement* PresentationMaze::new_animated_map_element(int line, int column, int layer)
+{
+	if(line > cmep_line_max) { cmep_line_max = line; }
+	if(column > cmep_column_max) { cmep_column_max = column; }
+	return new (map_element_pool.allocate()) MazeDrawListAnimatedElement(get_maze_draw_list(line, column), layer);
 }
 
 double PresentationMaze::GetAvailableLevelWidth()
@@ -185,7 +214,7 @@ void PresentationMaze::load_current_maze(lua_State* L)
             if(lua_type(L, -1) == LUA_TTABLE)
             {
                 // Create the element
-                MazeDrawListAnimatedElement* element = new MazeDrawListAnimatedElement(get_maze_draw_list(line, column), 0);
+                MazeDrawListAnimatedElement* element = new_animated_map_element(line, column, 0);
                 if (!element)
                 {
                     // Error failed to create object
@@ -230,7 +259,7 @@ void PresentationMaze::load_current_maze(lua_State* L)
             	if(glyph != 0x20)
             	{
             		// layer defaults to 100, will be updated for floor glyphs in map_transform()
-            		current_maze_element_pointers[line][column] = new MazeDrawListElement(get_maze_draw_list(line, column), glyph, 100);
+            		current_maze_element_pointers[line][column] = new_map_element(line, column, glyph, 100);
             	}
             }
 
@@ -240,6 +269,8 @@ void PresentationMaze::load_current_maze(lua_State* L)
 		lua_pop(L, 1);	// drop the line table, we've used it
 	}
 
+	light_map.set_size(current_line_max+1, current_column_max+1);
+	light_map.recompute_all();
 }
 
 int PresentationMaze::calculate_cell_size()
@@ -427,6 +458,9 @@ void PresentationMaze::print_selected(MyGraphics* gr, int start_line, int lines_
 	// but still 10x10 otherwise
 	int tile_size = 1;
 
+	// bring any lighting changes up to date before we draw
+	light_map.update();
+
 	gr->set_viewport(viewport);
 
 	int integer_part_of_offset_line = (int)offset_line;
@@ -540,8 +574,21 @@ void PresentationMaze::set_render_option(int ro_in)
 
 void PresentationMaze::render_map_data(MyGraphics& gr, int map_line, int map_column, pos_t screen_line, pos_t screen_column, int start_layer, int end_layer, bool overdraw)
 {
-	gr.set_fg_colour(maze_foreground[map_line][map_column]);
-	gr.set_bg_fullcolour(maze_background[map_line][map_column]);
+	if(light_map.is_enabled())
+	{
+		SDL_Colour light = light_map.get_light(map_line, map_column);
+		SDL_Colour fg = get_rgb_from_simple_colour(maze_foreground[map_line][map_column]);
+		SDL_Colour bg = maze_background[map_line][map_column];
+		fg.r = (fg.r * light.r) / 255; fg.g = (fg.g * light.g) / 255; fg.b = (fg.b * light.b) / 255;
+		bg.r = (bg.r * light.r) / 255; bg.g = (bg.g * light.g) / 255; bg.b = (bg.b * light.b) / 255;
+		gr.set_fg_fullcolour(fg);
+		gr.set_bg_fullcolour(bg);
+	}
+	else
+	{
+		gr.set_fg_colour(maze_foreground[map_line][map_column]);
+		gr.set_bg_fullcolour(maze_background[map_line][map_column]);
+	}
 
 
 	// Need overdraw for hex tiles to work
@@ -574,7 +621,7 @@ void PresentationMaze::set_glyph(int line, int column, int glyph, int layer, int
 
 	if(current_maze_element_pointers[line][column] == nullptr)
 	{
-		current_maze_element_pointers[line][column] = new MazeDrawListElement(get_maze_draw_list(line, column), glyph, glyph==0x20?0:100);
+		current_maze_element_pointers[line][column] = new_map_element(line, column, glyph, glyph==0x20?0:100);
 	}
 	else
 	{
@@ -699,6 +746,15 @@ void PresentationMaze::set_wall_transparency(int line, int column, unsigned int
 		// wall is a bump - no NORTH - SOUTH visibility either
 		transparency[line][column].SetOpaque(NORTH, SOUTH);
 	}
+
+	light_map.cell_changed(line, column);
+}
+
+// opaque across the cell in both directions, i.e. a wall rather than a bump
+bool PresentationMaze::is_opaque(int line, int column)
+{
+	Transparency& t = transparency[line][column];
+	return not t.IsTransparent(NORTH, SOUTH) and not t.IsTransparent(EAST, WEST);
 }
 
 //#define LOS_DEBUG
@@ -40,6 +40,7 @@
 #include <list>
 #include "MazeConstants.h"
 #include "GameApplication.h"
+#include "LightMap.h"
 #include <map>
 
 struct lua_State;
@@ -102,11 +103,13 @@ public:
 
 	MazeDrawList* get_maze_draw_list(int line, int column) { return &(maze_draw_list[line][column]); }
 	DrawList* get_mobs_draw_list();
+	LightMap* get_light_map() { return &light_map; }
 
 	void set_view_layer(int line, int column, int layer);
 	
 	void set_wall_transparency(int line, int column, unsigned int directions_map);
 	bool line_of_sight(pos_t line1, pos_t column1, pos_t line2, pos_t column2);
+	bool is_opaque(int line, int column);
 
 	void set_rect(int left, int top, int right, int bottom);
 	void zoom(bool zoom_in);
@@ -129,6 +132,8 @@ public:
 
 private:
 	void delete_all_cmep();
+	MazeDrawListElement* new_map_element(int line, int column, int glyph, int layer);
+	MazeDrawListAnimatedElement* new_animated_map_element(int line, int column, int layer);
 	void update_viewport_and_dimensions();
 	int calculate_cell_size();
 	
@@ -140,6 +145,11 @@ private:
 
 	// store pointers to maze list elements so we can delete them
 	MazeDrawListElement* current_maze_element_pointers[MazeConstants::maze_height_max][MazeConstants::maze_width_max];
+	// the base map elements come from here, so a whole map can be released in one go
+	FixedBlockPool map_element_pool;
+	// highest line/column that has ever had a map element, so we don't sweep the whole array
+	int cmep_line_max;
+	int cmep_column_max;
 
 
 	// list of mobs (and anything else you care to draw this way)
@@ -152,6 +162,9 @@ private:
 	// transparency of map elements
 	Transparency transparency[MazeConstants::maze_height_max][MazeConstants::maze_width_max];
 
+	// lighting, propagated over the transparency above
+	LightMap light_map;
+
 	int current_line_max;
 	int current_column_max;	
 	
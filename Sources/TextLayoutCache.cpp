@@ -0,0 +1,191 @@
+/*
+ * TextLayoutCache.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#include "TextLayoutCache.h"
+#include "GlyphArray.h"
+#include "lua.h"
+#include <cstring>
+#ifdef _MSC_VER
+#include <ciso646>   // Visual Studio is not C++ standards complaint...
+#endif
+
+// +---------------------------------------------------------------------------
+// | TITLE: TextLayoutCache
+// | AUTHOR(s): agent
+// | DATE STARTED: 19 Oct 2026
+// +
+// | DESCRIPTION: A screen of text is a few hundred layouts at most, and a
+// | help page a few thousand glyphs.
+// +---------------------------------------------------------------------------
+TextLayoutCache::TextLayoutCache()
+: glyph_count(0)
+, max_entries(256)
+, max_glyphs(65536)
+, hits(0)
+, misses(0)
+, evictions(0)
+{
+}
+
+const TextLayoutCache::Layout& TextLayoutCache::find(const char* text, size_t length, pos_t line, pos_t column, const TextWrap& wrap)
+{
+	make_key(text, length, line, column, wrap);
+	index_t::iterator it = index.find(key);
+	if(it != index.end())
+	{
+		hits++;
+		entries.splice(entries.begin(), entries, it->second);		// now most recent
+		return it->second->layout;
+	}
+
+	misses++;
+	lay_out(text, length, line, column, wrap, uncached);
+	size_t glyphs = uncached.glyphs.size();
+	if(max_entries == 0 or glyphs > max_glyphs)
+	{
+		return uncached;
+	}
+
+	trim(max_entries - 1, max_glyphs - glyphs);
+	entries.push_front(Entry());
+	Layout& layout = entries.front().layout;
+	layout.glyphs.swap(uncached.glyphs);
+	layout.lines.swap(uncached.lines);
+	layout.columns.swap(uncached.columns);
+	layout.end_line = uncached.end_line;
+	layout.end_column = uncached.end_column;
+	std::pair<index_t::iterator, bool> inserted = index.insert(index_t::value_type(key, entries.begin()));
+	entries.front().key = &inserted.first->first;		// keys don't move on a rehash
+	glyph_count += glyphs;
+	return entries.front().layout;
+}
+
+// Steps the cursor exactly like MyGraphics_render::skip_1_forward, which
+// print() calls after every glyph.
+void TextLayoutCache::lay_out(const char* text, size_t length, pos_t line, pos_t column, const TextWrap& wrap, Layout& out)
+{
+	out.glyphs.clear();
+	GlyphArray::decode_utf8(text, length, out.glyphs);
+	size_t count = out.glyphs.size();
+	out.lines.resize(count);
+	out.columns.resize(count);
+	for(size_t i = 0; i < count; i++)
+	{
+		out.lines[i] = line;
+		out.columns[i] = column;
+		column = column+1;
+		if(wrap.on)
+		{
+			if(column >= wrap.column_end)
+			{
+				column = wrap.column_start;
+				line++;
+				if(line >= wrap.line_end)
+				{
+					line = wrap.line_start;
+				}
+			}
+		}
+	}
+	out.end_line = line;
+	out.end_column = column;
+}
+
+// the position and wrap settings, then the text
+void TextLayoutCache::make_key(const char* text, size_t length, pos_t line, pos_t column, const TextWrap& wrap)
+{
+	char settings[2*sizeof(pos_t) + 4*sizeof(double) + 1];
+	char* p = settings;
+	std::memcpy(p, &line, sizeof(pos_t)); p += sizeof(pos_t);
+	std::memcpy(p, &column, sizeof(pos_t)); p += sizeof(pos_t);
+	if(wrap.on)
+	{
+		std::memcpy(p, &wrap.line_start, sizeof(double)); p += sizeof(double);
+		std::memcpy(p, &wrap.line_end, sizeof(double)); p += sizeof(double);
+		std::memcpy(p, &wrap.column_start, sizeof(double)); p += sizeof(double);
+		std::memcpy(p, &wrap.column_end, sizeof(double)); p += sizeof(double);
+	}
+	else
+	{
+		// the limits don't matter when it's not wrapping
+		std::memset(p, 0, 4*sizeof(double)); p += 4*sizeof(double);
+	}
+	*p++ = wrap.on ? 1 : 0;
+
+	key.assign(settings, p - settings);
+	key.append(text, length);
+}
+
+void TextLayoutCache::trim(size_t keep_entries, size_t keep_glyphs)
+{
+	while(not entries.empty() and (entries.size() > keep_entries or glyph_count > keep_glyphs))
+	{
+		Entry& last = entries.back();
+		glyph_count -= last.layout.glyphs.size();
+		index.erase(*last.key);
+		entries.pop_back();
+		evictions++;
+	}
+}
+
+void TextLayoutCache::clear()
+{
+	entries.clear();
+	index.clear();
+	glyph_count = 0;
+}
+
+void TextLayoutCache::set_capacity(int entries_in, int glyphs_in)
+{
+	max_entries = entries_in < 0 ? 0 : entries_in;
+	max_glyphs = glyphs_in < 0 ? 0 : glyphs_in;
+	trim(max_entries, max_glyphs);
+}
+
+void TextLayoutCache::reset_stats()
+{
+	hits = 0;
+	misses = 0;
+	evictions = 0;
+}
+
+int TextLayoutCache::stats(lua_State* L)
+{
+	lua_createtable(L, 0, 7);
+	lua_pushnumber(L, static_cast<lua_Number>(hits)); lua_setfield(L, -2, "hits");
+	lua_pushnumber(L, static_cast<lua_Number>(misses)); lua_setfield(L, -2, "misses");
+	lua_pushnumber(L, static_cast<lua_Number>(evictions)); lua_setfield(L, -2, "evictions");
+	lua_pushnumber(L, static_cast<lua_Number>(entries.size())); lua_setfield(L, -2, "entries");
+	lua_pushnumber(L, static_cast<lua_Number>(glyph_count)); lua_setfield(L, -2, "glyphs");
+	lua_pushnumber(L, static_cast<lua_Number>(max_entries)); lua_setfield(L, -2, "max_entries");
+	lua_pushnumber(L, static_cast<lua_Number>(max_glyphs)); lua_setfield(L, -2, "max_glyphs");
+	return 1;
+}
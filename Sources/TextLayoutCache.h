@@ -0,0 +1,120 @@
+/*
+ * TextLayoutCache.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#ifndef TEXT_LAYOUT_CACHE_H
+#define TEXT_LAYOUT_CACHE_H
+
+#include "SDL.h"
+#include "BasicTypes.h"
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+struct lua_State;
+
+// The wrap settings that decide where text goes (see MyGraphics::skip_1_forward)
+struct TextWrap
+{
+	bool on;
+	double line_start;
+	double line_end;
+	double column_start;
+	double column_end;
+};
+
+// Laid out text for MyGraphics print_string. Decoding the UTF-8 and stepping
+// the cursor along with the wrap settings is the same every frame for text
+// that doesn't change (dialogue, help pages), so the glyphs and the cell each
+// one lands in are kept here, keyed by the text, the start position and the
+// wrap settings. Colours, alpha and dim aren't part of the layout - they're
+// applied when it's drawn - so changing them still hits.
+//
+// Least recently used layouts are thrown away past max_entries layouts or
+// max_glyphs glyphs in total. Main thread only, like drawing.
+class TextLayoutCache
+{
+public:
+	struct Layout
+	{
+		std::vector<Uint32> glyphs;
+		std::vector<pos_t> lines;
+		std::vector<pos_t> columns;
+		pos_t end_line;			// where the cursor is left
+		pos_t end_column;
+	};
+
+	TextLayoutCache();
+
+	// the layout is good until the next call
+	const Layout& find(const char* text, size_t length, pos_t line, pos_t column, const TextWrap& wrap);
+
+	void clear();
+	void set_capacity(int max_entries, int max_glyphs);	// 0 entries turns caching off
+	void reset_stats();
+
+	Uint64 get_hits() { return hits; }
+	Uint64 get_misses() { return misses; }
+	int get_entry_count() { return static_cast<int>(entries.size()); }
+
+	// cache:stats() -> { hits=, misses=, evictions=, entries=, glyphs=, max_entries=, max_glyphs= }
+	int stats(lua_State* L);
+
+private:
+	// lets not have these copy constructed or assigned
+	TextLayoutCache(const TextLayoutCache&);
+	TextLayoutCache& operator=(const TextLayoutCache&);
+
+	struct Entry
+	{
+		const std::string* key;		// the key in index
+		Layout layout;
+	};
+	typedef std::list<Entry> entry_list_t;
+	typedef std::unordered_map<std::string, entry_list_t::iterator> index_t;
+
+	static void lay_out(const char* text, size_t length, pos_t line, pos_t column, const TextWrap& wrap, Layout& out);
+	void make_key(const char* text, size_t length, pos_t line, pos_t column, const TextWrap& wrap);
+	void trim(size_t keep_entries, size_t keep_glyphs);
+
+	entry_list_t entries;		// most recently used first
+	index_t index;
+	std::string key;			// scratch
+	Layout uncached;			// for text too big to keep
+	size_t glyph_count;
+	size_t max_entries;
+	size_t max_glyphs;
+
+	Uint64 hits;
+	Uint64 misses;
+	Uint64 evictions;
+};
+
+#endif
@@ -0,0 +1,164 @@
+/*
+ * ffpack.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+// ffpack - builds an AssetArchive (.ffpk) from a data directory.
+//
+//   ffpack [-store] <archive.ffpk> <data directory>
+//
+// Every file under the data directory goes in, named relative to it, so
+// "data/scripts/main.lua" is "scripts/main.lua" in the archive. Hidden files
+// (starting with '.') and other archives (*.ffpk) are skipped. -store turns
+// compression off.
+//
+// This is a separate command line program, not part of the game. It needs
+// AssetArchive.cpp, AppResourcePath.cpp, Utilities.cpp, lodepng.cpp and SDL2,
+// e.g. (all one line)
+//   c++ -std=c++11 -O2 -ISources -ISources/GameUtilities -IThird_Party_Sources
+//       Sources/Tools/ffpack.cpp Sources/GameUtilities/AssetArchive.cpp
+//       Sources/GameUtilities/AppResourcePath.cpp Sources/Utilities.cpp
+//       Third_Party_Sources/lodepng.cpp `sdl2-config --cflags --libs` -o ffpack
+//
+// The game mounts data/assets.ffpk at startup if it exists.
+
+#include "SDL.h"
+#include "AssetArchive.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#ifdef _MSC_VER
+#include <ciso646>   // Visual Studio is not C++ standards complaint...
+#endif
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <dirent.h>
+	#include <sys/stat.h>
+#endif
+
+// a plain command line program, so no SDL_main
+#ifdef main
+#undef main
+#endif
+
+// add every file under root/relative to names
+static bool find_files(const std::string& root, const std::string& relative, std::vector<std::string>& names)
+{
+	std::string dir = relative.empty() ? root : root + "/" + relative;
+#ifdef _WIN32
+	WIN32_FIND_DATAA found;
+	HANDLE h = FindFirstFileA((dir + "/*").c_str(), &found);
+	if(h == INVALID_HANDLE_VALUE) { return false; }
+	do {
+		std::string name = found.cFileName;
+		if(name[0] == '.') continue;
+		std::string path = relative.empty() ? name : relative + "/" + name;
+		if(found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+		{
+			if(not find_files(root, path, names)) { FindClose(h); return false; }
+		}
+		else
+		{
+			names.push_back(path);
+		}
+	} while(FindNextFileA(h, &found));
+	FindClose(h);
+#else
+	DIR* d = opendir(dir.c_str());
+	if(d == 0) { return false; }
+	while(struct dirent* entry = readdir(d))
+	{
+		std::string name = entry->d_name;
+		if(name[0] == '.') continue;
+		std::string path = relative.empty() ? name : relative + "/" + name;
+		struct stat st;
+		if(stat((root + "/" + path).c_str(), &st) != 0) continue;
+		if(S_ISDIR(st.st_mode))
+		{
+			if(not find_files(root, path, names)) { closedir(d); return false; }
+		}
+		else if(S_ISREG(st.st_mode))
+		{
+			names.push_back(path);
+		}
+	}
+	closedir(d);
+#endif
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	bool compress = true;
+	int arg = 1;
+	if(arg < argc and strcmp(argv[arg], "-store") == 0)
+	{
+		compress = false;
+		arg++;
+	}
+	if(argc - arg != 2)
+	{
+		fprintf(stderr, "usage: ffpack [-store] <archive.ffpk> <data directory>\n");
+		return 1;
+	}
+	std::string archive = argv[arg];
+	std::string root = argv[arg+1];
+
+	std::vector<std::string> names;
+	if(not find_files(root, "", names))
+	{
+		fprintf(stderr, "ffpack: couldn't read directory %s\n", root.c_str());
+		return 1;
+	}
+	// Don't pack an old archive into the new one - pack() truncates it while
+	// it's being read. Comparing paths misses "data//assets.ffpk" and the like,
+	// so just leave out every archive.
+	for(size_t i = names.size(); i > 0; i--)
+	{
+		const std::string& name = names[i-1];
+		if(name.size() >= 5 and name.compare(name.size() - 5, 5, ".ffpk") == 0)
+		{
+			printf("ffpack: skipping archive %s\n", name.c_str());
+			names.erase(names.begin() + (i-1));
+		}
+	}
+
+	std::string error = AssetArchive::pack(archive, root, names, compress);
+	if(not error.empty())
+	{
+		fprintf(stderr, "ffpack: %s\n", error.c_str());
+		return 1;
+	}
+	printf("ffpack: %lu files into %s\n", static_cast<unsigned long>(names.size()), archive.c_str());
+	return 0;
+}
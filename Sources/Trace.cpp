@@ -0,0 +1,385 @@
+/*
+ * Trace.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#include "Trace.h"
+#include "SaveDataPath.h"
+#include "VirtualFileSystem.h"
+#include "Utilities.h"
+#include "lua.h"
+#include "lauxlib.h"
+#include <vector>
+#include <set>
+#include <cstdio>
+#include <cstring>
+
+volatile bool Trace::enabled_flag = true;
+
+namespace {
+
+	struct TraceEvent
+	{
+		const char* name;
+		Uint64 start;
+		Uint64 end;
+	};
+
+	// One per thread. Only the owning thread writes events. Anyone can read
+	// them: a reader copies what it wants, then checks the write count again
+	// and throws away anything the writer might have overwritten meanwhile.
+	struct TraceBuffer
+	{
+		enum { capacity = 16384 };		// power of 2; ~10 seconds of a busy thread
+		TraceEvent events[capacity];
+		SDL_atomic_t published;			// events written, ever (wraps)
+		Uint32 count;					// the owner's copy of the above
+		SDL_atomic_t generation;		// goes up each time the buffer changes hands
+		SDL_threadID thread;
+		char thread_name[32];
+
+		// zones opened from Lua (C++ zones keep their start on the stack)
+		enum { max_lua_depth = 32 };
+		int lua_depth;
+		const char* lua_names[max_lua_depth];
+		Uint64 lua_starts[max_lua_depth];
+
+		TraceBuffer* next_free;
+	};
+
+	SDL_atomic_t buffer_tls;			// set once, then read without the lock
+	SDL_SpinLock buffers_lock = 0;		// for all of these
+	std::vector<TraceBuffer*>* all_buffers = 0;
+	TraceBuffer* free_buffers = 0;
+	std::set<std::string>* interned = 0;
+
+	void thread_finished(void* data)
+	{
+		TraceBuffer* b = static_cast<TraceBuffer*>(data);
+		SDL_AtomicLock(&buffers_lock);
+		b->next_free = free_buffers;
+		free_buffers = b;
+		SDL_AtomicUnlock(&buffers_lock);
+	}
+
+	SDL_TLSID create_tls()
+	{
+		SDL_AtomicLock(&buffers_lock);
+		SDL_TLSID tls = static_cast<SDL_TLSID>(SDL_AtomicGet(&buffer_tls));
+		if(tls == 0)		// nobody beat us to it
+		{
+			tls = SDL_TLSCreate();
+			if(tls == 0)
+			{
+				Utilities::fatalError("Trace failed to create thread local storage (SDL Error %s)", SDL_GetError());
+			}
+			all_buffers = new std::vector<TraceBuffer*>;
+			SDL_AtomicSet(&buffer_tls, static_cast<int>(tls));
+		}
+		SDL_AtomicUnlock(&buffers_lock);
+		return tls;
+	}
+
+	TraceBuffer* buffer_for_this_thread()
+	{
+		SDL_TLSID tls = static_cast<SDL_TLSID>(SDL_AtomicGet(&buffer_tls));
+		if(tls == 0)
+		{
+			tls = create_tls();
+		}
+
+		TraceBuffer* b = static_cast<TraceBuffer*>(SDL_TLSGet(tls));
+		if(b)
+		{
+			return b;
+		}
+
+		// threads come and go (LuaThreads), so buffers are recycled. The
+		// old thread's events go with it, rather than appear under the new
+		// thread's id.
+		SDL_AtomicLock(&buffers_lock);
+		b = free_buffers;
+		if(b)
+		{
+			free_buffers = b->next_free;
+			SDL_AtomicIncRef(&b->generation);
+		}
+		else
+		{
+			b = new TraceBuffer;
+			SDL_AtomicSet(&b->generation, 0);
+			all_buffers->push_back(b);
+		}
+		SDL_AtomicSet(&b->published, 0);
+		b->count = 0;
+		b->next_free = 0;
+		b->lua_depth = 0;
+		b->thread = SDL_ThreadID();
+		snprintf(b->thread_name, sizeof(b->thread_name), "thread %lu", static_cast<unsigned long>(b->thread));
+		SDL_AtomicUnlock(&buffers_lock);
+
+		if(SDL_TLSSet(tls, b, thread_finished) != 0)
+		{
+			Utilities::fatalError("Trace failed to set thread local storage (SDL Error %s)", SDL_GetError());
+		}
+		return b;
+	}
+
+	double ticks_to_us(Uint64 ticks)
+	{
+		return double(ticks) * 1000000.0 / double(SDL_GetPerformanceFrequency());
+	}
+
+	void append_json_string(std::string& out, const char* s)
+	{
+		out += '"';
+		for(; *s; s++)
+		{
+			unsigned char c = static_cast<unsigned char>(*s);
+			if(c == '"' or c == '\\')
+			{
+				out += '\\';
+				out += *s;
+			}
+			else if(c < 0x20)
+			{
+				char escaped[8];
+				snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+				out += escaped;
+			}
+			else
+			{
+				out += *s;
+			}
+		}
+		out += '"';
+	}
+}
+
+void Trace::record(const char* name, Uint64 start, Uint64 end)
+{
+	TraceBuffer* b = buffer_for_this_thread();
+	TraceEvent& e = b->events[b->count & (TraceBuffer::capacity - 1)];
+	e.name = name;
+	e.start = start;
+	e.end = end;
+	b->count++;
+	SDL_AtomicSet(&b->published, static_cast<int>(b->count));		// after the event (full barrier)
+}
+
+void Trace::set_thread_name(const char* name)
+{
+	TraceBuffer* b = buffer_for_this_thread();
+	SDL_AtomicLock(&buffers_lock);
+	snprintf(b->thread_name, sizeof(b->thread_name), "%s", name ? name : "?");
+	SDL_AtomicUnlock(&buffers_lock);
+}
+
+const char* Trace::intern(const std::string& name)
+{
+	SDL_AtomicLock(&buffers_lock);
+	if(interned == 0)
+	{
+		interned = new std::set<std::string>;
+	}
+	const char* result = interned->insert(name).first->c_str();
+	SDL_AtomicUnlock(&buffers_lock);
+	return result;
+}
+
+std::string Trace::chrome_json(double seconds)
+{
+	Uint64 now = SDL_GetPerformanceCounter();
+	Uint64 window = static_cast<Uint64>(seconds * SDL_GetPerformanceFrequency());
+	Uint64 since = (seconds > 0 and window < now) ? now - window : 0;
+
+	// only hold the lock long enough to see which buffers there are - the
+	// events themselves are safe to read without it (see TraceBuffer)
+	struct Snapshot
+	{
+		TraceBuffer* buffer;
+		int generation;
+		unsigned long tid;
+		char thread_name[sizeof(TraceBuffer::thread_name)];
+	};
+	std::vector<Snapshot> buffers;
+	SDL_AtomicLock(&buffers_lock);
+	if(all_buffers)
+	{
+		buffers.resize(all_buffers->size());
+		for(size_t i = 0; i < buffers.size(); i++)
+		{
+			TraceBuffer* b = (*all_buffers)[i];
+			buffers[i].buffer = b;
+			buffers[i].generation = SDL_AtomicGet(&b->generation);
+			buffers[i].tid = static_cast<unsigned long>(b->thread);
+			memcpy(buffers[i].thread_name, b->thread_name, sizeof(buffers[i].thread_name));
+		}
+	}
+	SDL_AtomicUnlock(&buffers_lock);
+
+	std::vector<TraceEvent> events;
+	std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool first = true;
+	char line[128];
+
+	for(size_t i = 0; i < buffers.size(); i++)
+	{
+		TraceBuffer* b = buffers[i].buffer;
+		unsigned long tid = buffers[i].tid;
+
+		// copy, then see what the writer got to meanwhile. The slot after
+		// the last published event might be half written, so leave it out.
+		const Uint32 capacity = static_cast<Uint32>(TraceBuffer::capacity);
+		Uint32 written = static_cast<Uint32>(SDL_AtomicGet(&b->published));
+		Uint32 available = written < capacity ? written : capacity - 1;
+		events.resize(available);
+		for(Uint32 n = 0; n < available; n++)
+		{
+			events[n] = b->events[(written - available + n) & (capacity - 1)];
+		}
+		Uint32 written_after = static_cast<Uint32>(SDL_AtomicGet(&b->published));
+		Uint32 overwritten = written_after - written;		// slots at the start we can't trust
+		if(overwritten >= available) continue;
+		if(SDL_AtomicGet(&b->generation) != buffers[i].generation) continue;	// another thread's now
+
+		snprintf(line, sizeof(line), "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%lu,\"args\":{\"name\":", first ? "" : ",\n", tid);
+		out += line;
+		append_json_string(out, buffers[i].thread_name);
+		out += "}}";
+		first = false;
+
+		for(Uint32 n = overwritten; n < available; n++)
+		{
+			const TraceEvent& e = events[n];
+			if(e.end < since or e.end < e.start) continue;
+			out += ",\n{\"ph\":\"X\",\"name\":";
+			append_json_string(out, e.name);
+			snprintf(line, sizeof(line), ",\"pid\":1,\"tid\":%lu,\"ts\":%.3f,\"dur\":%.3f}",
+					 tid, ticks_to_us(e.start), ticks_to_us(e.end - e.start));
+			out += line;
+		}
+	}
+
+	out += "\n]}\n";
+	return out;
+}
+
+bool Trace::save(const char* filename, double seconds)
+{
+	SaveDataPath path(filename);
+	if(path.c_str() == 0) { return false; }
+
+	std::string json = chrome_json(seconds);
+	FILE* f = fopen(path.c_str(), "w");
+	if(f == 0) { return false; }
+	bool ok = fwrite(json.data(), 1, json.size(), f) == json.size();
+	ok = (fclose(f) == 0) and ok;
+	VirtualFileSystem::notify_written(filename);
+	return ok;
+}
+
+
+//
+// Lua interface
+//
+int Trace::lua_begin_zone(lua_State* L)
+{
+	const char* name = intern(luaL_checkstring(L, 1));
+	TraceBuffer* b = buffer_for_this_thread();
+	if(b->lua_depth >= TraceBuffer::max_lua_depth)
+	{
+		return luaL_error(L, "Trace.begin_zone - zones nested more than %d deep", int(TraceBuffer::max_lua_depth));
+	}
+	b->lua_names[b->lua_depth] = name;
+	b->lua_starts[b->lua_depth] = enabled() ? SDL_GetPerformanceCounter() : 0;
+	b->lua_depth++;
+	return 0;
+}
+
+int Trace::lua_end_zone(lua_State* L)
+{
+	TraceBuffer* b = buffer_for_this_thread();
+	if(b->lua_depth == 0)
+	{
+		return luaL_error(L, "Trace.end_zone without Trace.begin_zone");
+	}
+	b->lua_depth--;
+	Uint64 start = b->lua_starts[b->lua_depth];
+	if(start)
+	{
+		record(b->lua_names[b->lua_depth], start, SDL_GetPerformanceCounter());
+	}
+	return 0;
+}
+
+int Trace::lua_zone(lua_State* L)
+{
+	const char* name = intern(luaL_checkstring(L, 1));
+	luaL_checktype(L, 2, LUA_TFUNCTION);
+	lua_remove(L, 1);		// function and arguments left
+
+	TraceZone zone(name);
+	int status = lua_pcall(L, lua_gettop(L) - 1, LUA_MULTRET, 0);
+	zone.end();
+	if(status != LUA_OK)
+	{
+		return lua_error(L);		// pass it on
+	}
+	return lua_gettop(L);
+}
+
+int Trace::lua_enable(lua_State* L)
+{
+	enable(lua_toboolean(L, 1) != 0);
+	return 0;
+}
+
+int Trace::lua_enabled(lua_State* L)
+{
+	lua_pushboolean(L, enabled());
+	return 1;
+}
+
+int Trace::lua_set_thread_name(lua_State* L)
+{
+	set_thread_name(luaL_checkstring(L, 1));
+	return 0;
+}
+
+int Trace::lua_save(lua_State* L)
+{
+	const char* filename = luaL_checkstring(L, 1);
+	if(not save(filename, luaL_optnumber(L, 2, 5)))
+	{
+		return luaL_error(L, "Trace.save - couldn't write %s", filename);
+	}
+	lua_pushstring(L, SaveDataPath(filename).c_str());
+	return 1;
+}
@@ -0,0 +1,128 @@
+/*
+ * Trace.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "SDL.h"
+#include <string>
+#ifdef _MSC_VER
+#include <ciso646>   // Visual Studio is not C++ standards complaint...
+#endif
+struct lua_State;
+
+// Timeline tracing. Zones (a name, a start and an end) are recorded into a
+// ring buffer per thread, so recording never takes a lock, and the last few
+// seconds can be saved as a Chrome trace (chrome://tracing, or
+// ui.perfetto.dev) at any time - e.g. just after a hitch.
+//
+// In C++:
+//		FF_TRACE_ZONE("update");			// until the end of the scope
+//		TraceZone zone("events"); ... zone.end();
+//		FF_TRACE_THREAD_NAME("audio");
+// Zone names must be string literals (or otherwise live forever) - see
+// Trace::intern() for anything else.
+//
+// From Lua:
+//		Trace.begin_zone(name) ... Trace.end_zone()
+//		Trace.zone(name, f, ...) - calls f(...) inside a zone, returns its results
+//		Trace.enable(bool), Trace.enabled()
+//		Trace.set_thread_name(name)
+//		Trace.save(filename, [seconds=5]) - into the save data directory, returns the path
+//
+// Recording is on by default, and costs two SDL_GetPerformanceCounter() calls
+// and one atomic store per zone. Build with FF_TRACE=0 to remove them
+// altogether.
+#ifndef FF_TRACE
+#define FF_TRACE 1
+#endif
+
+class Trace
+{
+public:
+	static bool enabled() { return enabled_flag; }
+	static void enable(bool on) { enabled_flag = on; }
+
+	static void record(const char* name, Uint64 start, Uint64 end);
+	static void set_thread_name(const char* name);
+	static const char* intern(const std::string& name);		// a copy that lives forever
+
+	// zones that ended in the last 'seconds', as Chrome trace event JSON
+	static std::string chrome_json(double seconds);
+	static bool save(const char* filename, double seconds);	// relative to the save data directory
+
+	// for Lua
+	static int lua_begin_zone(lua_State* L);
+	static int lua_end_zone(lua_State* L);
+	static int lua_zone(lua_State* L);
+	static int lua_enable(lua_State* L);
+	static int lua_enabled(lua_State* L);
+	static int lua_set_thread_name(lua_State* L);
+	static int lua_save(lua_State* L);
+
+private:
+	static volatile bool enabled_flag;		// only ever a hint, so no need for atomics
+};
+
+class TraceZone
+{
+public:
+	explicit TraceZone(const char* zone_name)
+	: name(zone_name), start((FF_TRACE and Trace::enabled()) ? SDL_GetPerformanceCounter() : 0) {}
+	~TraceZone() { end(); }
+	void end()
+	{
+		if(start)
+		{
+			Trace::record(name, start, SDL_GetPerformanceCounter());
+			start = 0;
+		}
+	}
+private:
+	// lets not have these copy constructed or assigned
+	TraceZone(const TraceZone&);
+	TraceZone& operator=(const TraceZone&);
+
+	const char* name;
+	Uint64 start;
+};
+
+#if FF_TRACE
+	#define FF_TRACE_CONCAT2(a, b) a ## b
+	#define FF_TRACE_CONCAT(a, b) FF_TRACE_CONCAT2(a, b)
+	#define FF_TRACE_ZONE(name) TraceZone FF_TRACE_CONCAT(trace_zone_, __LINE__)(name)
+	#define FF_TRACE_THREAD_NAME(name) Trace::set_thread_name(name)
+#else
+	#define FF_TRACE_ZONE(name) do {} while(0)
+	#define FF_TRACE_THREAD_NAME(name) do {} while(0)
+#endif
+
+#endif
@@ -0,0 +1,389 @@
+/*
+ * Tween.cpp
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#include "Tween.h"
+#include "DrawList.h"
+#include "Utilities.h"
+#include <cmath>
+#include <set>
+#ifdef _MSC_VER
+#include <ciso646>   // Visual Studio is not C++ standards complaint...
+#endif
+
+TweenManager::TweenManager()
+: next_id(1)
+{
+}
+
+TweenManager::~TweenManager()
+{
+}
+
+TweenManager::property_t TweenManager::property_from_string(const std::string& name)
+{
+	if(name == "line") return prop_line;
+	if(name == "column") return prop_column;
+	if(name == "angle") return prop_angle;
+	if(name == "size_ratio") return prop_size_ratio;
+	if(name == "alpha") return prop_alpha;
+	return prop_invalid;
+}
+
+TweenManager::easing_t TweenManager::easing_from_string(const std::string& name)
+{
+	if(name == "" or name == "linear") return linear;
+	if(name == "in_quad") return in_quad;
+	if(name == "out_quad") return out_quad;
+	if(name == "in_out_quad") return in_out_quad;
+	if(name == "in_cubic") return in_cubic;
+	if(name == "out_cubic") return out_cubic;
+	if(name == "in_out_cubic") return in_out_cubic;
+	if(name == "in_sine") return in_sine;
+	if(name == "out_sine") return out_sine;
+	if(name == "in_out_sine") return in_out_sine;
+	if(name == "out_back") return out_back;
+	if(name == "out_bounce") return out_bounce;
+	return easing_invalid;
+}
+
+// t is 0.0 to 1.0, result is (mostly) 0.0 to 1.0
+double TweenManager::ease(easing_t e, double t)
+{
+	switch(e)
+	{
+		case in_quad:		return t*t;
+		case out_quad:		return t*(2-t);
+		case in_out_quad:	return t < 0.5 ? 2*t*t : -1 + (4-2*t)*t;
+		case in_cubic:		return t*t*t;
+		case out_cubic:		{ double u = t-1; return u*u*u + 1; }
+		case in_out_cubic:	return t < 0.5 ? 4*t*t*t : (t-1)*(2*t-2)*(2*t-2) + 1;
+		case in_sine:		return 1 - std::cos(t * M_PI / 2);
+		case out_sine:		return std::sin(t * M_PI / 2);
+		case in_out_sine:	return -(std::cos(M_PI * t) - 1) / 2;
+		case out_back:
+		{
+			const double c1 = 1.70158;
+			const double c3 = c1 + 1;
+			double u = t-1;
+			return 1 + c3*u*u*u + c1*u*u;
+		}
+		case out_bounce:
+		{
+			const double n1 = 7.5625;
+			const double d1 = 2.75;
+			if(t < 1/d1) return n1*t*t;
+			if(t < 2/d1) { t -= 1.5/d1; return n1*t*t + 0.75; }
+			if(t < 2.5/d1) { t -= 2.25/d1; return n1*t*t + 0.9375; }
+			t -= 2.625/d1; return n1*t*t + 0.984375;
+		}
+		case linear:
+		default:
+			return t;
+	}
+}
+
+double TweenManager::get_property(DrawListElement* target, property_t p)
+{
+	switch(p)
+	{
+		case prop_line:			return target->get_line();
+		case prop_column:		return target->get_column();
+		case prop_angle:		return target->get_angle();
+		case prop_size_ratio:	return target->get_size_ratio();
+		case prop_alpha:		return target->get_alpha();
+		default:				return 0;
+	}
+}
+
+void TweenManager::set_property(DrawListElement* target, property_t p, double value)
+{
+	switch(p)
+	{
+		case prop_line:			target->set_line(static_cast<pos_t>(value)); break;
+		case prop_column:		target->set_column(static_cast<pos_t>(value)); break;
+		case prop_angle:		target->set_angle(value); break;
+		case prop_size_ratio:	target->set_size_ratio(value); break;
+		case prop_alpha:		target->set_alpha(static_cast<int>(value + 0.5)); break;
+		default: break;
+	}
+}
+
+int TweenManager::add_tween(DrawListElement* target, property_t property, double to, double seconds, easing_t easing, int after_id)
+{
+	if(not target or property == prop_invalid or easing == easing_invalid)
+	{
+		return 0;
+	}
+
+	// waiting on something that doesn't exist (or has already finished) means start now
+	if(after_id)
+	{
+		bool found = false;
+		for(size_t i = 0; i < tweens.size(); i++)
+		{
+			if(tweens[i].id == after_id) { found = true; break; }
+		}
+		if(not found) after_id = 0;
+	}
+
+	Tween t;
+	t.id = next_id++;
+	t.after_id = after_id;
+	t.target = target;
+	t.property = property;
+	t.easing = easing;
+	t.started = false;
+	t.from = 0;
+	t.to = to;
+	t.elapsed = 0;
+	t.duration = seconds < 0 ? 0 : seconds;
+	tweens.push_back(t);
+	target->tween_count++;
+
+	// 0 is 'failed', so skip it if we ever wrap
+	if(next_id <= 0) next_id = 1;
+	return t.id;
+}
+
+bool TweenManager::set_callback(int id, luabridge::LuaRef callback, luabridge::LuaRef arg)
+{
+	for(size_t i = 0; i < tweens.size(); i++)
+	{
+		if(tweens[i].id == id)
+		{
+			callbacks.erase(id);
+			if(callback.isFunction())
+			{
+				callback.force_to_main_state();
+				callbacks.insert(std::make_pair(id, Callback(callback, arg)));
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+// removes all the tweens for target, and anything waiting on those (which
+// would otherwise wait forever)
+void TweenManager::remove_tweens(DrawListElement* target)
+{
+	std::set<int> removed;
+	for(size_t i = 0; i < tweens.size(); i++)
+	{
+		if(tweens[i].target == target) removed.insert(tweens[i].id);
+	}
+	if(removed.empty()) return;
+
+	bool changed = true;
+	while(changed)
+	{
+		changed = false;
+		for(size_t i = 0; i < tweens.size(); i++)
+		{
+			const Tween& t = tweens[i];
+			if(t.after_id and removed.count(t.after_id) and not removed.count(t.id))
+			{
+				removed.insert(t.id);
+				changed = true;
+			}
+		}
+	}
+
+	size_t out = 0;
+	for(size_t i = 0; i < tweens.size(); i++)
+	{
+		if(removed.count(tweens[i].id))
+		{
+			tweens[i].target->tween_count--;
+			callbacks.erase(tweens[i].id);
+		}
+		else
+		{
+			tweens[out++] = tweens[i];
+		}
+	}
+	tweens.resize(out);
+}
+
+void TweenManager::stop_tweens(DrawListElement* target)
+{
+	remove_tweens(target);
+}
+
+void TweenManager::animate_glyphs(DrawListElement* target, const std::vector<int>& glyphs, double interval, bool loop)
+{
+	stop_glyph_animation(target);
+	if(not target or glyphs.empty()) return;
+
+	GlyphAnimation a;
+	a.target = target;
+	a.glyphs = glyphs;
+	a.interval = interval;
+	a.elapsed = 0;
+	a.index = 0;
+	a.loop = loop;
+	animations.push_back(a);
+	target->tween_count++;
+
+	target->set_glyph(glyphs[0]);
+}
+
+void TweenManager::stop_glyph_animation(DrawListElement* target)
+{
+	for(size_t i = 0; i < animations.size(); i++)
+	{
+		if(animations[i].target == target)
+		{
+			target->tween_count--;
+			animations[i] = animations.back();
+			animations.pop_back();
+			return;	// only ever one per element
+		}
+	}
+}
+
+void TweenManager::element_died(DrawListElement* target)
+{
+	remove_tweens(target);
+	stop_glyph_animation(target);
+}
+
+void TweenManager::update(double dt)
+{
+	if(dt < 0) dt = 0;
+
+	//
+	// tweens
+	//
+	for(size_t i = 0; i < tweens.size(); )
+	{
+		Tween& t = tweens[i];
+		if(t.after_id)
+		{
+			i++;
+			continue;
+		}
+		if(not t.started)
+		{
+			t.from = get_property(t.target, t.property);
+			t.started = true;
+		}
+
+		t.elapsed += dt;
+		double k = (t.duration > 0 and t.elapsed < t.duration) ? t.elapsed / t.duration : 1.0;
+		set_property(t.target, t.property, t.from + (t.to - t.from) * ease(t.easing, k));
+
+		if(k >= 1.0)
+		{
+			completed.push_back(t.id);
+			t.target->tween_count--;
+			tweens[i] = tweens.back();
+			tweens.pop_back();
+		}
+		else
+		{
+			i++;
+		}
+	}
+
+	//
+	// glyph animations
+	//
+	for(size_t i = 0; i < animations.size(); )
+	{
+		GlyphAnimation& a = animations[i];
+		a.elapsed += dt;
+		bool finished = false;
+		if(a.interval > 0)
+		{
+			while(a.elapsed >= a.interval)
+			{
+				a.elapsed -= a.interval;
+				a.index++;
+				if(a.index >= a.glyphs.size())
+				{
+					if(a.loop)
+					{
+						a.index = 0;
+					}
+					else
+					{
+						a.index = a.glyphs.size() - 1;
+						finished = true;
+						break;
+					}
+				}
+			}
+		}
+		a.target->set_glyph(a.glyphs[a.index]);
+
+		if(finished)
+		{
+			a.target->tween_count--;
+			animations[i] = animations.back();
+			animations.pop_back();
+		}
+		else
+		{
+			i++;
+		}
+	}
+
+	//
+	// chaining and callbacks - done last, since callbacks can add or remove tweens
+	//
+	if(completed.empty()) return;
+
+	std::vector<int> done;
+	done.swap(completed);
+	for(size_t c = 0; c < done.size(); c++)
+	{
+		int id = done[c];
+		for(size_t i = 0; i < tweens.size(); i++)
+		{
+			if(tweens[i].after_id == id) tweens[i].after_id = 0;
+		}
+
+		std::map<int, Callback>::iterator it = callbacks.find(id);
+		if(it != callbacks.end())
+		{
+			Callback cb = it->second;
+			callbacks.erase(it);
+			// a script error in one callback shouldn't stop the engine or the other tweens
+			try {
+				cb.callback(cb.arg, id);
+			}
+			catch (luabridge::LuaException const& e) {
+				Utilities::debugMessage("Tween callback failed with %s", e.what());
+			}
+		}
+	}
+}
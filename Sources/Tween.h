@@ -0,0 +1,126 @@
+/*
+ * Tween.h
+ *
+ *  Created on: 19 Oct 2026
+ *      Author: agent
+ *
+ * ------------------------------------------------------------------------------
+ * Copyright (c) 2014 Rob Probin and Tony Park
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * -----------------------------------------------------------------------------
+ * (This is the zlib License)
+ *
+ */
+
+#ifndef TWEEN_H_
+#define TWEEN_H_
+
+#include <vector>
+#include <map>
+#include <string>
+#include "lua.h"
+#include "lauxlib.h"
+#include "LuaBridge.h"
+
+struct DrawListElement;
+
+// Engine side tweening of DrawListElement properties, plus glyph cycling
+// animations (like MazeDrawListAnimatedElement, but for draw list elements).
+//
+// Lua sets them up once, and they are all advanced in one pass per frame by
+// the main loop, so moving sprites don't need any Lua calls per frame.
+class TweenManager
+{
+public:
+	TweenManager();
+	~TweenManager();
+
+	enum property_t { prop_line, prop_column, prop_angle, prop_size_ratio, prop_alpha, prop_invalid };
+	enum easing_t { linear, in_quad, out_quad, in_out_quad, in_cubic, out_cubic, in_out_cubic,
+					in_sine, out_sine, in_out_sine, out_back, out_bounce, easing_invalid };
+
+	static property_t property_from_string(const std::string& name);
+	static easing_t easing_from_string(const std::string& name);
+	static double ease(easing_t e, double t);
+
+	// returns the tween id, or 0 on failure. If after_id is non-zero, the tween
+	// waits for that tween to complete before starting from wherever the property is then.
+	int add_tween(DrawListElement* target, property_t property, double to, double seconds, easing_t easing, int after_id = 0);
+	bool set_callback(int id, luabridge::LuaRef callback, luabridge::LuaRef arg);
+	void stop_tweens(DrawListElement* target);
+
+	void animate_glyphs(DrawListElement* target, const std::vector<int>& glyphs, double interval, bool loop);
+	void stop_glyph_animation(DrawListElement* target);
+
+	// the element is going away, forget everything about it
+	void element_died(DrawListElement* target);
+
+	// called once per frame
+	void update(double dt);
+
+	int get_active_tweens() { return static_cast<int>(tweens.size()); }
+	int get_active_animations() { return static_cast<int>(animations.size()); }
+
+private:
+	// lets not have these copy constructed or assigned
+	TweenManager(const TweenManager&);
+	TweenManager& operator=(const TweenManager&);
+
+	struct Tween
+	{
+		int id;
+		int after_id;		// non-zero while waiting for another tween
+		DrawListElement* target;
+		property_t property;
+		easing_t easing;
+		bool started;
+		double from;
+		double to;
+		double elapsed;
+		double duration;
+	};
+	struct GlyphAnimation
+	{
+		DrawListElement* target;
+		std::vector<int> glyphs;
+		double interval;
+		double elapsed;
+		size_t index;
+		bool loop;
+	};
+	struct Callback
+	{
+		Callback(luabridge::LuaRef c, luabridge::LuaRef a) : callback(c), arg(a) {}
+		luabridge::LuaRef callback;
+		luabridge::LuaRef arg;
+	};
+
+	static double get_property(DrawListElement* target, property_t p);
+	static void set_property(DrawListElement* target, property_t p, double value);
+	void remove_tweens(DrawListElement* target);
+
+	std::vector<Tween> tweens;
+	std::vector<GlyphAnimation> animations;
+	std::map<int, Callback> callbacks;
+	std::vector<int> completed;
+	int next_id;
+};
+
+#endif /* TWEEN_H_ */
@@ -31,6 +31,7 @@
 #include "GameApplication.h"
 #include "Utilities.h"
 #include "AndroidInstaller.h"
+#include "AllocationTracker.h"
 //#include "GameToScreenMapping.h"
 //#include <stdio.h>
 //#include <iostream>
@@ -53,6 +54,9 @@ GameApplication* gulp_cpp;
 
 int main(int argc, char *argv[])
 {
+    // count SDL's allocations too - has to be before SDL allocates anything
+    AllocationTracker::install_sdl();
+
     Utilities::get_time_since_last_call();
 
     // initialize basic SDL - can't get paths to load files from app or prefs without it.